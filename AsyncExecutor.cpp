@@ -0,0 +1,158 @@
+#include <stdint.h>                 // for uint64_t
+#include <stdexcept>                // for logic_error
+
+#ifndef IS_WINDOWS_BUILD
+#include <sys/eventfd.h>            // for eventfd
+#include <unistd.h>                 // for read, write, close
+#endif
+
+#include "SqliteExceptions.h"       // for GenericSqliteException
+
+#include "AsyncExecutor.h"
+
+using namespace std;
+
+namespace SqliteOverlay
+{
+  AsyncExecutorBase::AsyncExecutorBase(unique_ptr<SqliteDatabase>&& _db)
+    :SingleConnectionWorker{std::move(_db), "AsyncExecutor"}
+  {
+#ifndef IS_WINDOWS_BUILD
+    evFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (evFd < 0)
+    {
+      throw std::runtime_error("AsyncExecutor: could not create eventfd");
+    }
+#endif
+
+    // sqlite3_interrupt() alone misses statements that start after the
+    // call, so running statements also poll the abort flag
+    db->setProgressHandler(ProgressCheckInterval, &AsyncExecutorBase::progressHandler, this);
+
+    startWorker([this]() { workerLoop(); });
+  }
+
+  //----------------------------------------------------------------------------
+
+  AsyncExecutorBase::~AsyncExecutorBase()
+  {
+    requestStop();
+    cancelPending();
+    interrupt();
+    joinWorker();
+
+    db->setProgressHandler(0, nullptr, nullptr);
+
+#ifndef IS_WINDOWS_BUILD
+    close(evFd);
+#endif
+  }
+
+  //----------------------------------------------------------------------------
+
+  void AsyncExecutorBase::interrupt()
+  {
+    lock_guard<mutex> lg{mtx};
+
+    if (!isJobRunning) return;
+
+    abortJob.store(true, memory_order_relaxed);
+    db->interrupt();
+  }
+
+  //----------------------------------------------------------------------------
+
+  int AsyncExecutorBase::progressHandler(void* ctx)
+  {
+    const AsyncExecutorBase* self = static_cast<const AsyncExecutorBase*>(ctx);
+    return self->abortJob.load(memory_order_relaxed) ? 1 : 0;
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t AsyncExecutorBase::processCompletions()
+  {
+#ifndef IS_WINDOWS_BUILD
+    // reset the counter; EAGAIN only means that there was nothing to read
+    uint64_t cnt;
+    [[maybe_unused]] auto rc = read(evFd, &cnt, sizeof(cnt));
+#endif
+
+    vector<coroutine_handle<>> ready;
+    {
+      lock_guard<mutex> lg{mtx};
+      ready.swap(completions);
+    }
+
+    // resume outside of the lock because the coroutines
+    // might submit new jobs right away
+    for (coroutine_handle<> h : ready) h.resume();
+
+    return ready.size();
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t AsyncExecutorBase::cancelPending()
+  {
+    deque<unique_ptr<Job>> cancelled;
+    {
+      lock_guard<mutex> lg{mtx};
+      cancelled.swap(queue);
+    }
+
+    for (auto& job : cancelled)
+    {
+      auto err = make_exception_ptr(GenericSqliteException(SQLITE_INTERRUPT, "AsyncExecutor: job cancelled before execution"));
+      job->cancel(err);
+    }
+
+    return cancelled.size();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void AsyncExecutorBase::notifyCompletion(coroutine_handle<> h)
+  {
+    if (h)
+    {
+      lock_guard<mutex> lg{mtx};
+      completions.push_back(h);
+    }
+
+#ifndef IS_WINDOWS_BUILD
+    const uint64_t one{1};
+    [[maybe_unused]] auto rc = write(evFd, &one, sizeof(one));
+#endif
+  }
+
+  //----------------------------------------------------------------------------
+
+  void AsyncExecutorBase::workerLoop()
+  {
+    while (true)
+    {
+      unique_ptr<Job> job;
+      {
+        unique_lock<mutex> lk{mtx};
+        workCv.wait(lk, [this]() { return isStopping || !queue.empty(); });
+
+        // pending jobs have already been cancelled if we're stopping
+        if (queue.empty()) return;
+
+        job = std::move(queue.front());
+        queue.pop_front();
+        isJobRunning = true;
+      }
+
+      job->run(*db);
+
+      lock_guard<mutex> lg{mtx};
+      isJobRunning = false;
+      abortJob.store(false, memory_order_relaxed);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+}
@@ -0,0 +1,329 @@
+#pragma once
+
+#include <stddef.h>                 // for size_t
+#include <atomic>                   // for atomic
+#include <coroutine>                // for coroutine_handle
+#include <exception>                // for exception_ptr, current_exception
+#include <functional>               // for function, invoke
+#include <future>                   // for future, promise
+#include <memory>                   // for unique_ptr, make_unique
+#include <mutex>                    // for mutex
+#include <optional>                 // for optional
+#include <string>                   // for string
+#include <type_traits>              // for invoke_result_t, is_void_v
+#include <utility>                  // for move, forward
+#include <variant>                  // for monostate
+#include <vector>                   // for vector
+
+#include "Defs.h"                   // for OpenMode, OpenOptions
+#include "SingleConnectionWorker.h" // for SingleConnectionWorker
+#include "SqliteDatabase.h"         // for SqliteDatabase
+
+namespace SqliteOverlay
+{
+  /** \brief A unit of work for the worker thread of an AsyncExecutor
+   */
+  struct AsyncExecutorJob
+  {
+    virtual ~AsyncExecutorJob() = default;
+
+    /** \brief Executes the job on the worker thread; must not throw */
+    virtual void run(SqliteDatabase& db) = 0;
+
+    /** \brief Fails a job that has never been started; must not throw */
+    virtual void cancel(std::exception_ptr err) = 0;
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Non-template part of AsyncExecutor: the worker thread,
+   * the job handling and the completion notification.
+   */
+  class AsyncExecutorBase : public SingleConnectionWorker<AsyncExecutorJob>
+  {
+  public:
+    /** \brief Dtor; cancels all pending jobs, interrupts the running job,
+     * waits for the worker thread and closes the connection
+     *
+     * \warning Coroutines that are still waiting for their result are not resumed
+     * anymore after the executor has been destroyed. Call `processCompletions()` until
+     * all awaited jobs have been completed before destroying the executor.
+     */
+    virtual ~AsyncExecutorBase();
+
+    /** \returns a non-blocking `eventfd` that becomes readable whenever a job has been
+     * completed or cancelled; -1 on platforms without `eventfd`.
+     *
+     * Add the descriptor to your `epoll` / `poll` set and call `processCompletions()`
+     * when it is readable. Do not read from or close the descriptor yourself.
+     *
+     * Test case: yes
+     *
+     */
+    int eventFd() const { return evFd; }
+
+    /** \brief Resets the `eventfd` and resumes all coroutines whose jobs have been
+     * completed; the coroutines run on the calling thread.
+     *
+     * \returns the number of resumed coroutines
+     *
+     * Test case: yes
+     *
+     */
+    size_t processCompletions();
+
+    /** \brief Aborts the currently running job; the job's current and all
+     * subsequent statements fail with a GenericSqliteException with `PrimaryResultCode::INTERRUPT`.
+     *
+     * The abort request sticks to the job until it returns, so it also
+     * hits a job that has been dequeued but hasn't started its first statement yet.
+     * Queued jobs are not affected; the call has no effect if no job is running.
+     *
+     * Test case: yes
+     *
+     */
+    void interrupt();
+
+    /** \brief Removes all jobs from the queue that have not been started yet;
+     * they fail with a GenericSqliteException with `PrimaryResultCode::INTERRUPT`.
+     *
+     * \returns the number of cancelled jobs
+     *
+     * Test case: yes
+     *
+     */
+    size_t cancelPending();
+
+  protected:
+    using Job = AsyncExecutorJob;
+
+    /** \brief Takes ownership of the connection and starts the worker thread
+     */
+    explicit AsyncExecutorBase(std::unique_ptr<SqliteDatabase>&& _db);
+
+    /** \brief Signals the completion of a job via the `eventfd`; if a coroutine
+     * handle is provided, it is resumed by the next call to `processCompletions()`
+     */
+    void notifyCompletion(std::coroutine_handle<> h);
+
+  private:
+    void workerLoop();
+
+    /** \brief The progress handler of the connection; aborts all statements while `abortJob` is set
+     */
+    static int progressHandler(void* ctx);
+
+    /** \brief Number of VM operations between two checks of `abortJob` */
+    static constexpr int ProgressCheckInterval = 100;
+
+    std::vector<std::coroutine_handle<>> completions;
+    bool isJobRunning{false};
+    std::atomic<bool> abortJob{false};   // set by interrupt(), cleared by the worker when the job has returned
+    int evFd{-1};
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Runs database work on a dedicated thread that owns its own connection
+   * so that the calling thread (e.g., an event loop) never blocks on SQLite.
+   *
+   * Work is submitted as a callable that receives the executor's connection,
+   * so everything that can be done with a `DB_CLASS` works asynchronously as well:
+   * plain `prepStatement()` / `step()`, DbTab, GenericView / GenericTable, ...
+   *
+   * ```
+   * AsyncExecutor<> ex{"my.db"};
+   *
+   * // via std::future
+   * std::future<int> f = ex.submit([](SqliteDatabase& db) {
+   *   return db.execScalarQuery<int>("SELECT count(*) FROM t1");
+   * });
+   *
+   * // via co_await; the coroutine is resumed in processCompletions()
+   * auto objs = co_await ex.schedule([](SqliteDatabase& db) {
+   *   return GenericTable<MyAdapter>{&db}.allObj();
+   * });
+   * ```
+   *
+   * Jobs are executed one after the other in the order of their submission.
+   * Every completed job signals the `eventFd()`, which can be polled by
+   * `epoll` based event loops.
+   *
+   * Exceptions thrown by a job are forwarded to the caller through the future
+   * or the `co_await` expression. Cancelled and interrupted jobs fail with
+   * a GenericSqliteException with `PrimaryResultCode::INTERRUPT`.
+   *
+   * \note Jobs must not return anything that refers to the executor's connection
+   * (e.g., SqlStatement, TabRow, views into a result row) because those objects would
+   * be used outside of the worker thread.
+   *
+   * \note All public methods are thread-safe.
+   */
+  template<class DB_CLASS = SqliteDatabase>
+  class AsyncExecutor : public AsyncExecutorBase
+  {
+    static_assert (std::is_base_of_v<SqliteDatabase, DB_CLASS>);
+
+  public:
+    /** \brief Ctor; opens the connection on the calling thread and starts the worker thread
+     *
+     * \throws GenericSqliteException incl. error code if anything goes wrong
+     * with SQLite when opening the connection
+     *
+     * Test case: yes
+     *
+     */
+    explicit AsyncExecutor(
+        const std::string& dbFilename,   ///< the name of the database file
+        OpenMode om = OpenMode::OpenExisting_RW,   ///< the opening mode for the connection
+        std::function<void(DB_CLASS&)> initFunc = nullptr,   ///< an optional function that is called for the new connection before the worker starts
+        const OpenOptions& openOptions = OpenOptions{}   ///< performance settings for the connection
+        )
+      :AsyncExecutorBase{openConnection<DB_CLASS>(dbFilename, om, initFunc, openOptions)} {}
+
+    /** \brief Queues a callable for execution on the worker thread
+     *
+     * \throws std::logic_error if the executor is shutting down
+     *
+     * \returns a future for the callable's return value or exception
+     *
+     * Test case: yes
+     *
+     */
+    template<class F>
+    auto submit(
+        F&& f   ///< a callable that takes a `DB_CLASS&`
+        ) -> std::future<std::invoke_result_t<F, DB_CLASS&>>
+    {
+      using R = std::invoke_result_t<F, DB_CLASS&>;
+
+      auto job = std::make_unique<FutureJob<R, std::decay_t<F>>>(this, std::forward<F>(f));
+      auto fut = job->promise.get_future();
+      enqueue(std::move(job));
+
+      return fut;
+    }
+
+    /** \brief An awaitable that executes a callable on the worker thread when it is `co_await`ed
+     */
+    template<class F>
+    class Awaitable
+    {
+    public:
+      using ResultType = std::invoke_result_t<F, DB_CLASS&>;
+
+      Awaitable(AsyncExecutor* _ex, F&& _f)
+        :ex{_ex}, f{std::move(_f)} {}
+
+      bool await_ready() const noexcept { return false; }
+
+      void await_suspend(std::coroutine_handle<> h)
+      {
+        ex->enqueue(std::make_unique<AwaitJob>(this, h));
+      }
+
+      ResultType await_resume()
+      {
+        if (err) std::rethrow_exception(err);
+        if constexpr (!std::is_void_v<ResultType>) return std::move(*result);
+      }
+
+    private:
+      using StorageType = std::conditional_t<std::is_void_v<ResultType>, std::monostate, ResultType>;
+
+      struct AwaitJob : public Job
+      {
+        AwaitJob(Awaitable* _aw, std::coroutine_handle<> _h)
+          :aw{_aw}, h{_h} {}
+
+        void run(SqliteDatabase& db) override
+        {
+          try
+          {
+            if constexpr (std::is_void_v<ResultType>)
+            {
+              std::invoke(aw->f, static_cast<DB_CLASS&>(db));
+              aw->result.emplace();
+            } else {
+              aw->result.emplace(std::invoke(aw->f, static_cast<DB_CLASS&>(db)));
+            }
+          }
+          catch (...)
+          {
+            aw->err = std::current_exception();
+          }
+          aw->ex->notifyCompletion(h);
+        }
+
+        void cancel(std::exception_ptr e) override
+        {
+          aw->err = e;
+          aw->ex->notifyCompletion(h);
+        }
+
+        Awaitable* aw;
+        std::coroutine_handle<> h;
+      };
+
+      AsyncExecutor* ex;
+      F f;
+      std::optional<StorageType> result;
+      std::exception_ptr err;
+    };
+
+    /** \brief Wraps a callable into an awaitable; the callable is queued when the
+     * result is `co_await`ed and the awaiting coroutine is resumed on the thread that
+     * calls `processCompletions()` after the callable has been executed.
+     *
+     * \throws std::logic_error (at `co_await`) if the executor is shutting down
+     *
+     * Test case: yes
+     *
+     */
+    template<class F>
+    Awaitable<std::decay_t<F>> schedule(
+        F&& f   ///< a callable that takes a `DB_CLASS&`
+        )
+    {
+      return Awaitable<std::decay_t<F>>{this, std::decay_t<F>{std::forward<F>(f)}};
+    }
+
+  protected:
+    template<typename R, class F>
+    struct FutureJob : public Job
+    {
+      FutureJob(AsyncExecutor* _ex, F _f)
+        :ex{_ex}, f{std::move(_f)} {}
+
+      void run(SqliteDatabase& db) override
+      {
+        try
+        {
+          if constexpr (std::is_void_v<R>)
+          {
+            std::invoke(f, static_cast<DB_CLASS&>(db));
+            promise.set_value();
+          } else {
+            promise.set_value(std::invoke(f, static_cast<DB_CLASS&>(db)));
+          }
+        }
+        catch (...)
+        {
+          promise.set_exception(std::current_exception());
+        }
+        ex->notifyCompletion(nullptr);
+      }
+
+      void cancel(std::exception_ptr e) override
+      {
+        promise.set_exception(e);
+        ex->notifyCompletion(nullptr);
+      }
+
+      AsyncExecutor* ex;
+      F f;
+      std::promise<R> promise;
+    };
+  };
+
+}
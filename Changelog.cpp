@@ -1,22 +1,319 @@
 
+#include <string.h>      // for strcmp
+#include <algorithm>     // for find, stable_sort
+#include <stdexcept>     // for invalid_argument
+#include <tuple>         // for tie
+
+#ifndef IS_WINDOWS_BUILD
+#include <unistd.h>      // for write
+#endif
+
 #include "Changelog.h"
 
 namespace SqliteOverlay
 {
 
-  void changeLogCallback(void* customPtr, int modType, const char* _dbName, const char* _tabName, sqlite3_int64 id)
+  ChangeLogBuffer::ChangeLogBuffer()
+    :tail{new Chunk}, head{tail}
+  {
+  }
+
+  //----------------------------------------------------------------------------
+
+  ChangeLogBuffer::~ChangeLogBuffer()
+  {
+    Chunk* c = head;
+    while (c != nullptr)
+    {
+      Chunk* nxt = c->next.load(std::memory_order_relaxed);
+      delete c;
+      c = nxt;
+    }
+    delete spare.load(std::memory_order_relaxed);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ChangeLogBuffer::append(int modType, const char* dbName, const char* tabName, int64_t rowId)
+  {
+    const uint32_t tabId = intern(tabNames, tabName);
+    if (!isAccepted(tabId)) return;
+
+    size_t n = tail->nCommitted.load(std::memory_order_relaxed);
+    if (n == ChunkSize)
+    {
+      // take the recycled chunk, if any, and link it to the full one;
+      // the consumer doesn't leave a full chunk before `next` is set
+      Chunk* c = spare.exchange(nullptr, std::memory_order_acquire);
+      if (c == nullptr) c = new Chunk;
+      tail->next.store(c, std::memory_order_release);
+      tail = c;
+      n = 0;
+    }
+
+    CompactChangeLogEntry& e = tail->entries[n];
+    e.rowId = rowId;
+    e.tabId = tabId;
+    e.dbId = static_cast<uint16_t>(intern(dbNames, dbName));
+    e.action = static_cast<RowChangeAction>(modType);
+
+    // publish the entry
+    tail->nCommitted.store(n + 1, std::memory_order_release);
+
+    // sequentially consistent ordering of `nProduced` and `nWaiters` guarantees
+    // that either we see the waiter or the waiter sees the new entry
+    nProduced.store(nProduced.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+    if (nWaiters.load(std::memory_order_seq_cst) > 0) wakeWaiters();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ChangeLogBuffer::wakeWaiters()
+  {
+    // notifying under the lock prevents lost wake-ups for waiters
+    // that are between their predicate check and the actual wait
+    std::lock_guard<std::mutex> lg{waitMutex};
+
+    waitCv.notify_all();
+
+#ifndef IS_WINDOWS_BUILD
+    for (int fd : wakeFds)
+    {
+      const uint64_t one{1};
+      [[maybe_unused]] auto rc = write(fd, &one, sizeof(one));
+    }
+#endif
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool ChangeLogBuffer::waitForEntries(std::chrono::milliseconds timeout)
+  {
+    nWaiters.fetch_add(1, std::memory_order_seq_cst);
+
+    bool result;
+    {
+      std::unique_lock<std::mutex> lk{waitMutex};
+      result = waitCv.wait_for(lk, timeout, [this]() { return size() > 0; });
+    }
+
+    nWaiters.fetch_sub(1, std::memory_order_seq_cst);
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ChangeLogBuffer::addWakeFd(int fd)
+  {
+    {
+      std::lock_guard<std::mutex> lg{waitMutex};
+      wakeFds.push_back(fd);
+    }
+
+    nWaiters.fetch_add(1, std::memory_order_seq_cst);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ChangeLogBuffer::removeWakeFd(int fd)
+  {
+    nWaiters.fetch_sub(1, std::memory_order_seq_cst);
+
+    std::lock_guard<std::mutex> lg{waitMutex};
+    auto it = std::find(wakeFds.begin(), wakeFds.end(), fd);
+    if (it != wakeFds.end()) wakeFds.erase(it);
+  }
+
+  //----------------------------------------------------------------------------
+
+  uint32_t ChangeLogBuffer::intern(NameCache& nc, const char* name)
+  {
+    // fast path: consecutive changes usually affect the same table
+    if ((nc.lastHit < nc.known.size()) && (strcmp(nc.known[nc.lastHit].first.c_str(), name) == 0))
+    {
+      return nc.known[nc.lastHit].second;
+    }
+
+    for (size_t i = 0; i < nc.known.size(); ++i)
+    {
+      if (strcmp(nc.known[i].first.c_str(), name) == 0)
+      {
+        nc.lastHit = i;
+        return nc.known[i].second;
+      }
+    }
+
+    // a new name; this is the only case that allocates memory or takes a lock
+    const uint32_t id = static_cast<uint32_t>(nc.known.size());
+    nc.known.emplace_back(name, id);
+    nc.lastHit = id;
+    std::lock_guard<std::mutex> lg{nameMutex};
+    nc.names.emplace_back(name);
+
+    return id;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void ChangeLogBuffer::setTableFilter(const std::vector<std::string>& tabNames)
+  {
+    std::lock_guard<std::mutex> lg{nameMutex};
+
+    filterNames = tabNames;
+    filterGen.fetch_add(1, std::memory_order_release);
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool ChangeLogBuffer::isAccepted(uint32_t tabId)
+  {
+    if (filterGen.load(std::memory_order_acquire) != producerFilterGen)
+    {
+      std::lock_guard<std::mutex> lg{nameMutex};
+
+      producerFilter = filterNames;
+      producerFilterGen = filterGen.load(std::memory_order_relaxed);
+      tabVerdict.clear();
+    }
+
+    if (producerFilter.empty()) return true;
+
+    // the verdict is evaluated only once per table
+    if (tabId >= tabVerdict.size()) tabVerdict.resize(tabId + 1, 0);
+    if (tabVerdict[tabId] == 0)
+    {
+      const std::string& tn = tabNames.known[tabId].first;
+      const bool isListed = (std::find(producerFilter.begin(), producerFilter.end(), tn) != producerFilter.end());
+      tabVerdict[tabId] = isListed ? 1 : 2;
+    }
+
+    return (tabVerdict[tabId] == 1);
+  }
+
+  //----------------------------------------------------------------------------
+
+  template<class Func>
+  size_t ChangeLogBuffer::consume(Func&& f)
+  {
+    size_t cnt{0};
+
+    while (true)
+    {
+      const size_t n = head->nCommitted.load(std::memory_order_acquire);
+      if (readPos < n)
+      {
+        f(head->entries.data() + readPos, head->entries.data() + n);
+        cnt += n - readPos;
+        readPos = n;
+      }
+      if (readPos < ChunkSize) break;
+
+      Chunk* nxt = head->next.load(std::memory_order_acquire);
+      if (nxt == nullptr) break;
+
+      // the producer won't touch the old chunk anymore; hand it back for reuse
+      Chunk* old = head;
+      old->nCommitted.store(0, std::memory_order_relaxed);
+      old->next.store(nullptr, std::memory_order_relaxed);
+      delete spare.exchange(old, std::memory_order_acq_rel);
+
+      head = nxt;
+      readPos = 0;
+    }
+
+    nConsumed.fetch_add(cnt, std::memory_order_relaxed);
+
+    return cnt;
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t ChangeLogBuffer::drain(std::vector<CompactChangeLogEntry>& dst)
   {
-    if (customPtr == nullptr) return;
-    ChangeLogCallbackContext* ctx = reinterpret_cast<ChangeLogCallbackContext*>(customPtr);
+    return consume([&dst](const CompactChangeLogEntry* first, const CompactChangeLogEntry* last) {
+      dst.insert(dst.end(), first, last);
+    });
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t ChangeLogBuffer::clear()
+  {
+    return consume([](const CompactChangeLogEntry*, const CompactChangeLogEntry*) {});
+  }
 
-    const std::string dbName{_dbName};
+  //----------------------------------------------------------------------------
+
+  std::string ChangeLogBuffer::dbName(uint16_t dbId) const
+  {
+    std::lock_guard<std::mutex> lg{nameMutex};
 
-    std::lock_guard<std::mutex> lg{*(ctx->logMutex)};
+    if (dbId >= dbNames.names.size())
+    {
+      throw std::invalid_argument("ChangeLogBuffer: unknown database ID");
+    }
 
-    ctx->logPtr->emplace_back(modType, dbName, std::string{_tabName}, id);
+    return dbNames.names[dbId];
   }
 
   //----------------------------------------------------------------------------
 
+  std::string ChangeLogBuffer::tabName(uint32_t tabId) const
+  {
+    std::lock_guard<std::mutex> lg{nameMutex};
+
+    if (tabId >= tabNames.names.size())
+    {
+      throw std::invalid_argument("ChangeLogBuffer: unknown table ID");
+    }
+
+    return tabNames.names[tabId];
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t coalesceChangeLog(std::vector<CompactChangeLogEntry>& log, size_t firstIdx)
+  {
+    if (firstIdx >= log.size()) return 0;
+
+    auto isLess = [](const CompactChangeLogEntry& a, const CompactChangeLogEntry& b) {
+      return std::tie(a.dbId, a.tabId, a.rowId) < std::tie(b.dbId, b.tabId, b.rowId);
+    };
+
+    // a stable sort keeps the chronological order of the changes per row
+    const auto first = log.begin() + firstIdx;
+    std::stable_sort(first, log.end(), isLess);
+
+    auto out = first;
+    auto it = first;
+    while (it != log.end())
+    {
+      auto grpEnd = it + 1;
+      while ((grpEnd != log.end()) && !isLess(*it, *grpEnd)) ++grpEnd;
+
+      // only the state before the first and after the last change matters
+      const bool existedBefore = (it->action != RowChangeAction::Insert);
+      const bool existsAfter = ((grpEnd - 1)->action != RowChangeAction::Delete);
+      if (existedBefore || existsAfter)
+      {
+        *out = *it;
+        if (!existedBefore)
+        {
+          out->action = RowChangeAction::Insert;
+        } else {
+          out->action = existsAfter ? RowChangeAction::Update : RowChangeAction::Delete;
+        }
+        ++out;
+      }
+
+      it = grpEnd;
+    }
+    log.erase(out, log.end());
+
+    return log.size() - firstIdx;
+  }
+
+  //----------------------------------------------------------------------------
 
 }
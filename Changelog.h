@@ -1,8 +1,15 @@
 #pragma once
 
 #include <stddef.h>   // for size_t
+#include <stdint.h>   // for int64_t, uint16_t, uint32_t, uint8_t
+#include <array>      // for array
+#include <atomic>     // for atomic
+#include <chrono>     // for milliseconds
+#include <condition_variable>  // for condition_variable
+#include <deque>      // for deque
 #include <mutex>      // for mutex
 #include <string>     // for string
+#include <utility>    // for pair
 #include <vector>     // for vector
 
 #include <sqlite3.h>  // for SQLITE_DELETE, SQLITE_INSERT, SQLITE_UPDATE
@@ -12,7 +19,7 @@ namespace SqliteOverlay
   /** \brief An enum that maps between SQLite constants for row modifications
    * to enum values.
    */
-  enum class RowChangeAction
+  enum class RowChangeAction : uint8_t
   {
     Insert = SQLITE_INSERT,
     Update = SQLITE_UPDATE,
@@ -21,6 +28,19 @@ namespace SqliteOverlay
 
   //----------------------------------------------------------------------------
 
+  /** \brief The kinds of database modifications that `SqliteDatabase::waitForChanges()`
+   * can wait for; the values can be used as bit flags.
+   */
+  enum class ChangeSource
+  {
+    None = 0,   ///< no changes
+    Local = 1,   ///< new entries in the changelog of the connection
+    External = 2,   ///< changes committed by other connections or processes
+    Any = 3   ///< local and external changes
+  };
+
+  //----------------------------------------------------------------------------
+
   /** \brief A struct that encapsulates change information that SQLite
    * optionally provides via a callback function whenever the database
    * is modified.
@@ -67,28 +87,170 @@ namespace SqliteOverlay
 
   //----------------------------------------------------------------------------
 
-  /** \brief A struct that is used by the built-in `changeLogCallback`
-   * to get access to the internal change log.
+  /** \brief A fixed-size changelog entry with interned database and table names
+   *
+   * The IDs can be resolved with `SqliteDatabase::changeLogDbName()` and
+   * `SqliteDatabase::changeLogTabName()`; they remain valid for
+   * the lifetime of the connection.
    */
-  struct ChangeLogCallbackContext
+  struct CompactChangeLogEntry
   {
-    std::mutex* logMutex;   ///< pointer to a mutex that must be acquired before accessing the changelog
-    ChangeLogList* logPtr;   ///< pointer to the actual changelog
+    int64_t rowId;   ///< the rowid of the affected row
+    uint32_t tabId;   ///< the interned name of the affected table
+    uint16_t dbId;   ///< the interned name of the affected database
+    RowChangeAction action;   ///< the kind of change (insert, update, delete)
   };
 
   //----------------------------------------------------------------------------
 
-  /** \brief A built-in callback function for storing all database modifications
-   * in a changelog.
+  /** \brief The storage behind the built-in changelog.
+   *
+   * The producer (`append()`, called by the update hook of the connection) appends
+   * fixed-size entries to a list of chunks without taking any lock and without
+   * allocating memory, except for a new chunk every `ChunkSize` entries and for
+   * the first occurrence of a database or table name. Only if a thread waits for new entries (`waitForEntries()`,
+   * `addWakeFd()`), the producer briefly takes a lock to wake it up.
+   *
+   * There is exactly one producer at a time because SQLite serializes all
+   * calls of the update hook of a connection. Readers (`drain()`, `clear()`, `size()`)
+   * may run concurrently to the producer but have to be serialized among each other
+   * by the caller.
+   */
+  class ChangeLogBuffer
+  {
+  public:
+    static constexpr size_t ChunkSize{4096};
+
+    ChangeLogBuffer();
+    ~ChangeLogBuffer();
+
+    /** \brief Disabled copy ctor */
+    ChangeLogBuffer(const ChangeLogBuffer& other) = delete;
+
+    /** \brief Disabled copy assignment */
+    ChangeLogBuffer& operator=(const ChangeLogBuffer& other) = delete;
+
+    /** \brief Restricts the capture to a set of tables; an empty list captures
+     * all tables. Takes effect for the next change; may be called concurrently
+     * to the producer.
+     */
+    void setTableFilter(const std::vector<std::string>& tabNames);
+
+    /** \brief Appends an entry unless it is excluded by the table filter; for the producer only */
+    void append(int modType, const char* dbName, const char* tabName, int64_t rowId);
+
+    /** \brief Moves all entries to the end of `dst` */
+    size_t drain(std::vector<CompactChangeLogEntry>& dst);
+
+    /** \brief Discards all entries */
+    size_t clear();
+
+    /** \returns the number of entries in the log */
+    size_t size() const { return nProduced.load(std::memory_order_seq_cst) - nConsumed.load(std::memory_order_relaxed); }
+
+    /** \brief Blocks until the log contains at least one entry or until the timeout has expired
+     *
+     * \returns `true` if the log is not empty
+     */
+    bool waitForEntries(std::chrono::milliseconds timeout);
+
+    /** \brief Registers an eventfd that is signaled whenever an entry is appended
+     * while the fd is registered; for waiters that have to poll for other events as well
+     */
+    void addWakeFd(int fd);
+
+    /** \brief Unregisters an eventfd that has been registered with `addWakeFd()` */
+    void removeWakeFd(int fd);
+
+    /** \returns the database name for an ID
+     *
+     * \throws std::invalid_argument if the ID is unknown
+     */
+    std::string dbName(uint16_t dbId) const;
+
+    /** \returns the table name for an ID
+     *
+     * \throws std::invalid_argument if the ID is unknown
+     */
+    std::string tabName(uint32_t tabId) const;
+
+  private:
+    struct Chunk
+    {
+      std::array<CompactChangeLogEntry, ChunkSize> entries;
+      std::atomic<size_t> nCommitted{0};
+      std::atomic<Chunk*> next{nullptr};
+    };
+
+    // interns a name; the producer keeps a private copy of the
+    // name list so that lookups don't need a lock
+    struct NameCache
+    {
+      std::vector<std::pair<std::string, uint32_t>> known;   // producer only
+      size_t lastHit{0};   // producer only
+      std::deque<std::string> names;   // shared, guarded by `nameMutex`
+    };
+    uint32_t intern(NameCache& nc, const char* name);
+
+    // the table filter; the producer works on a private copy that
+    // is refreshed whenever the generation counter changes
+    bool isAccepted(uint32_t tabId);
+    std::vector<std::string> filterNames;   // shared, guarded by `nameMutex`
+    std::atomic<uint32_t> filterGen{0};
+    uint32_t producerFilterGen{0};   // producer only
+    std::vector<std::string> producerFilter;   // producer only
+    std::vector<uint8_t> tabVerdict;   // producer only; per table ID: 0 = unknown, 1 = accepted, 2 = rejected
+
+    template<class Func>
+    size_t consume(Func&& f);
+
+    // producer side
+    Chunk* tail;
+    NameCache dbNames;
+    NameCache tabNames;
+    std::atomic<size_t> nProduced{0};
+
+    // consumer side
+    Chunk* head;
+    size_t readPos{0};
+    std::atomic<size_t> nConsumed{0};   // atomic because waiters read it without the consumer lock
+
+    // waiter notification; the producer only touches the mutex if there is a waiter
+    void wakeWaiters();
+    std::atomic<size_t> nWaiters{0};
+    std::mutex waitMutex;
+    std::condition_variable waitCv;
+    std::vector<int> wakeFds;   // guarded by `waitMutex`
+
+    // a single recycled chunk that is handed from the consumer back to the producer
+    std::atomic<Chunk*> spare{nullptr};
+
+    mutable std::mutex nameMutex;
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Reduces a changelog to the net effect per row.
+   *
+   * The entries starting at `firstIdx` are sorted by (database ID, table ID, rowid)
+   * and all entries for the same row are merged into a single one:
+   *
+   *   * insert + updates --> insert
+   *   * insert + ... + delete --> (nothing)
+   *   * updates --> update
+   *   * updates + delete --> delete
+   *   * delete + insert (re-used rowid) --> update
+   *
+   * The entries before `firstIdx` remain untouched.
+   *
+   * \returns the number of entries from `firstIdx` on after coalescing
+   *
+   * Test case: yes
    *
-   * The function signature is defined by SQLite
    */
-  void changeLogCallback(
-      void* customPtr,   ///< a custom pointer that can be set during callback setup
-      int modType,   ///< the kind of modification as per sqlite3.h
-      char const * _dbName,   ///< the affected database (e.g., "main")
-      char const* _tabName,   ///< the affected table
-      sqlite3_int64 id   /// the affected row
+  size_t coalesceChangeLog(
+      std::vector<CompactChangeLogEntry>& log,   ///< the log that is modified in place
+      size_t firstIdx = 0   ///< the index of the first entry that shall be coalesced
       );
 
   //----------------------------------------------------------------------------
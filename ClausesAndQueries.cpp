@@ -16,6 +16,13 @@ using namespace std;
 namespace SqliteOverlay {
 
   SqlStatement ColumnValueClause::getInsertStmt(const SqliteDatabase& db, const string& tabName) const
+  {
+    return createStatementAndBindValuesToPlaceholders(db, getInsertSql(tabName));
+  }
+
+  //----------------------------------------------------------------------------
+
+  string ColumnValueClause::getInsertSql(const string& tabName) const
   {
     if (tabName.empty())
     {
@@ -45,7 +52,7 @@ namespace SqliteOverlay {
       sql += ") VALUES (" + params + ")";
     }
 
-    return createStatementAndBindValuesToPlaceholders(db, sql);
+    return sql;
   }
 
   //----------------------------------------------------------------------------
@@ -58,6 +65,7 @@ namespace SqliteOverlay {
     }
 
     string sql;
+    int nPlaceholders = 0;
     for (const ColValInfo& curCol : colVals)
     {
       if (!(sql.empty()))
@@ -66,12 +74,24 @@ namespace SqliteOverlay {
       }
 
       sql += curCol.colName + "=";
-      sql += (curCol.type == ColValType::Null) ? "NULL" : "?";
+      if (curCol.type == ColValType::Null)
+      {
+        sql += "NULL";
+      } else {
+        sql += "?";
+        ++nPlaceholders;
+      }
     }
+
+    // the row ID is bound as a parameter as well so that
+    // the statement text is identical for all rows
     sql = "UPDATE " + tabName + " SET " + sql;
-    sql += " WHERE rowid=" + to_string(rowId);
+    sql += " WHERE rowid=?";
 
-    return createStatementAndBindValuesToPlaceholders(db, sql);
+    SqlStatement stmt = createStatementAndBindValuesToPlaceholders(db, sql);
+    stmt.bind(nPlaceholders + 1, rowId);
+
+    return stmt;
   }
 
   //----------------------------------------------------------------------------
@@ -83,6 +103,25 @@ namespace SqliteOverlay {
 
   //----------------------------------------------------------------------------
 
+  bool ColumnValueClause::hasSameInsertColumns(const ColumnValueClause& other) const
+  {
+    if (colVals.size() != other.colVals.size()) return false;
+
+    for (size_t i = 0; i < colVals.size(); ++i)
+    {
+      const ColValInfo& a = colVals[i];
+      const ColValInfo& b = other.colVals[i];
+
+      // NULL values are part of the SQL text, all others are placeholders
+      if (a.colName != b.colName) return false;
+      if ((a.type == ColValType::Null) != (b.type == ColValType::Null)) return false;
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+
   bool CommonClause::isEmpty() const
   {
     return colVals.empty();
@@ -248,9 +287,17 @@ namespace SqliteOverlay {
   SqlStatement CommonClause::createStatementAndBindValuesToPlaceholders(const SqliteDatabase& db, const string& sql) const
   {
     SqlStatement stmt = db.prepStatement(sql);
+    bindValuesToPlaceholders(stmt);
 
+    return stmt;
+  }
+
+  //----------------------------------------------------------------------------
+
+  int CommonClause::bindValuesToPlaceholders(SqlStatement& stmt, int firstPlaceholderIdx) const
+  {
     // bind the actual column values to the placeholders
-    int curPlaceholderIdx = 1;   // leftmost placeholder is at position 1
+    int curPlaceholderIdx = firstPlaceholderIdx;
     for (const ColValInfo& curCol : colVals)
     {
       // NULL or NOT NULL has to be handled directly as literal value when
@@ -282,7 +329,7 @@ namespace SqliteOverlay {
       ++curPlaceholderIdx;
     }
 
-    return stmt;
+    return curPlaceholderIdx;
   }
 
 
@@ -158,6 +158,21 @@ namespace SqliteOverlay {
         const std::string& sql   ///< the SQL statement as text with placeholders
         ) const;
 
+    /** \brief Binds all column values (except NULL / NOT NULL) to consecutive
+     * placeholders of an existing statement
+     *
+     * \throws GenericSqliteException incl. error code if anything goes wrong
+     *
+     * \returns the index of the next unused placeholder
+     *
+     * Test case: implicitly by all statements created from clauses
+     *
+     */
+    int bindValuesToPlaceholders(
+        SqlStatement& stmt,   ///< the statement with the placeholders
+        int firstPlaceholderIdx = 1   ///< the 1-based index of the placeholder for the first value
+        ) const;
+
   protected:
     enum ColValType
     {
@@ -217,6 +232,18 @@ namespace SqliteOverlay {
         const std::string& tabName   ///< name of the table in which the new row should be inserted
         ) const;
 
+    /** \returns the text of the INSERT statement that is used by `getInsertStmt()`;
+     * clauses with the same columns in the same order yield identical statements
+     *
+     * \throws std::invalid argument if the table name is empty
+     *
+     * Test case: implicitly by `getInsertStmt()`
+     *
+     */
+    std::string getInsertSql(
+        const std::string& tabName   ///< name of the table in which the new row should be inserted
+        ) const;
+
     /** \brief Constructs an UPDATE statement for a given combination of
      * database, table name and row ID; the UPDATE statement re-assigns
      * the previously provided column values.
@@ -242,6 +269,16 @@ namespace SqliteOverlay {
     /** \returns `true` if this objects contains any column definitions at all */
     bool hasColumns() const;
 
+    /** \returns `true` if `getInsertSql()` yields the same SQL text for this
+     * and the other clause (same table name provided), without constructing the text
+     *
+     * Test case: implicitly by `DbTab::insertRows()`
+     *
+     */
+    bool hasSameInsertColumns(
+        const ColumnValueClause& other   ///< the clause to compare with
+        ) const;
+
   private:
 
   };
@@ -0,0 +1,41 @@
+#include <stdexcept>                // for invalid_argument
+
+#include "SqliteExceptions.h"       // for InvalidColumnException
+
+#include "ColumnarFetch.h"
+
+using namespace std;
+
+namespace SqliteOverlay
+{
+  ColumnarReaderBase::ColumnarReaderBase(SqlStatement&& _stmt, int nCols, size_t chunkSize)
+    :stmt{std::move(_stmt)}, nChunk{chunkSize}
+  {
+    if (chunkSize == 0)
+    {
+      throw std::invalid_argument("ColumnarReader: chunk size must be positive");
+    }
+
+    // sqlite3_column_count() works before the first step
+    if (sqlite3_column_count(stmt.stmt) < nCols)
+    {
+      throw InvalidColumnException("ColumnarReader: statement yields fewer columns than requested");
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  string ColumnarReaderBase::getString_NoGuards(int colId) const
+  {
+    // call sqlite3_column_text() BEFORE sqlite3_column_bytes() because
+    // the former might convert the value and thus change its length
+    const char* const txt = reinterpret_cast<const char*>(sqlite3_column_text(stmt.stmt, colId));
+    const int nBytes = sqlite3_column_bytes(stmt.stmt, colId);
+    if ((txt == nullptr) || (nBytes <= 0)) return string{};
+
+    return string{txt, static_cast<size_t>(nBytes)};
+  }
+
+  //----------------------------------------------------------------------------
+
+}
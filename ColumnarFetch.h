@@ -0,0 +1,383 @@
+#pragma once
+
+#include <stddef.h>                 // for size_t
+#include <stdint.h>                 // for int64_t, uint64_t
+#include <algorithm>                // for min
+#include <array>                    // for array
+#include <bit>                      // for popcount
+#include <limits>                   // for numeric_limits
+#include <optional>                 // for optional
+#include <stdexcept>                // for invalid_argument
+#include <string>                   // for string
+#include <tuple>                    // for tuple, get
+#include <type_traits>              // for is_same_v, is_arithmetic_v
+#include <utility>                  // for pair, index_sequence
+#include <vector>                   // for vector
+
+#include <sqlite3.h>                // for sqlite3_column_int64, ...
+
+#include "Defs.h"                   // for ColumnDataType
+#include "SqlStatement.h"           // for SqlStatement
+
+namespace SqliteOverlay
+{
+  /** \brief Default number of rows that a ColumnarReader fetches per chunk
+   */
+  constexpr size_t DefaultColumnarChunkSize{4096};
+
+  /** \brief The values of a single result column in one contiguous vector
+   * plus a bitmap that marks NULL cells.
+   *
+   * NULL cells are stored as value-initialized `T` (0, 0.0 or an empty string)
+   * so that reductions like `columnSum()` can run over `values` without
+   * any branches.
+   */
+  template<typename T>
+  struct ColumnBuffer
+  {
+    static_assert (std::is_same_v<T, int64_t> || std::is_same_v<T, double> || std::is_same_v<T, std::string>,
+                   "ColumnBuffer supports only int64_t, double and std::string");
+
+    std::vector<T> values;   ///< one entry per row
+    std::vector<uint64_t> nullBits;   ///< bit `i % 64` of word `i / 64` is set if row `i` is NULL
+    size_t nNull{0};   ///< number of NULL cells
+
+    /** \returns the number of rows in the buffer */
+    size_t size() const { return values.size(); }
+
+    /** \returns `true` if the given row contains NULL */
+    bool isNull(size_t row) const { return ((nullBits[row / 64] >> (row % 64)) & 1) != 0; }
+
+    /** \returns the number of rows that are not NULL */
+    size_t countNonNull() const { return values.size() - nNull; }
+
+    /** \brief Appends a non-NULL value */
+    void push(T&& v)
+    {
+      if ((values.size() % 64) == 0) nullBits.push_back(0);
+      values.push_back(std::move(v));
+    }
+
+    /** \brief Appends a NULL cell */
+    void pushNull()
+    {
+      const size_t row = values.size();
+      if ((row % 64) == 0) nullBits.push_back(0);
+      nullBits.back() |= (uint64_t{1} << (row % 64));
+      values.emplace_back();
+      ++nNull;
+    }
+
+    /** \brief Removes all rows but keeps the allocated memory */
+    void clear()
+    {
+      values.clear();
+      nullBits.clear();
+      nNull = 0;
+    }
+
+    /** \brief Pre-allocates memory for `n` rows */
+    void reserve(size_t n)
+    {
+      values.reserve(n);
+      nullBits.reserve((n + 63) / 64);
+    }
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Maps a column's declared data type to the C++ type that is used in a ColumnBuffer
+   */
+  template<ColumnDataType t>
+  struct ColumnarTypeFor
+  {
+    static_assert (t == ColumnDataType::Integer || t == ColumnDataType::Float || t == ColumnDataType::Text,
+                   "Only INTEGER, REAL and TEXT columns can be fetched in columnar mode");
+    using type = std::conditional_t<t == ColumnDataType::Integer, int64_t,
+                                    std::conditional_t<t == ColumnDataType::Float, double, std::string>>;
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Non-template part of ColumnarReader that does the actual column access
+   */
+  class ColumnarReaderBase
+  {
+  public:
+    /** \returns the maximum number of rows per chunk */
+    size_t chunkSize() const { return nChunk; }
+
+    /** \returns the total number of rows that have been fetched so far */
+    size_t totalRows() const { return nTotal; }
+
+    /** \returns `true` if the statement has been fully executed and no more chunks will follow */
+    bool isDone() const { return done; }
+
+  protected:
+    /** \brief Takes ownership of a prepared (and bound) statement that has not been stepped yet
+     *
+     * \throws std::invalid_argument if `chunkSize` is zero
+     *
+     * \throws InvalidColumnException if the statement yields less than `nCols` columns
+     */
+    ColumnarReaderBase(
+        SqlStatement&& _stmt,   ///< the statement that provides the data
+        int nCols,   ///< the number of columns that will be fetched
+        size_t chunkSize   ///< the maximum number of rows per chunk
+        );
+
+    bool step()
+    {
+      if (done) return false;
+      done = !stmt.dataStep();
+      return !done;
+    }
+
+    bool isNull_NoGuards(int colId) const { return (sqlite3_column_type(stmt.stmt, colId) == SQLITE_NULL); }
+    int64_t getInt64_NoGuards(int colId) const { return sqlite3_column_int64(stmt.stmt, colId); }
+    double getDouble_NoGuards(int colId) const { return sqlite3_column_double(stmt.stmt, colId); }
+    std::string getString_NoGuards(int colId) const;
+
+    SqlStatement stmt;
+    size_t nChunk;
+    size_t nTotal{0};
+    bool done{false};
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Fetches the result of a SELECT statement in chunks of rows and stores
+   * each chunk in one ColumnBuffer per result column ("struct of arrays").
+   *
+   * The i-th type parameter determines the C++ type of the i-th result column and
+   * must be `int64_t`, `double` or `std::string`. Values are converted by SQLite
+   * if necessary, just like with `sqlite3_column_int64()` and friends.
+   *
+   * ```
+   * ColumnarReader<int64_t, double> rd{db.prepStatement("SELECT i, f FROM t1")};
+   * while (rd.nextChunk() > 0)
+   * {
+   *   total += columnSum(rd.column<1>());
+   * }
+   * ```
+   *
+   * The buffers are reused for all chunks, so there are no allocations after
+   * the first chunk (except for string contents).
+   *
+   * Test case: yes
+   */
+  template<typename ... Ts>
+  class ColumnarReader : public ColumnarReaderBase
+  {
+  public:
+    /** \brief Ctor; see ColumnarReaderBase for the exceptions */
+    explicit ColumnarReader(SqlStatement&& _stmt, size_t chunkSize = DefaultColumnarChunkSize)
+      :ColumnarReaderBase(std::move(_stmt), sizeof...(Ts), chunkSize) {}
+
+    /** \brief Replaces the contents of the column buffers with the next chunk of rows
+     *
+     * \throws BusyException if the statement couldn't be executed because the DB was busy
+     *
+     * \throws GenericSqliteException incl. error code if anything else goes wrong
+     *
+     * \returns the number of rows in the chunk; 0 if there are no more rows
+     *
+     * Test case: yes
+     *
+     */
+    size_t nextChunk()
+    {
+      std::apply([this](auto& ... buf) { ((buf.clear(), buf.reserve(nChunk)), ...); }, cols);
+
+      size_t n{0};
+      while ((n < nChunk) && step())
+      {
+        fetchRow(std::index_sequence_for<Ts...>{});
+        ++n;
+      }
+      nTotal += n;
+
+      return n;
+    }
+
+    /** \returns the buffer of the column with the given (zero-based) index in the current chunk
+     *
+     * Test case: yes
+     *
+     */
+    template<size_t idx>
+    const auto& column() const { return std::get<idx>(cols); }
+
+    /** \returns the number of rows in the current chunk */
+    size_t rowsInChunk() const { return std::get<0>(cols).size(); }
+
+  private:
+    template<size_t ... idx>
+    void fetchRow(std::index_sequence<idx...>) { (fetchCell<idx>(), ...); }
+
+    template<size_t idx>
+    void fetchCell()
+    {
+      auto& buf = std::get<idx>(cols);
+      using T = std::tuple_element_t<idx, std::tuple<Ts...>>;
+
+      if (isNull_NoGuards(idx))
+      {
+        buf.pushNull();
+      } else if constexpr (std::is_same_v<T, int64_t>) {
+        buf.push(getInt64_NoGuards(idx));
+      } else if constexpr (std::is_same_v<T, double>) {
+        buf.push(getDouble_NoGuards(idx));
+      } else {
+        buf.push(getString_NoGuards(idx));
+      }
+    }
+
+    std::tuple<ColumnBuffer<Ts>...> cols;
+  };
+
+  //----------------------------------------------------------------------------
+
+  // Reductions over a single ColumnBuffer.
+  //
+  // The loops work on the contiguous value vector and, where NULLs matter,
+  // consume the null bitmap 64 rows at a time: blocks without any NULL take
+  // a branch-free path that the compiler can auto-vectorize.
+
+  /** \brief Calls `f(value)` for each non-NULL value in the buffer */
+  template<typename T, typename Func>
+  void forEachNonNull(const ColumnBuffer<T>& buf, Func&& f)
+  {
+    const size_t n = buf.size();
+    const T* v = buf.values.data();
+    for (size_t blk = 0; blk < buf.nullBits.size(); ++blk)
+    {
+      const size_t first = blk * 64;
+      const size_t last = std::min(n, first + 64);
+      const uint64_t word = buf.nullBits[blk];
+
+      if (word == 0)
+      {
+        for (size_t i = first; i < last; ++i) f(v[i]);
+      } else if (~word != 0) {
+        for (size_t i = first; i < last; ++i)
+        {
+          if (((word >> (i - first)) & 1) == 0) f(v[i]);
+        }
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  /** \returns the number of non-NULL values in the buffer */
+  template<typename T>
+  size_t columnCount(const ColumnBuffer<T>& buf)
+  {
+    size_t nNull{0};
+    for (uint64_t word : buf.nullBits) nNull += std::popcount(word);
+    return buf.size() - nNull;
+  }
+
+  //----------------------------------------------------------------------------
+
+  /** \returns the sum of all non-NULL values; 0 for an empty buffer */
+  template<typename T>
+  T columnSum(const ColumnBuffer<T>& buf)
+  {
+    static_assert (std::is_arithmetic_v<T>, "columnSum() requires a numeric column");
+
+    // NULLs are stored as 0, so we can sum up everything. Independent
+    // partial sums allow vectorization even for floating point values
+    // where the compiler must not reorder the additions on its own.
+    constexpr size_t nLanes{8};
+    std::array<T, nLanes> acc{};
+    const size_t n = buf.size();
+    const T* v = buf.values.data();
+
+    size_t i{0};
+    for (; (i + nLanes) <= n; i += nLanes)
+    {
+      for (size_t k = 0; k < nLanes; ++k) acc[k] += v[i + k];
+    }
+
+    T result{0};
+    for (T a : acc) result += a;
+    for (; i < n; ++i) result += v[i];
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  /** \returns the minimum and maximum of all non-NULL values or an empty optional
+   * if the buffer contains no non-NULL values
+   */
+  template<typename T>
+  std::optional<std::pair<T, T>> columnMinMax(const ColumnBuffer<T>& buf)
+  {
+    static_assert (std::is_arithmetic_v<T>, "columnMinMax() requires a numeric column");
+
+    if (buf.countNonNull() == 0) return std::nullopt;
+
+    T lo{std::numeric_limits<T>::max()};
+    T hi{std::numeric_limits<T>::lowest()};
+    forEachNonNull(buf, [&lo, &hi](T x) {
+      lo = (x < lo) ? x : lo;
+      hi = (x > hi) ? x : hi;
+    });
+
+    return std::pair{lo, hi};
+  }
+
+  //----------------------------------------------------------------------------
+
+  /** \brief The result of `columnHistogram()`
+   */
+  struct ColumnHistogram
+  {
+    std::vector<size_t> bins;   ///< the number of values per bin
+    size_t nBelow{0};   ///< number of values less than the lower bound
+    size_t nAbove{0};   ///< number of values greater than or equal to the upper bound
+  };
+
+  /** \brief Counts the non-NULL values in `nBins` bins of equal width between `lo` (inclusive)
+   * and `hi` (exclusive)
+   *
+   * \throws std::invalid_argument if `nBins` is zero or if `lo` is not less than `hi`
+   */
+  template<typename T>
+  ColumnHistogram columnHistogram(const ColumnBuffer<T>& buf, double lo, double hi, size_t nBins)
+  {
+    static_assert (std::is_arithmetic_v<T>, "columnHistogram() requires a numeric column");
+
+    if (nBins == 0)
+    {
+      throw std::invalid_argument("columnHistogram(): number of bins must be positive");
+    }
+    if (!(lo < hi))
+    {
+      throw std::invalid_argument("columnHistogram(): invalid range");
+    }
+
+    ColumnHistogram result;
+    result.bins.resize(nBins, 0);
+    const double scale = static_cast<double>(nBins) / (hi - lo);
+    forEachNonNull(buf, [&](T x) {
+      const double d = static_cast<double>(x);
+      if (d < lo)
+      {
+        ++result.nBelow;
+      } else if (d >= hi) {
+        ++result.nAbove;
+      } else {
+        // rounding might push values close to `hi` into a non-existing bin
+        const size_t idx = std::min(static_cast<size_t>((d - lo) * scale), nBins - 1);
+        ++result.bins[idx];
+      }
+    });
+
+    return result;
+  }
+
+}
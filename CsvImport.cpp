@@ -0,0 +1,665 @@
+#include <algorithm>              // for count, max
+#include <atomic>                 // for atomic
+#include <charconv>               // for from_chars
+#include <cmath>                  // for isfinite
+#include <condition_variable>     // for condition_variable
+#include <cstdint>                // for int64_t
+#include <cstring>                // for memchr, memmove, memrchr
+#include <deque>                  // for deque
+#include <exception>              // for exception_ptr, current_exception
+#include <fstream>                // for ifstream
+#include <istream>                // for istream
+#include <map>                    // for map
+#include <mutex>                  // for mutex, lock_guard, unique_lock
+#include <optional>               // for optional
+#include <stdexcept>              // for invalid_argument
+#include <string_view>            // for string_view
+#include <thread>                 // for thread
+#include <utility>                // for move
+#include <vector>                 // for vector
+
+#include "SqlStatement.h"         // for SqlStatement
+#include "SqliteDatabase.h"       // for SqliteDatabase
+#include "SqliteExceptions.h"     // for GenericSqliteException
+#include "Transaction.h"          // for Transaction
+
+#include "CsvImport.h"
+
+using namespace std;
+
+namespace SqliteOverlay
+{
+  namespace
+  {
+    /** \brief Location of a single field within a chunk
+     */
+    struct RawField
+    {
+      size_t offset;
+      size_t len;
+      bool quoted;
+    };
+
+    /** \brief A parsed value, ready for binding
+     */
+    struct Field
+    {
+      ColumnDataType type{ColumnDataType::Null};
+      size_t offset{0};
+      size_t len{0};
+      int64_t intVal{0};
+      double dblVal{0.0};
+    };
+
+    /** \brief A block of complete CSV records and, after parsing, its values
+     */
+    struct Chunk
+    {
+      size_t seq{0};
+      string data;
+      vector<Field> fields;   // nRows * nCols entries
+      size_t nRows{0};
+    };
+
+    //----------------------------------------------------------------------------
+
+    /** \brief A simple multi-producer, multi-consumer queue that can be closed;
+     * its size is limited by the InFlightLimiter
+     */
+    template<typename T>
+    class BlockingQueue
+    {
+    public:
+      void push(T&& v)
+      {
+        {
+          lock_guard<mutex> lg{mtx};
+          q.push_back(std::move(v));
+        }
+        cv.notify_one();
+      }
+
+      /** \returns `false` if the queue has been closed and is empty
+       */
+      bool pop(T& out)
+      {
+        unique_lock<mutex> lk{mtx};
+        cv.wait(lk, [this]() { return (!q.empty() || closed); });
+        if (q.empty()) return false;
+
+        out = std::move(q.front());
+        q.pop_front();
+        return true;
+      }
+
+      void close()
+      {
+        {
+          lock_guard<mutex> lg{mtx};
+          closed = true;
+        }
+        cv.notify_all();
+      }
+
+    private:
+      mutex mtx;
+      condition_variable cv;
+      deque<T> q;
+      bool closed{false};
+    };
+
+    //----------------------------------------------------------------------------
+
+    /** \brief Limits the number of chunks between reading and inserting
+     */
+    class InFlightLimiter
+    {
+    public:
+      explicit InFlightLimiter(size_t _maxInFlight)
+        :maxInFlight{_maxInFlight} {}
+
+      /** \returns `false` if the import has been aborted
+       */
+      bool acquire()
+      {
+        unique_lock<mutex> lk{mtx};
+        cv.wait(lk, [this]() { return ((nInFlight < maxInFlight) || aborted); });
+        if (aborted) return false;
+
+        ++nInFlight;
+        return true;
+      }
+
+      void release()
+      {
+        {
+          lock_guard<mutex> lg{mtx};
+          --nInFlight;
+        }
+        cv.notify_all();
+      }
+
+      void abort()
+      {
+        {
+          lock_guard<mutex> lg{mtx};
+          aborted = true;
+        }
+        cv.notify_all();
+      }
+
+    private:
+      mutex mtx;
+      condition_variable cv;
+      const size_t maxInFlight;
+      size_t nInFlight{0};
+      bool aborted{false};
+    };
+
+    //----------------------------------------------------------------------------
+
+    /** \brief Reads the input in blocks that always end at a record boundary
+     */
+    class ChunkReader
+    {
+    public:
+      ChunkReader(istream& _in, size_t _chunkSize)
+        :in{_in}, chunkSize{max(_chunkSize, size_t{1})} {}
+
+      /** \returns `false` if there's no more data
+       */
+      bool next(string& out)
+      {
+        string block = std::move(carry);
+        carry.clear();
+
+        while (true)
+        {
+          if (!eof)
+          {
+            const size_t oldSize = block.size();
+            block.resize(oldSize + chunkSize);
+            in.read(block.data() + oldSize, chunkSize);
+            if (in.bad())
+            {
+              throw std::invalid_argument("CSV import: error while reading the input");
+            }
+            const size_t nRead = static_cast<size_t>(in.gcount());
+            block.resize(oldSize + nRead);
+            eof = (nRead < chunkSize);
+          }
+
+          if (eof)
+          {
+            if (block.empty()) return false;
+
+            if (block.back() != '\n') block.push_back('\n');
+            out = std::move(block);
+            return true;
+          }
+
+          const size_t pos = lastRecordEnd(block);
+          if (pos == string::npos) continue;   // a single record that is larger than the chunk size
+
+          carry.assign(block, pos + 1);
+          block.resize(pos + 1);
+          out = std::move(block);
+          return true;
+        }
+      }
+
+    protected:
+      /** \returns the position of the last line break that is not inside a quoted field
+       *
+       * The block always starts at a record boundary. A line break is a record boundary if
+       * the number of quotes before it is even. Counting quotes and searching line
+       * breaks from the back are both simple loops that the compiler and the C library vectorize.
+       */
+      static size_t lastRecordEnd(const string& block)
+      {
+        const char* const base = block.data();
+        size_t nQuotesBefore = static_cast<size_t>(count(block.cbegin(), block.cend(), '"'));
+        size_t searchEnd = block.size();
+
+        while (searchEnd > 0)
+        {
+          const char* nl = static_cast<const char*>(memrchr(base, '\n', searchEnd));
+          if (nl == nullptr) return string::npos;
+
+          const size_t pos = nl - base;
+          nQuotesBefore -= static_cast<size_t>(count(nl + 1, base + searchEnd, '"'));
+          if ((nQuotesBefore % 2) == 0) return pos;
+
+          searchEnd = pos;
+        }
+
+        return string::npos;
+      }
+
+    private:
+      istream& in;
+      const size_t chunkSize;
+      string carry;
+      bool eof{false};
+    };
+
+    //----------------------------------------------------------------------------
+
+    /** \brief Parses a single record, starting at `p`; quoted fields are unescaped in place
+     *
+     * Empty lines before the record are skipped.
+     *
+     * \returns `false` if there are no more records
+     */
+    bool parseRecord(char*& p, char* const end, char* const base, char sep, vector<RawField>& out)
+    {
+      out.clear();
+
+      // skip empty lines
+      while ((p < end) && ((*p == '\n') || ((*p == '\r') && ((p + 1) < end) && (p[1] == '\n'))))
+      {
+        p += (*p == '\n') ? 1 : 2;
+      }
+      if (p >= end) return false;
+
+      char* eol = static_cast<char*>(memchr(p, '\n', end - p));
+      if (eol == nullptr) eol = end;
+
+      while (true)
+      {
+        if (*p == '"')
+        {
+          char* rd = p + 1;
+          char* wr = p;
+          char* const fieldStart = p;
+          while (true)
+          {
+            char* q = static_cast<char*>(memchr(rd, '"', end - rd));
+            if (q == nullptr)
+            {
+              throw std::invalid_argument("CSV import: unterminated quoted field");
+            }
+            memmove(wr, rd, q - rd);
+            wr += q - rd;
+            rd = q + 1;
+
+            // escaped quote?
+            if ((rd < end) && (*rd == '"'))
+            {
+              *wr++ = '"';
+              ++rd;
+              continue;
+            }
+            break;
+          }
+
+          out.push_back(RawField{static_cast<size_t>(fieldStart - base), static_cast<size_t>(wr - fieldStart), true});
+
+          p = rd;
+          if ((p < end) && (*p == '\r') && ((p + 1) < end) && (p[1] == '\n')) ++p;
+          if ((p < end) && (*p != sep) && (*p != '\n'))
+          {
+            throw std::invalid_argument("CSV import: unexpected character after a quoted field");
+          }
+
+          // the quoted field might have contained line breaks
+          if (eol < p)
+          {
+            eol = static_cast<char*>(memchr(p, '\n', end - p));
+            if (eol == nullptr) eol = end;
+          }
+        } else {
+          char* q = static_cast<char*>(memchr(p, sep, eol - p));
+          char* fieldEnd = (q == nullptr) ? eol : q;
+          size_t len = fieldEnd - p;
+          if ((q == nullptr) && (len > 0) && (fieldEnd[-1] == '\r')) --len;
+
+          out.push_back(RawField{static_cast<size_t>(p - base), len, false});
+          p = fieldEnd;
+        }
+
+        if ((p >= end) || (*p == '\n'))
+        {
+          ++p;
+          return true;
+        }
+
+        ++p;   // skip the separator
+      }
+    }
+
+    //----------------------------------------------------------------------------
+
+    /** \brief Converts a raw field into a typed value
+     */
+    Field classify(const char* const base, const RawField& rf, ColumnDataType hint)
+    {
+      Field f;
+      f.offset = rf.offset;
+      f.len = rf.len;
+
+      if ((rf.len == 0) && !rf.quoted)
+      {
+        f.type = ColumnDataType::Null;
+        return f;
+      }
+
+      f.type = (hint == ColumnDataType::Blob) ? ColumnDataType::Blob : ColumnDataType::Text;
+      if ((hint == ColumnDataType::Text) || (hint == ColumnDataType::Blob)) return f;
+
+      // auto-detection only converts unquoted values
+      if (rf.quoted && (hint == ColumnDataType::Null)) return f;
+
+      const char* const first = base + rf.offset;
+      const char* const last = first + rf.len;
+
+      if (hint != ColumnDataType::Float)
+      {
+        auto [ptr, ec] = from_chars(first, last, f.intVal);
+        if ((ec == errc{}) && (ptr == last))
+        {
+          f.type = ColumnDataType::Integer;
+          return f;
+        }
+      }
+
+      if (hint != ColumnDataType::Integer)
+      {
+        auto [ptr, ec] = from_chars(first, last, f.dblVal);
+        if ((ec == errc{}) && (ptr == last) && std::isfinite(f.dblVal))
+        {
+          f.type = ColumnDataType::Float;
+          return f;
+        }
+      }
+
+      return f;
+    }
+
+    //----------------------------------------------------------------------------
+
+    void parseChunk(Chunk& c, char sep, const vector<ColumnDataType>& hints)
+    {
+      const size_t nCols = hints.size();
+      char* const base = c.data.data();
+      char* p = base;
+      char* const end = base + c.data.size();
+
+      vector<RawField> raw;
+      raw.reserve(nCols);
+      c.fields.clear();
+      c.nRows = 0;
+
+      while (parseRecord(p, end, base, sep, raw))
+      {
+        if (raw.size() != nCols)
+        {
+          throw std::invalid_argument("CSV import: found a row with " + to_string(raw.size()) +
+                                      " fields instead of " + to_string(nCols));
+        }
+
+        for (size_t colIdx = 0; colIdx < nCols; ++colIdx)
+        {
+          c.fields.push_back(classify(base, raw[colIdx], hints[colIdx]));
+        }
+        ++c.nRows;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  CsvStreamImporter::CsvStreamImporter(const SqliteDatabase& _db, const string& _tabName, const CsvImportOptions& _opts)
+    :db{cref(_db)}, tabName{_tabName}, opts{_opts}
+  {
+    if (tabName.empty())
+    {
+      throw std::invalid_argument("CsvStreamImporter ctor: empty table name");
+    }
+    if ((opts.separator == '"') || (opts.separator == '\n') || (opts.separator == '\r'))
+    {
+      throw std::invalid_argument("CsvStreamImporter ctor: invalid separator");
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t CsvStreamImporter::importFile(const string& fileName) const
+  {
+    ifstream f{fileName, ios::in | ios::binary};
+    if (!f)
+    {
+      throw std::invalid_argument("CSV import: could not open " + fileName);
+    }
+
+    return importStream(f);
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t CsvStreamImporter::importStream(istream& in) const
+  {
+    const SqliteDatabase& d = db.get();
+    ChunkReader reader{in, opts.chunkSize};
+
+    // the column names are read and parsed synchronously
+    string firstChunk;
+    vector<RawField> header;
+    char* p{nullptr};
+    if (reader.next(firstChunk))
+    {
+      p = firstChunk.data();
+      parseRecord(p, firstChunk.data() + firstChunk.size(), firstChunk.data(), opts.separator, header);
+    }
+    if (header.empty())
+    {
+      throw std::invalid_argument("CSV import: no column headers");
+    }
+
+    const size_t headerBytes = p - firstChunk.data();
+    vector<ColumnDataType> hints;
+    string sql = "INSERT INTO " + tabName + " (";
+    string qMarks;
+    for (const RawField& rf : header)
+    {
+      const string colName{firstChunk.data() + rf.offset, rf.len};
+
+      // quote column names to provide a little more resistance against
+      // ugly / unsecure / dangerous strings provided by untrusted users
+      if (!qMarks.empty())
+      {
+        sql += ",";
+        qMarks += ",";
+      }
+      sql += quoteIdentifier(colName);
+      qMarks += "?";
+
+      auto it = opts.columnTypes.find(colName);
+      hints.push_back((it == opts.columnTypes.end()) ? ColumnDataType::Null : it->second);
+    }
+    sql += ") VALUES (" + qMarks + ")";
+    firstChunk.erase(0, headerBytes);
+
+    // throws on invalid column names before we start any thread
+    auto stmt = d.prepStatement(sql);
+    const size_t nCols = hints.size();
+
+    //
+    // set up the pipeline
+    //
+    size_t nThreads = opts.nParserThreads;
+    if (nThreads == 0)
+    {
+      const size_t nCores = thread::hardware_concurrency();
+      nThreads = (nCores > 1) ? (nCores - 1) : 1;
+    }
+    const size_t maxInFlight = (opts.maxChunksInFlight == 0) ? (2 * nThreads) : opts.maxChunksInFlight;
+
+    BlockingQueue<Chunk> rawQueue;
+    BlockingQueue<Chunk> parsedQueue;
+    InFlightLimiter limiter{max(maxInFlight, size_t{1})};
+    atomic<bool> aborted{false};
+    atomic<size_t> nParsersRunning{nThreads};
+    mutex errMutex;
+    exception_ptr firstError;
+
+    auto fail = [&](exception_ptr e) {
+      {
+        lock_guard<mutex> lg{errMutex};
+        if (!firstError) firstError = e;
+      }
+      aborted = true;
+      limiter.abort();
+      rawQueue.close();
+      parsedQueue.close();
+    };
+
+    // the reader
+    thread readerThread{[&]() {
+      try
+      {
+        size_t seq{0};
+        if (!firstChunk.empty() && limiter.acquire())
+        {
+          rawQueue.push(Chunk{seq++, std::move(firstChunk), {}, 0});
+        }
+
+        string s;
+        while (!aborted && limiter.acquire())
+        {
+          if (!reader.next(s))
+          {
+            limiter.release();
+            break;
+          }
+          rawQueue.push(Chunk{seq++, std::move(s), {}, 0});
+        }
+      }
+      catch (...)
+      {
+        fail(current_exception());
+      }
+      rawQueue.close();
+    }};
+
+    // the parsers
+    vector<thread> parserThreads;
+    for (size_t i = 0; i < nThreads; ++i)
+    {
+      parserThreads.emplace_back([&]() {
+        try
+        {
+          Chunk c;
+          while (!aborted && rawQueue.pop(c))
+          {
+            parseChunk(c, opts.separator, hints);
+            parsedQueue.push(std::move(c));
+          }
+        }
+        catch (...)
+        {
+          fail(current_exception());
+        }
+        if (--nParsersRunning == 0) parsedQueue.close();
+      });
+    }
+
+    // the inserter is the calling thread; it inserts
+    // the chunks in their original order
+    size_t nRows{0};
+    CsvImportProgress progress{0, headerBytes};
+    try
+    {
+      optional<Transaction> tr;
+      tr.emplace(&d, opts.transactionType, TransactionDtorAction::Rollback);
+
+      map<size_t, Chunk> pending;
+      size_t nextSeq{0};
+      Chunk c;
+      while (!aborted && parsedQueue.pop(c))
+      {
+        pending.emplace(c.seq, std::move(c));
+
+        for (auto it = pending.find(nextSeq); (it != pending.end()) && !aborted; it = pending.find(nextSeq))
+        {
+          const Chunk& cur = it->second;
+          const char* const base = cur.data.data();
+          auto fieldIt = cur.fields.cbegin();
+          for (size_t rowIdx = 0; rowIdx < cur.nRows; ++rowIdx)
+          {
+            for (int colIdx = 1; colIdx <= static_cast<int>(nCols); ++colIdx, ++fieldIt)
+            {
+              const Field& f = *fieldIt;
+              switch (f.type)
+              {
+              case ColumnDataType::Integer:
+                stmt.bind(colIdx, f.intVal);
+                break;
+
+              case ColumnDataType::Float:
+                stmt.bind(colIdx, f.dblVal);
+                break;
+
+              case ColumnDataType::Text:
+                // the chunk outlives the step, so there's no need to copy
+                stmt.bindStatic(colIdx, string_view{base + f.offset, f.len});
+                break;
+
+              case ColumnDataType::Blob:
+                stmt.bindStatic(colIdx, base + f.offset, f.len);
+                break;
+
+              default:
+                stmt.bindNull(colIdx);
+              }
+            }
+
+            stmt.step();
+            stmt.reset(false);   // all placeholders are re-bound anyway
+            ++nRows;
+
+            if ((opts.commitInterval > 0) && ((nRows % opts.commitInterval) == 0))
+            {
+              tr->commit();
+              tr.emplace(&d, opts.transactionType, TransactionDtorAction::Rollback);
+
+              progress.nRows = nRows;
+              if (opts.progressCallback) opts.progressCallback(progress);
+            }
+          }
+
+          progress.nBytes += cur.data.size();
+          pending.erase(it);
+          ++nextSeq;
+          limiter.release();
+        }
+      }
+
+      if (!aborted)
+      {
+        tr->commit();
+
+        progress.nRows = nRows;
+        if (opts.progressCallback) opts.progressCallback(progress);
+      }
+    }
+    catch (...)
+    {
+      fail(current_exception());
+    }
+
+    // make sure all threads have terminated
+    // before we leave this function
+    limiter.abort();
+    rawQueue.close();
+    readerThread.join();
+    for (thread& t : parserThreads) t.join();
+
+    if (firstError) rethrow_exception(firstError);
+
+    return nRows;
+  }
+
+  //----------------------------------------------------------------------------
+
+}
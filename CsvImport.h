@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>      // for size_t
+#include <functional>   // for function, reference_wrapper
+#include <iosfwd>       // for istream
+#include <map>          // for map
+#include <string>       // for string
+
+#include "Defs.h"       // for ColumnDataType, TransactionType
+
+namespace SqliteOverlay
+{
+  class SqliteDatabase;
+
+  /** \brief Progress information for a running CSV import
+   */
+  struct CsvImportProgress
+  {
+    size_t nRows{0};   ///< number of rows inserted so far
+    size_t nBytes{0};   ///< number of CSV bytes (incl. headers) that have been processed so far
+  };
+
+  /** \brief Settings for a streaming CSV import
+   */
+  struct CsvImportOptions
+  {
+    char separator{','};   ///< the field separator
+    size_t commitInterval{100000};   ///< commit after this number of rows; 0 = a single transaction for the whole import
+    size_t nParserThreads{0};   ///< number of parser threads; 0 = one less than the number of CPU cores, but at least one
+    size_t chunkSize{1024 * 1024};   ///< the number of bytes that are read from the input at once
+    size_t maxChunksInFlight{0};   ///< max number of chunks that are in memory at the same time; 0 = two per parser thread
+
+    /** \brief Type hints per column name.
+     *
+     * Columns without a hint are auto-detected per value: unquoted values that are
+     * valid integers or floats are stored as such, everything else as text.
+     *
+     * With a hint of `Text` or `Blob` a value is never converted (e.g., for keeping
+     * leading zeros). With a hint of `Integer` or `Float` the value is stored as text
+     * if it can't be converted. Empty, unquoted values are always stored as NULL.
+     */
+    std::map<std::string, ColumnDataType> columnTypes;
+
+    TransactionType transactionType{TransactionType::Immediate};   ///< the type of the import transactions
+
+    std::function<void(const CsvImportProgress&)> progressCallback;   ///< called after each commit (optional)
+  };
+
+  /** \brief Imports CSV data from a file or stream into a table without
+   * holding the complete data in memory.
+   *
+   * The input is read in chunks that are split at record boundaries and parsed
+   * on worker threads while the calling thread inserts the parsed rows in their
+   * original order. The number of chunks in memory is limited, so the
+   * memory consumption does not depend on the size of the input.
+   *
+   * \pre The first record of the input contains the column names
+   * and these names exactly match the SQLite column names.
+   *
+   * \note Quoted fields may contain separators, line breaks and escaped
+   * quotes (`""`). Lines may end with `\n` or `\r\n`. Empty lines are ignored.
+   *
+   * \warning Rows that have been committed before an error occurred remain in the table.
+   */
+  class CsvStreamImporter
+  {
+  public:
+    /** \brief Ctor, doesn't do anything but storing the parameters
+     *
+     * \throws std::invalid_argument if the table name is empty or if the
+     * separator is a quote or a line break
+     *
+     * Test case: yes
+     *
+     */
+    CsvStreamImporter(
+        const SqliteDatabase& _db,   ///< the database that contains the table
+        const std::string& _tabName,   ///< the name of the target table
+        const CsvImportOptions& _opts = CsvImportOptions{}   ///< the import settings
+        );
+
+    /** \brief Imports all data from a CSV file
+     *
+     * \throws std::invalid_argument if the file can't be opened, if it doesn't contain
+     * column headers or if the CSV data is malformed (e.g., a wrong number of fields)
+     *
+     * \throws SqlStatementCreationError if the CSV data contained invalid column names.
+     *
+     * \throws ConstraintFailedException if the CSV data violated a constraint
+     *
+     * \throws BusyException if the DB was busy and the required lock could not be acquired
+     *
+     * \throws GenericSqliteException incl. error code if anything else goes wrong
+     *
+     * \returns the number of inserted rows
+     *
+     * Test case: yes
+     *
+     */
+    size_t importFile(
+        const std::string& fileName   ///< the name of the CSV file
+        ) const;
+
+    /** \brief Imports all data from an input stream
+     *
+     * See `importFile()` for exceptions.
+     *
+     * \returns the number of inserted rows
+     *
+     * Test case: yes
+     *
+     */
+    size_t importStream(
+        std::istream& in   ///< the stream with the CSV data
+        ) const;
+
+  private:
+    std::reference_wrapper<const SqliteDatabase> db;
+    std::string tabName;
+    CsvImportOptions opts;
+  };
+
+}
@@ -14,6 +14,7 @@
 #include <algorithm>        // for max
 #include <cstddef>          // for size_t, std
 #include <memory>           // for unique_ptr, make_unique
+#include <optional>         // for optional
 
 #include <Sloppy/CSV.h>     // for CSV_Table, CSV_Value, CSV_Value::Type
 #include <Sloppy/String.h>  // for estring
@@ -58,6 +59,150 @@ namespace SqliteOverlay
 
   //----------------------------------------------------------------------------
 
+  pair<int, int> DbTab::insertRows(span<const ColumnValueClause> rows, bool useTransaction) const
+  {
+    if (rows.empty()) return make_pair(-1, -1);
+
+    const SqliteDatabase& d = db.get();
+
+    optional<Transaction> tr;
+    if (useTransaction && d.isAutoCommit())
+    {
+      tr.emplace(&d, TransactionType::Immediate, TransactionDtorAction::Rollback);
+    }
+
+    // re-use the statement as long as consecutive rows use the same
+    // set of columns; the SQL text is only built when the columns change
+    const ColumnValueClause* lastCvc{nullptr};
+    SqlStatement stmt;
+    int firstId = -1;
+    for (const ColumnValueClause& cvc : rows)
+    {
+      if ((lastCvc == nullptr) || !cvc.hasSameInsertColumns(*lastCvc))
+      {
+        stmt = d.prepStatement(cvc.getInsertSql(tabName));
+      } else {
+        stmt.reset(true);
+      }
+      lastCvc = &cvc;
+
+      cvc.bindValuesToPlaceholders(stmt);
+      stmt.step();
+
+      if (firstId < 0) firstId = d.getLastInsertId();
+    }
+    const int lastId = d.getLastInsertId();
+
+    if (tr) tr->commit();
+
+    return make_pair(firstId, lastId);
+  }
+
+  //----------------------------------------------------------------------------
+
+  pair<int, int> DbTab::insertRows_impl(const vector<string>& colNames, size_t nRows, const function<void (SqlStatement&, int, size_t)>& binder, bool useTransaction) const
+  {
+    if (colNames.empty())
+    {
+      throw std::invalid_argument("insertRows(): empty list of column names");
+    }
+    if (nRows == 0) return make_pair(-1, -1);
+
+    const SqliteDatabase& d = db.get();
+    const int nCols = static_cast<int>(colNames.size());
+
+    // determine how many rows fit into a single statement
+    const int maxVars = d.getLimit(SQLITE_LIMIT_VARIABLE_NUMBER);
+    if (nCols > maxVars)
+    {
+      throw std::invalid_argument("insertRows(): more columns than SQLITE_LIMIT_VARIABLE_NUMBER");
+    }
+    const size_t rowsPerStmt = static_cast<size_t>(std::clamp(maxVars / nCols, 1, MaxRowsPerInsertStmt));
+
+    // build the SQL text for a statement with n rows
+    string sqlPrefix = "INSERT INTO " + tabName + " (";
+    string rowPlaceholders = "(";
+    for (int i = 0; i < nCols; ++i)
+    {
+      if (i > 0)
+      {
+        sqlPrefix += ",";
+        rowPlaceholders += ",";
+      }
+      sqlPrefix += colNames[i];
+      rowPlaceholders += "?";
+    }
+    sqlPrefix += ") VALUES ";
+    rowPlaceholders += ")";
+
+    auto sqlForRows = [&](size_t n) {
+      string sql;
+      sql.reserve(sqlPrefix.size() + n * (rowPlaceholders.size() + 1));
+      sql = sqlPrefix;
+      for (size_t i = 0; i < n; ++i)
+      {
+        if (i > 0) sql += ",";
+        sql += rowPlaceholders;
+      }
+      return sql;
+    };
+
+    auto bindAndStep = [&](SqlStatement& stmt, size_t firstRow, size_t n) {
+      for (size_t i = 0; i < n; ++i)
+      {
+        binder(stmt, 1 + static_cast<int>(i) * nCols, firstRow + i);
+      }
+      stmt.step();
+      stmt.reset(false);   // all placeholders are re-bound anyway
+    };
+
+    optional<Transaction> tr;
+    if (useTransaction && d.isAutoCommit())
+    {
+      tr.emplace(&d, TransactionType::Immediate, TransactionDtorAction::Rollback);
+    }
+
+    // the first row is inserted on its own because this is the
+    // only way to reliably determine its rowid
+    SqlStatement singleRowStmt = d.prepStatement(sqlForRows(1));
+    bindAndStep(singleRowStmt, 0, 1);
+    const int firstId = d.getLastInsertId();
+    size_t nextRow = 1;
+
+    // all other rows in chunks of `rowsPerStmt` rows
+    if ((rowsPerStmt > 1) && ((nRows - nextRow) >= rowsPerStmt))
+    {
+      SqlStatement chunkStmt = d.prepStatement(sqlForRows(rowsPerStmt));
+      while ((nRows - nextRow) >= rowsPerStmt)
+      {
+        bindAndStep(chunkStmt, nextRow, rowsPerStmt);
+        nextRow += rowsPerStmt;
+      }
+    }
+
+    // the remaining rows
+    const size_t nRemaining = nRows - nextRow;
+    if (nRemaining == 1)
+    {
+      bindAndStep(singleRowStmt, nextRow, 1);
+    }
+    if (nRemaining > 1)
+    {
+      SqlStatement remainderStmt = d.prepStatement(sqlForRows(nRemaining));
+      bindAndStep(remainderStmt, nextRow, nRemaining);
+    }
+
+    // in a multi-row INSERT, the last insert ID refers
+    // to the last row of the statement
+    const int lastId = d.getLastInsertId();
+
+    if (tr) tr->commit();
+
+    return make_pair(firstId, lastId);
+  }
+
+  //----------------------------------------------------------------------------
+
   TabRow DbTab::operator [](const int id) const
   {
     return TabRow(db, tabName, id, true);
@@ -346,12 +491,12 @@ namespace SqliteOverlay
     // quote column names to provide a little more resistance against
     // ugly / unsecure / dangerous strings provided by untrusted users
     Sloppy::estring sql = "INSERT INTO " + tabName +
-                          " (\"" + csvTab.getHeader(0) + "\"%1) VALUES (?%2)";
+                          " (" + quoteIdentifier(csvTab.getHeader(0)) + "%1) VALUES (?%2)";
     string colNames;
     string qMarks;
     for (size_t colIdx = 1; colIdx < csvTab.nCols(); ++colIdx)
     {
-      colNames += ",\"" + csvTab.getHeader(colIdx) + "\"";
+      colNames += "," + quoteIdentifier(csvTab.getHeader(colIdx));
       qMarks += ",?";
     }
     sql.arg(colNames);
@@ -401,6 +546,20 @@ namespace SqliteOverlay
 
   //----------------------------------------------------------------------------
 
+  size_t DbTab::importCSVFile(const string& fileName, const CsvImportOptions& opts) const
+  {
+    return CsvStreamImporter{db.get(), tabName, opts}.importFile(fileName);
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t DbTab::importCSVStream(istream& in, const CsvImportOptions& opts) const
+  {
+    return CsvStreamImporter{db.get(), tabName, opts}.importStream(in);
+  }
+
+  //----------------------------------------------------------------------------
+
   void DbTab::addColumn_exec(const string& colName, ColumnDataType colType, const string& constraints) const
   {
     string cn{colName};
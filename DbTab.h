@@ -12,22 +12,30 @@
 
 #pragma once
 
+#include <cstddef>                                      // for nullptr_t
 #include <functional>                                   // for reference_wra...
+#include <iosfwd>                                       // for istream
 #include <memory>                                       // for unique_ptr
 #include <optional>                                     // for optional
+#include <span>                                         // for span
 #include <stdexcept>                                    // for invalid_argument
 #include <string>                                       // for string, opera...
+#include <string_view>                                  // for string_view
+#include <tuple>                                        // for tuple, get
+#include <utility>                                      // for pair, index_s...
 #include <vector>                                       // for allocator
 
 #include <Sloppy/ConfigFileParser/ConstraintChecker.h>  // for ValueConstraint
 
 #include "ClausesAndQueries.h"                          // for WhereClause
 #include "CommonTabularClass.h"                         // for CommonTabular...
+#include "CsvImport.h"                                  // for CsvImportOptions
 #include "Defs.h"                                       // for ConflictClause
 #include "SqlStatement.h"                               // for SqlStatement
 #include "SqliteDatabase.h"                             // for buildColumnCo...
 #include "SqliteExceptions.h"                           // for SqlStatementC...
 #include "TabRow.h"                                     // for TabRow
+#include "TypeTraits.h"                                 // for IsOptional
 
 namespace Sloppy { class CSV_Table; }
 
@@ -109,6 +117,131 @@ namespace SqliteOverlay
      */
     int insertRow() const;
 
+    /** \brief The max number of rows in a single multi-row INSERT statement
+     * created by `insertRows()`
+     */
+    static constexpr int MaxRowsPerInsertStmt = 256;
+
+    /** \brief Appends many rows with given column values to the table
+     *
+     * Consecutive rows that use the same columns (in the same order) share a
+     * single prepared statement; it is only re-bound for each row.
+     *
+     * If `useTransaction` is `true` and there is no active transaction on the
+     * connection, all rows are inserted in a single transaction. Either all
+     * rows are inserted or none. Otherwise, an error leaves all previously
+     * inserted rows in the table.
+     *
+     * \throws BusyException if the statement couldn't be executed because the DB was busy
+     *
+     * \throws GenericSqliteException incl. error code if anything else goes wrong
+     *
+     * \returns the rowids of the first and the last inserted row or (-1, -1) if `rows` was empty
+     *
+     * Test case: yes
+     *
+     */
+    std::pair<int, int> insertRows(
+        std::span<const ColumnValueClause> rows,   ///< the column values for the new rows
+        bool useTransaction = true   ///< wrap the insertion in a transaction
+        ) const;
+
+    /** \brief Appends many rows for a fixed set of columns to the table, the
+     * column values being provided as tuples
+     *
+     * The rows are inserted using multi-row `INSERT ... VALUES (...), (...)`
+     * statements with up to `MaxRowsPerInsertStmt` rows per statement, limited by
+     * `SQLITE_LIMIT_VARIABLE_NUMBER`.
+     *
+     * Supported tuple element types are all types supported by `SqlStatement::bind()`
+     * plus `date::year_month_day`, `std::nullptr_t` (for NULL) and `std::optional`s
+     * of these. Strings and blobs are bound without copying.
+     *
+     * See the other overload of `insertRows()` for the meaning of `useTransaction`.
+     *
+     * \throws std::invalid_argument if the number of column names doesn't match the tuple size
+     *
+     * \throws BusyException if the statement couldn't be executed because the DB was busy
+     *
+     * \throws GenericSqliteException incl. error code if anything else goes wrong
+     *
+     * \returns the rowids of the first and the last inserted row or (-1, -1) if `rows` was empty
+     *
+     * Test case: yes
+     *
+     */
+    template<typename... Ts>
+    std::pair<int, int> insertRows(
+        const std::vector<std::string>& colNames,   ///< the names of the columns that receive the tuple elements
+        const std::vector<std::tuple<Ts...>>& rows,   ///< the column values for the new rows
+        bool useTransaction = true   ///< wrap the insertion in a transaction
+        ) const
+    {
+      if (colNames.size() != sizeof...(Ts))
+      {
+        throw std::invalid_argument("insertRows(): number of column names doesn't match the tuple size");
+      }
+
+      return insertRows_impl(colNames, rows.size(), [&rows](SqlStatement& stmt, int firstPlaceholderIdx, size_t rowIdx)
+      {
+        const auto& row = rows[rowIdx];
+        std::apply([&stmt, firstPlaceholderIdx](const auto& ... vals)
+        {
+          int idx = firstPlaceholderIdx;
+          (bindValue(stmt, idx++, vals), ...);
+        }, row);
+      }, useTransaction);
+    }
+
+    /** \brief Appends many rows for a fixed set of columns to the table, the
+     * column values being provided as one vector per column
+     *
+     * Works exactly like the tuple-based version of `insertRows()`. The column
+     * vectors are passed as a tuple of references, e.g. `std::tie(ids, names)`,
+     * so that no values are copied.
+     *
+     * \throws std::invalid_argument if the number of column names doesn't match the number
+     * of columns or if the columns are of different length
+     *
+     * \throws BusyException if the statement couldn't be executed because the DB was busy
+     *
+     * \throws GenericSqliteException incl. error code if anything else goes wrong
+     *
+     * \returns the rowids of the first and the last inserted row or (-1, -1) if the columns are empty
+     *
+     * Test case: yes
+     *
+     */
+    template<typename... Cols>
+    std::pair<int, int> insertRows(
+        const std::vector<std::string>& colNames,   ///< the names of the columns, in the same order as the column vectors
+        const std::tuple<Cols&...>& columns,   ///< references to the column vectors, one per column
+        bool useTransaction = true   ///< wrap the insertion in a transaction
+        ) const
+    {
+      static_assert (sizeof...(Cols) > 0, "insertRows(): need at least one column");
+
+      if (colNames.size() != sizeof...(Cols))
+      {
+        throw std::invalid_argument("insertRows(): number of column names doesn't match the number of columns");
+      }
+      const size_t nRows = std::get<0>(columns).size();
+      const bool isSameLength = std::apply([nRows](const auto& ... col) { return ((col.size() == nRows) && ...); }, columns);
+      if (!isSameLength)
+      {
+        throw std::invalid_argument("insertRows(): columns of different length");
+      }
+
+      return insertRows_impl(colNames, nRows, [&columns](SqlStatement& stmt, int firstPlaceholderIdx, size_t rowIdx)
+      {
+        std::apply([&stmt, firstPlaceholderIdx, rowIdx](const auto& ... col)
+        {
+          int idx = firstPlaceholderIdx;
+          (bindValue(stmt, idx++, col[rowIdx]), ...);
+        }, columns);
+      }, useTransaction);
+    }
+
     /** \brief Provides access to a single row in the table, the row being identified
      * by its ID
      *
@@ -875,7 +1008,76 @@ namespace SqliteOverlay
      */
     int importCSV(const Sloppy::CSV_Table& csvTab, TransactionType tt = TransactionType::Immediate) const;
 
+    /** \brief Imports a CSV file without loading it into memory
+     *
+     * A shortcut for `CsvStreamImporter{db, tabName, opts}.importFile(fileName)`;
+     * see `CsvStreamImporter` for details and exceptions.
+     *
+     * \returns the number of inserted rows
+     *
+     * Test case: yes
+     *
+     */
+    size_t importCSVFile(
+        const std::string& fileName,   ///< the name of the CSV file
+        const CsvImportOptions& opts = CsvImportOptions{}   ///< the import settings
+        ) const;
+
+    /** \brief Imports CSV data from a stream without loading it into memory
+     *
+     * A shortcut for `CsvStreamImporter{db, tabName, opts}.importStream(in)`;
+     * see `CsvStreamImporter` for details and exceptions.
+     *
+     * \returns the number of inserted rows
+     *
+     * Test case: yes
+     *
+     */
+    size_t importCSVStream(
+        std::istream& in,   ///< the stream with the CSV data
+        const CsvImportOptions& opts = CsvImportOptions{}   ///< the import settings
+        ) const;
+
   protected:
+    /** \brief Inserts `nRows` rows using multi-row INSERT statements; `binder`
+     * binds the values of a row starting at a given placeholder index
+     */
+    std::pair<int, int> insertRows_impl(
+        const std::vector<std::string>& colNames,
+        size_t nRows,
+        const std::function<void(SqlStatement&, int, size_t)>& binder,
+        bool useTransaction
+        ) const;
+
+    template<typename T>
+    static void bindValue(SqlStatement& stmt, int idx, const T& val)
+    {
+      if constexpr (detail::IsOptional<T>::value) {
+        if (val.has_value())
+        {
+          bindValue(stmt, idx, val.value());
+        } else {
+          stmt.bindNull(idx);
+        }
+      }
+      else if constexpr (std::is_same_v<T, std::nullptr_t>) {
+        stmt.bindNull(idx);
+      }
+      else if constexpr (std::is_same_v<T, date::year_month_day>) {
+        stmt.bind(idx, Sloppy::DateTime::intFromYmd(val));
+      }
+      else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> || std::is_same_v<T, Sloppy::MemView>) {
+        // the caller's data outlives the statement, so there's no need to copy it
+        stmt.bindStatic(idx, val);
+      }
+      else if constexpr (std::is_convertible_v<T, const char*>) {
+        stmt.bindStatic(idx, static_cast<const char*>(val));
+      }
+      else {
+        stmt.bind(idx, val);
+      }
+    }
+
     void addColumn_exec(
         const std::string& colName,
         ColumnDataType colType,
@@ -1,4 +1,5 @@
 
+#include <algorithm>  // for max
 #include <iosfwd>     // for std
 #include <stdexcept>  // for invalid_argument
 
@@ -81,6 +82,91 @@ namespace std
 
     return "";  // includes NoAction
   }
+
+  //----------------------------------------------------------------------------
+
+  std::string to_string(JournalMode jm)
+  {
+    switch (jm)
+    {
+    case JournalMode::Delete:
+      return "DELETE";
+
+    case JournalMode::Truncate:
+      return "TRUNCATE";
+
+    case JournalMode::Persist:
+      return "PERSIST";
+
+    case JournalMode::Memory:
+      return "MEMORY";
+
+    case JournalMode::WAL:
+      return "WAL";
+
+    case JournalMode::Off:
+      return "OFF";
+    }
+
+    return "";
+  }
+
+  //----------------------------------------------------------------------------
+
+  std::string to_string(SynchronousMode sm)
+  {
+    switch (sm)
+    {
+    case SynchronousMode::Off:
+      return "OFF";
+
+    case SynchronousMode::Normal:
+      return "NORMAL";
+
+    case SynchronousMode::Full:
+      return "FULL";
+
+    case SynchronousMode::Extra:
+      return "EXTRA";
+    }
+
+    return "";
+  }
+
+  //----------------------------------------------------------------------------
+
+  std::string to_string(TempStore ts)
+  {
+    switch (ts)
+    {
+    case TempStore::Default:
+      return "DEFAULT";
+
+    case TempStore::File:
+      return "FILE";
+
+    case TempStore::Memory:
+      return "MEMORY";
+    }
+
+    return "";
+  }
+
+  //----------------------------------------------------------------------------
+
+  std::string to_string(LockingMode lm)
+  {
+    switch (lm)
+    {
+    case LockingMode::Normal:
+      return "NORMAL";
+
+    case LockingMode::Exclusive:
+      return "EXCLUSIVE";
+    }
+
+    return "";
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -102,5 +188,104 @@ namespace SqliteOverlay
 
   //----------------------------------------------------------------------------
 
+  OpenOptions OpenOptions::OLTP()
+  {
+    OpenOptions o;
+    o.journalMode = JournalMode::WAL;
+    o.synchronous = SynchronousMode::Normal;
+    o.cacheSize = -16 * 1024;   // 16 MiB
+    o.mmapSize = 256 * 1024 * 1024;
+    o.tempStore = TempStore::Memory;
+    o.busyTimeout_ms = 5000;
+
+    return o;
+  }
+
+  //----------------------------------------------------------------------------
+
+  OpenOptions OpenOptions::ReadMostly()
+  {
+    OpenOptions o;
+    o.journalMode = JournalMode::WAL;
+    o.synchronous = SynchronousMode::Normal;
+    o.cacheSize = -64 * 1024;   // 64 MiB
+    o.mmapSize = int64_t{1024} * 1024 * 1024;
+    o.tempStore = TempStore::Memory;
+    o.busyTimeout_ms = 5000;
+
+    return o;
+  }
+
+  //----------------------------------------------------------------------------
+
+  OpenOptions OpenOptions::BulkLoad()
+  {
+    OpenOptions o;
+    o.journalMode = JournalMode::Memory;
+    o.synchronous = SynchronousMode::Off;
+    o.cacheSize = -256 * 1024;   // 256 MiB
+    o.tempStore = TempStore::Memory;
+    o.lockingMode = LockingMode::Exclusive;
+
+    return o;
+  }
+
+  //----------------------------------------------------------------------------
+
+  StatementStatus& StatementStatus::operator+=(const StatementStatus& other)
+  {
+    fullscanSteps += other.fullscanSteps;
+    sorts += other.sorts;
+    autoIndexes += other.autoIndexes;
+    vmSteps += other.vmSteps;
+    reprepares += other.reprepares;
+    runs += other.runs;
+    memUsed = max(memUsed, other.memUsed);   // not a counter
+
+    return *this;
+  }
+
+  //----------------------------------------------------------------------------
+
+  ConnectionStats& ConnectionStats::operator+=(const ConnectionStats& other)
+  {
+    cacheHits += other.cacheHits;
+    cacheMisses += other.cacheMisses;
+    cacheWrites += other.cacheWrites;
+    cacheSpills += other.cacheSpills;
+    cacheUsed += other.cacheUsed;
+    lookasideUsed += other.lookasideUsed;
+    lookasideHighwater = max(lookasideHighwater, other.lookasideHighwater);
+    lookasideHits += other.lookasideHits;
+    lookasideMissSize += other.lookasideMissSize;
+    lookasideMissFull += other.lookasideMissFull;
+    schemaUsed += other.schemaUsed;
+    stmtUsed += other.stmtUsed;
+    memoryUsed = max(memoryUsed, other.memoryUsed);   // process-wide
+    memoryHighwater = max(memoryHighwater, other.memoryHighwater);   // process-wide
+
+    return *this;
+  }
+
+  //----------------------------------------------------------------------------
+
+  string quoteIdentifier(const string& ident)
+  {
+    string result;
+    result.reserve(ident.size() + 2);
+
+    result += '"';
+    for (char c : ident)
+    {
+      if (c == '"') result += '"';
+      result += c;
+    }
+    result += '"';
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
 
 }
@@ -1,6 +1,8 @@
 #pragma once
 
-#include <string>  // for string
+#include <cstdint>   // for int64_t
+#include <optional>  // for optional
+#include <string>    // for string
 
 namespace SqliteOverlay
 {
@@ -155,6 +157,165 @@ namespace SqliteOverlay
     OpenExisting_RO   ///< open an existing database in read-only mode and fail if it doesn't exist
   };
 
+  //----------------------------------------------------------------------------
+
+  /** \brief The journal mode of a database connection as explained [here](https://www.sqlite.org/pragma.html#pragma_journal_mode)
+   */
+  enum class JournalMode
+  {
+    Delete,   ///< delete the rollback journal at the end of each transaction (SQLite's default)
+    Truncate,   ///< truncate the rollback journal instead of deleting it
+    Persist,   ///< keep the rollback journal but overwrite its header
+    Memory,   ///< keep the rollback journal in memory
+    WAL,   ///< use a write-ahead log instead of a rollback journal
+    Off   ///< no journal at all; unsafe, transactions can't be rolled back reliably
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief The synchronization level for writes as explained [here](https://www.sqlite.org/pragma.html#pragma_synchronous)
+   */
+  enum class SynchronousMode
+  {
+    Off,   ///< hand off data to the OS and continue without syncing
+    Normal,   ///< sync at critical moments only; safe in WAL mode
+    Full,   ///< sync after each transaction (SQLite's default)
+    Extra   ///< like `Full` but also syncs the directory after unlinking a rollback journal
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Storage location for temporary tables and indices as explained [here](https://www.sqlite.org/pragma.html#pragma_temp_store)
+   */
+  enum class TempStore
+  {
+    Default,   ///< use the compile-time default
+    File,   ///< store temporary data in files
+    Memory   ///< store temporary data in memory
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief The locking mode of a database connection as explained [here](https://www.sqlite.org/pragma.html#pragma_locking_mode)
+   */
+  enum class LockingMode
+  {
+    Normal,   ///< release locks at the end of each transaction
+    Exclusive   ///< never release locks once they have been acquired
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Performance related settings that are applied when a database
+   * connection is opened.
+   *
+   * All settings that are not set (empty optionals) are left at SQLite's defaults.
+   *
+   * A default-constructed instance resembles the traditional behavior of
+   * SqliteDatabase: foreign keys enabled, synchronous writes disabled and
+   * everything else untouched.
+   *
+   * \note `journalMode` and `pageSize` are not applied to read-only connections;
+   * `pageSize` is only applied to new, empty database files.
+   */
+  struct OpenOptions
+  {
+    std::optional<JournalMode> journalMode;   ///< the journal mode, e.g. WAL
+    std::optional<SynchronousMode> synchronous{SynchronousMode::Off};   ///< the sync level for writes
+    std::optional<int64_t> mmapSize;   ///< max number of bytes for memory-mapped I/O; 0 disables mmap
+    std::optional<int> cacheSize;   ///< the page cache size; positive values are pages, negative values are KiB
+    std::optional<int> pageSize;   ///< the page size in bytes for new database files; has to be a power of two between 512 and 65536
+    std::optional<TempStore> tempStore;   ///< the storage location of temporary tables and indices
+    std::optional<int> busyTimeout_ms;   ///< the busy timeout in milliseconds
+    std::optional<LockingMode> lockingMode;   ///< the locking mode
+    bool foreignKeys{true};   ///< enable or disable the enforcement of foreign key constraints
+    bool serializedAccess{false};   ///< open the connection with `SQLITE_OPEN_FULLMUTEX`; only effective if passed to the `SqliteDatabase` ctor
+
+    /** \returns a preset for many concurrent short read/write transactions:
+     * WAL, synchronous NORMAL, 16 MiB cache, 256 MiB mmap, temp data in memory, 5 s busy timeout
+     */
+    static OpenOptions OLTP();
+
+    /** \returns a preset for connections that mostly read:
+     * WAL, synchronous NORMAL, 64 MiB cache, 1 GiB mmap, temp data in memory, 5 s busy timeout
+     */
+    static OpenOptions ReadMostly();
+
+    /** \returns a preset for a single connection that loads large amounts of data:
+     * in-memory journal, no syncing, 256 MiB cache, temp data in memory, exclusive locking.
+     *
+     * \warning This trades durability for speed. A crash during the
+     * load may corrupt the database file.
+     */
+    static OpenOptions BulkLoad();
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief The performance counters of a prepared statement,
+   * see [here](https://www.sqlite.org/c3ref/c_stmtstatus_counter.html)
+   */
+  struct StatementStatus
+  {
+    int64_t fullscanSteps{0};   ///< number of forward steps in full table scans; large values hint at missing indices
+    int64_t sorts{0};   ///< number of sort operations; may hint at missing indices for ORDER BY
+    int64_t autoIndexes{0};   ///< number of rows inserted into automatic (transient) indices; hints at missing indices
+    int64_t vmSteps{0};   ///< number of virtual machine operations; a deterministic measure for the total work
+    int64_t reprepares{0};   ///< number of automatic re-preparations, e.g. due to schema changes
+    int64_t runs{0};   ///< number of completed runs
+    int64_t memUsed{0};   ///< approximate number of heap bytes used by the statement (not a counter)
+
+    StatementStatus& operator+=(const StatementStatus& other);
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Memory and page cache statistics of a connection, see
+   * [here](https://www.sqlite.org/c3ref/c_dbstatus_options.html) and
+   * [here](https://www.sqlite.org/c3ref/c_status_malloc_count.html)
+   */
+  struct ConnectionStats
+  {
+    int64_t cacheHits{0};   ///< number of page cache hits
+    int64_t cacheMisses{0};   ///< number of page cache misses; many misses compared to hits indicate a too small `cache_size`
+    int64_t cacheWrites{0};   ///< number of dirty pages that have been written to disk
+    int64_t cacheSpills{0};   ///< number of dirty pages that had to be written in the middle of a transaction because the cache was full
+    int64_t cacheUsed{0};   ///< heap bytes used by the page cache (not a counter)
+    int64_t lookasideUsed{0};   ///< number of lookaside slots that are currently in use (not a counter)
+    int64_t lookasideHighwater{0};   ///< max number of lookaside slots that have been in use at the same time
+    int64_t lookasideHits{0};   ///< number of allocations that were satisfied from lookaside memory
+    int64_t lookasideMissSize{0};   ///< number of allocations that missed the lookaside memory because they were too large
+    int64_t lookasideMissFull{0};   ///< number of allocations that missed the lookaside memory because all slots were in use
+    int64_t schemaUsed{0};   ///< heap bytes used for storing the schema (not a counter)
+    int64_t stmtUsed{0};   ///< heap bytes used by all prepared statements of the connection (not a counter)
+    int64_t memoryUsed{0};   ///< heap bytes currently allocated by SQLite in the whole process (not a counter)
+    int64_t memoryHighwater{0};   ///< max heap bytes ever allocated by SQLite in the whole process
+
+    /** \returns the ratio of cache hits to all cache accesses or 0 if there were no accesses
+     */
+    double cacheHitRatio() const
+    {
+      const int64_t total = cacheHits + cacheMisses;
+      return (total == 0) ? 0.0 : static_cast<double>(cacheHits) / total;
+    }
+
+    /** \brief Accumulates the values of several connections; process-wide values
+     * and highwater marks are not summed up but take the maximum
+     */
+    ConnectionStats& operator+=(const ConnectionStats& other);
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Wraps an identifier (e.g., a column name) in double quotes
+   * and doubles all embedded double quotes
+   *
+   * Example: `my"col` --> `"my""col"`
+   *
+   * \returns the quoted identifier that can safely be used in SQL text
+   */
+  std::string quoteIdentifier(const std::string& ident);
+
 }
 
 namespace std
@@ -190,5 +351,21 @@ namespace std
    */
   std::string to_string(SqliteOverlay::ConflictClause cc);
 
+  //----------------------------------------------------------------------------
+
+  std::string to_string(SqliteOverlay::JournalMode jm);
+
+  //----------------------------------------------------------------------------
+
+  std::string to_string(SqliteOverlay::SynchronousMode sm);
+
+  //----------------------------------------------------------------------------
+
+  std::string to_string(SqliteOverlay::TempStore ts);
+
+  //----------------------------------------------------------------------------
+
+  std::string to_string(SqliteOverlay::LockingMode lm);
+
 }
 
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <stddef.h>                 // for size_t
+#include <array>                    // for array
+#include <optional>                 // for optional, nullopt_t
+#include <string_view>              // for string_view
+#include <type_traits>              // for is_same_v, remove_cvref_t
+#include <utility>                  // for forward
+
+#include "SqlStatement.h"           // for SqlStatement
+#include "TypeTraits.h"             // for IsOptional
+
+namespace SqliteOverlay
+{
+  enum class ColumnValueComparisonOp {
+    Equals,
+    NotEqual,
+    LessThan,
+    LessThanOrEqual,
+    GreaterThan,
+    GreaterThanOrEqual,
+    Null,
+    NotNull
+  };
+
+  constexpr std::array<std::string_view, 8> ComparisonOp2String {
+    std::string_view{"="},
+    std::string_view{"!="},
+    std::string_view{"<"},
+    std::string_view{"<="},
+    std::string_view{">"},
+    std::string_view{">="},
+    std::string_view{" IS NULL"},
+    std::string_view{" IS NOT NULL"},
+  };
+}
+
+/** \brief Compile-time SQL generation for GenericView and GenericTable
+ *
+ * A query "shape" is described by types, e.g.
+ *
+ * ```
+ * using namespace SqliteOverlay::Sql;
+ * using W = Or<Eq<Col::intCol>, And<Between<Col::realCol>, In<Col::stringCol, 2>>>;
+ * auto objs = tab.objectsWhere<W, OrderBy<Desc<Col::realCol>>>(42, 1.0, 2.0, "a", "b");
+ * ```
+ *
+ * Column names, operators and placeholders are known at compile time, so the
+ * complete SQL text is generated by the compiler as a fixed-size string. At
+ * runtime, the text is only used as key for the connection's statement cache;
+ * a cache hit costs a hash lookup but no string building, no allocation and no
+ * call to `sqlite3_prepare()`.
+ *
+ * Parameters are bound in the order of their placeholders in the condition
+ * (depth-first, left to right). Passing `std::nullopt` or an empty optional binds NULL.
+ */
+namespace SqliteOverlay::Sql
+{
+  /** \brief A string of fixed length that can be created at compile time
+   */
+  template<size_t N>
+  struct FixedString
+  {
+    std::array<char, N + 1> buf{};   // zero-terminated
+
+    constexpr std::string_view view() const { return std::string_view{buf.data(), N}; }
+    constexpr const char* c_str() const { return buf.data(); }
+    static constexpr size_t size() { return N; }
+  };
+
+  /** \brief Emits SQL fragments; if `out` is `nullptr`, only the length is counted
+   */
+  struct SqlWriter
+  {
+    char* out{nullptr};
+    size_t len{0};
+
+    constexpr void put(std::string_view s)
+    {
+      if (out == nullptr)
+      {
+        len += s.size();
+        return;
+      }
+      for (char c : s) out[len++] = c;
+    }
+
+    constexpr void putInt(size_t v)
+    {
+      char digits[20]{};
+      int n{0};
+      do
+      {
+        digits[n++] = static_cast<char>('0' + (v % 10));
+        v /= 10;
+      } while (v > 0);
+      while (n > 0) put(std::string_view{&digits[--n], 1});
+    }
+  };
+
+  /** \returns the column name for a column enum value of an adapter class
+   */
+  template<class AC, auto col>
+  constexpr std::string_view colName()
+  {
+    static_assert (std::is_same_v<decltype(col), typename AC::Col>, "column enum doesn't belong to this table");
+    return AC::ColDefs[static_cast<int>(col)].name;
+  }
+
+  //----------------------------------------------------------------------------
+
+  /** \brief "col op ?" or, for `Null` / `NotNull`, "col IS [NOT] NULL"
+   */
+  template<auto col, ColumnValueComparisonOp op = ColumnValueComparisonOp::Equals>
+  struct Cmp
+  {
+    static constexpr bool hasParam = (op != ColumnValueComparisonOp::Null) && (op != ColumnValueComparisonOp::NotNull);
+    static constexpr size_t nParams = hasParam ? 1 : 0;
+
+    template<class AC>
+    static constexpr void emit(SqlWriter& w)
+    {
+      w.put(colName<AC, col>());
+      w.put(ComparisonOp2String[static_cast<int>(op)]);
+      if constexpr (hasParam) w.put("?");
+    }
+  };
+
+  template<auto col> using Eq = Cmp<col, ColumnValueComparisonOp::Equals>;
+  template<auto col> using Ne = Cmp<col, ColumnValueComparisonOp::NotEqual>;
+  template<auto col> using Lt = Cmp<col, ColumnValueComparisonOp::LessThan>;
+  template<auto col> using Le = Cmp<col, ColumnValueComparisonOp::LessThanOrEqual>;
+  template<auto col> using Gt = Cmp<col, ColumnValueComparisonOp::GreaterThan>;
+  template<auto col> using Ge = Cmp<col, ColumnValueComparisonOp::GreaterThanOrEqual>;
+  template<auto col> using IsNull = Cmp<col, ColumnValueComparisonOp::Null>;
+  template<auto col> using NotNull = Cmp<col, ColumnValueComparisonOp::NotNull>;
+
+  /** \brief "col IN (?,?,...)" with `n` placeholders
+   */
+  template<auto col, size_t n>
+  struct In
+  {
+    static_assert (n > 0, "IN requires at least one value");
+    static constexpr size_t nParams = n;
+
+    template<class AC>
+    static constexpr void emit(SqlWriter& w)
+    {
+      w.put(colName<AC, col>());
+      w.put(" IN (?");
+      for (size_t i = 1; i < n; ++i) w.put(",?");
+      w.put(")");
+    }
+  };
+
+  /** \brief "col BETWEEN ? AND ?"
+   */
+  template<auto col>
+  struct Between
+  {
+    static constexpr size_t nParams = 2;
+
+    template<class AC>
+    static constexpr void emit(SqlWriter& w)
+    {
+      w.put(colName<AC, col>());
+      w.put(" BETWEEN ? AND ?");
+    }
+  };
+
+  /** \brief Joins several conditions with a logical operator and wraps them in parentheses
+   */
+  template<bool isAnd, class ... Conds>
+  struct Junction
+  {
+    static_assert (sizeof...(Conds) > 0, "AND / OR require at least one condition");
+    static constexpr size_t nParams = (Conds::nParams + ...);
+
+    template<class AC>
+    static constexpr void emit(SqlWriter& w)
+    {
+      w.put("(");
+      bool isFirst{true};
+      auto emitOne = [&]<class C>() {
+        if (!isFirst) w.put(isAnd ? " AND " : " OR ");
+        isFirst = false;
+        C::template emit<AC>(w);
+      };
+      (emitOne.template operator()<Conds>(), ...);
+      w.put(")");
+    }
+  };
+
+  template<class ... Conds> using And = Junction<true, Conds...>;
+  template<class ... Conds> using Or = Junction<false, Conds...>;
+
+  //----------------------------------------------------------------------------
+
+  /** \brief An ascending sort key for `OrderBy` */
+  template<auto col>
+  struct Asc
+  {
+    template<class AC>
+    static constexpr void emit(SqlWriter& w) { w.put(colName<AC, col>()); w.put(" ASC"); }
+  };
+
+  /** \brief A descending sort key for `OrderBy` */
+  template<auto col>
+  struct Desc
+  {
+    template<class AC>
+    static constexpr void emit(SqlWriter& w) { w.put(colName<AC, col>()); w.put(" DESC"); }
+  };
+
+  /** \brief "ORDER BY key1,key2,..." with `Asc` or `Desc` keys
+   */
+  template<class ... Keys>
+  struct OrderBy
+  {
+    static_assert (sizeof...(Keys) > 0, "ORDER BY requires at least one key");
+
+    template<class AC>
+    static constexpr void emit(SqlWriter& w)
+    {
+      w.put(" ORDER BY ");
+      bool isFirst{true};
+      auto emitOne = [&]<class K>() {
+        if (!isFirst) w.put(",");
+        isFirst = false;
+        K::template emit<AC>(w);
+      };
+      (emitOne.template operator()<Keys>(), ...);
+    }
+  };
+
+  /** \brief No particular order */
+  struct Unordered
+  {
+    template<class AC>
+    static constexpr void emit(SqlWriter&) {}
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief "SELECT <all cols> FROM <tab>" */
+  struct SelectHead
+  {
+    template<class AC>
+    static constexpr void emit(SqlWriter& w) { w.put("SELECT "); w.put(AC::FullSelectColList); w.put(" FROM "); w.put(AC::TabName); }
+  };
+
+  /** \brief "SELECT col1,col2,... FROM <tab>" */
+  template<auto ... cols>
+  struct ColumnsHead
+  {
+    static_assert (sizeof...(cols) > 0, "SELECT requires at least one column");
+
+    template<class AC>
+    static constexpr void emit(SqlWriter& w)
+    {
+      w.put("SELECT ");
+      bool isFirst{true};
+      auto emitOne = [&]<auto col>() {
+        if (!isFirst) w.put(",");
+        isFirst = false;
+        w.put(colName<AC, col>());
+      };
+      (emitOne.template operator()<cols>(), ...);
+      w.put(" FROM ");
+      w.put(AC::TabName);
+    }
+  };
+
+  /** \brief "SELECT COUNT(*) FROM <tab>" */
+  struct CountHead
+  {
+    template<class AC>
+    static constexpr void emit(SqlWriter& w) { w.put("SELECT COUNT(*) FROM "); w.put(AC::TabName); }
+  };
+
+  /** \brief "DELETE FROM <tab>" */
+  struct DeleteHead
+  {
+    template<class AC>
+    static constexpr void emit(SqlWriter& w) { w.put("DELETE FROM "); w.put(AC::TabName); }
+  };
+
+  /** \brief " WHERE <condition>" */
+  template<class Cond>
+  struct WherePart
+  {
+    template<class AC>
+    static constexpr void emit(SqlWriter& w) { w.put(" WHERE "); Cond::template emit<AC>(w); }
+  };
+
+  /** \brief " LIMIT n"; nothing for `n == 0` */
+  template<size_t n>
+  struct LimitPart
+  {
+    template<class AC>
+    static constexpr void emit(SqlWriter& w)
+    {
+      if constexpr (n > 0)
+      {
+        w.put(" LIMIT ");
+        w.putInt(n);
+      }
+    }
+  };
+
+  /** \brief The complete SQL text for a sequence of parts, generated at compile time
+   */
+  template<class AC, class ... Parts>
+  struct CompiledSql
+  {
+    static constexpr size_t length = []() {
+      SqlWriter w;
+      (Parts::template emit<AC>(w), ...);
+      return w.len;
+    }();
+
+    static constexpr FixedString<length> text = []() {
+      FixedString<length> fs;
+      SqlWriter w{fs.buf.data()};
+      (Parts::template emit<AC>(w), ...);
+      return fs;
+    }();
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Binds all values to the statement, starting at parameter 1;
+   * `std::nullopt` and empty optionals bind NULL
+   */
+  template<typename ... Args>
+  void bindAll(SqlStatement& stmt, Args&& ... args)
+  {
+    int idx{1};
+    auto bindOne = [&]<typename T>(T&& val) {
+      using BareT = std::remove_cvref_t<T>;
+      if constexpr (std::is_same_v<BareT, std::nullopt_t>)
+      {
+        stmt.bindNull(idx);
+      } else if constexpr (detail::IsOptional<BareT>::value) {
+        if (val.has_value()) stmt.bind(idx, *val);
+        else stmt.bindNull(idx);
+      } else {
+        stmt.bind(idx, std::forward<T>(val));
+      }
+      ++idx;
+    };
+    (bindOne(std::forward<Args>(args)), ...);
+  }
+}
@@ -3,12 +3,20 @@
 #include <string_view>
 #include <string>
 #include <array>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <vector>
 
 #include <Sloppy/ResultOrError.h>
 
+#include "ColumnarFetch.h"
+#include "GenericQuery.h"
 #include "SqliteDatabase.h"
 #include "SqlStatement.h"
 #include "TableCreator.h"
+#include "Transaction.h"
 
 namespace SqliteOverlay {
   struct ForeignKeyDescription {
@@ -51,26 +59,80 @@ namespace SqliteOverlay {
         { T::bindToStmt(obj, stmt) };   // we need a function that binds values of a database object to an SQL statement
       };
 
-  enum class ColumnValueComparisonOp {
-    Equals,
-    NotEqual,
-    LessThan,
-    LessThanOrEqual,
-    GreaterThan,
-    GreaterThanOrEqual,
-    Null,
-    NotNull
-  };
+  // A lazy input range over the results of a SELECT statement; each
+  // increment calls sqlite3_step() and converts only the current row into
+  // a DbObj. Destroying the range (e.g., after `views::take()` or a `break`)
+  // resets the statement, so there's no need to fetch the remaining rows.
+  //
+  // The range is a move-only view and composes with the standard views. It must not
+  // be moved after `begin()` has been called because iterators refer to the range.
+  template<ViewAdapterClass AC>
+  class ObjStream : public std::ranges::view_interface<ObjStream<AC>> {
+  public:
+    using DbObj = typename AC::DbObj;
+
+    class iterator {
+    public:
+      using value_type = DbObj;
+      using difference_type = std::ptrdiff_t;
+      using iterator_concept = std::input_iterator_tag;
+
+      iterator() = default;
+
+      const DbObj& operator*() const { return *(parent->curObj); }
+      const DbObj* operator->() const { return &(*(parent->curObj)); }
+
+      iterator& operator++() {
+        parent->advance();
+        return *this;
+      }
+      void operator++(int) { ++(*this); }
+
+      friend bool operator==(const iterator& it, std::default_sentinel_t) {
+        return it.isAtEnd();
+      }
+
+    private:
+      friend class ObjStream;
+      explicit iterator(ObjStream* p) : parent{p} {}
+
+      bool isAtEnd() const {
+        return ((parent == nullptr) || !(parent->curObj.has_value()));
+      }
+
+      ObjStream* parent{nullptr};
+    };
+
+    explicit ObjStream(SqliteOverlay::SqlStatement&& _stmt)
+      : stmt{std::move(_stmt)} {}
+
+    ObjStream(ObjStream&& other) = default;
+    ObjStream& operator=(ObjStream&& other) = default;
+    ObjStream(const ObjStream& other) = delete;
+    ObjStream& operator=(const ObjStream& other) = delete;
 
-  constexpr std::array<std::string_view, 8> ComparisonOp2String {
-    std::string_view{"="},
-    std::string_view{"!="},
-    std::string_view{"<"},
-    std::string_view{"<="},
-    std::string_view{">"},
-    std::string_view{">="},
-    std::string_view{" IS NULL"},
-    std::string_view{" IS NOT NULL"},
+    iterator begin() {
+      if (!isStarted) {
+        isStarted = true;
+        advance();
+      }
+      return iterator{this};
+    }
+
+    std::default_sentinel_t end() const { return std::default_sentinel; }
+
+  private:
+    void advance() {
+      if (stmt.dataStep()) {
+        curObj = AC::fromSelectStmt(stmt);
+      } else {
+        curObj.reset();
+      }
+    }
+
+    SqliteOverlay::SqlStatement stmt;
+    std::optional<DbObj> curObj;
+    bool isStarted{false};
   };
 
   template<ViewAdapterClass AC>
@@ -83,6 +145,9 @@ namespace SqliteOverlay {
     using ObjList = std::vector<DbObj>;
     using OptOpject = std::optional<DbObj>;
 
+    template<Col col>
+    using ColumnarType = typename ColumnarTypeFor<AC::ColDefs[static_cast<int>(col)].dataType>::type;
+
     explicit GenericView(SqliteOverlay::SqliteDatabase* db) noexcept
       : dbPtr{db}
       , sqlBaseSelect{
@@ -144,6 +209,97 @@ namespace SqliteOverlay {
 
     //-------------------------------------------------------------------------------------------------
 
+    // the following queries take their shape (columns, operators, order)
+    // as template parameters and use SQL that is generated at compile time;
+    // see GenericQuery.h
+
+    template<class Cond, class Order = Sql::Unordered, typename ...Args>
+    ObjList objectsWhere(Args&& ... params) const {
+      using Q = Sql::CompiledSql<AC, Sql::SelectHead, Sql::WherePart<Cond>, Order>;
+      auto stmt = prepQuery<Q, Cond>(std::forward<Args>(params)...);
+      return stmt2ObjectList(stmt);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<class Cond, class Order = Sql::Unordered, typename ...Args>
+    OptOpject singleObjectWhere(Args&& ... params) const {
+      using Q = Sql::CompiledSql<AC, Sql::SelectHead, Sql::WherePart<Cond>, Order, Sql::LimitPart<1>>;
+      auto stmt = prepQuery<Q, Cond>(std::forward<Args>(params)...);
+      return stmt2SingleObject(stmt);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<class Cond, typename ...Args>
+    int objCountWhere(Args&& ... params) const {
+      using Q = Sql::CompiledSql<AC, Sql::CountHead, Sql::WherePart<Cond>>;
+      auto stmt = prepQuery<Q, Cond>(std::forward<Args>(params)...);
+      if (!stmt.dataStep()) return -1;  // should never happen
+      return stmt.template get<int>(0);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<class Cond, typename ...Args>
+    bool hasWhere(Args&& ... params) const {
+      return (objCountWhere<Cond>(std::forward<Args>(params)...) > 0);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<class Order>
+    ObjList allObjOrdered() const {
+      using Q = Sql::CompiledSql<AC, Sql::SelectHead, Order>;
+      auto stmt = dbPtr->prepCachedStatement(Q::text.view());
+      return stmt2ObjectList(stmt);
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // lazy counterparts of allObj(), objectsByColumnValue() and objectsWhere();
+    // see ObjStream
+
+    ObjStream<AC> streamAllObj() const {
+      return ObjStream<AC>{dbPtr->prepStatement(sqlBaseSelect)};
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<typename ...Args>
+    ObjStream<AC> streamObjectsByColumnValue(Col col, Args&& ... whereArgs) const {
+      return ObjStream<AC>{stmtWithWhere(sqlBaseSelect, 0, 1, col, std::forward<Args>(whereArgs)...)};
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<class Cond, class Order = Sql::Unordered, typename ...Args>
+    ObjStream<AC> streamObjectsWhere(Args&& ... params) const {
+      using Q = Sql::CompiledSql<AC, Sql::SelectHead, Sql::WherePart<Cond>, Order>;
+      return ObjStream<AC>{prepQuery<Q, Cond>(std::forward<Args>(params)...)};
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    // columnar fetch of selected columns; the C++ type of each
+    // buffer is derived from the column's declared data type
+
+    template<Col ... cols>
+    auto columnarReader(size_t chunkSize = DefaultColumnarChunkSize) const {
+      using Q = Sql::CompiledSql<AC, Sql::ColumnsHead<cols...>>;
+      return ColumnarReader<ColumnarType<cols>...>{dbPtr->prepCachedStatement(Q::text.view()), chunkSize};
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
+    template<class Cond, Col ... cols, typename ...Args>
+    auto columnarReaderWhere(size_t chunkSize, Args&& ... params) const {
+      using Q = Sql::CompiledSql<AC, Sql::ColumnsHead<cols...>, Sql::WherePart<Cond>>;
+      return ColumnarReader<ColumnarType<cols>...>{prepQuery<Q, Cond>(std::forward<Args>(params)...), chunkSize};
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
     static std::string colNameFromEnum(Col col) {
       return std::string{AC::ColDefs[static_cast<int>(col)].name};
     }
@@ -293,6 +449,18 @@ namespace SqliteOverlay {
 
     //-------------------------------------------------------------------------------------------------
 
+    template<class Q, class Cond, typename ...Args>
+    SqliteOverlay::SqlStatement prepQuery(Args&& ... params) const {
+      static_assert (sizeof...(Args) == Cond::nParams, "the number of values doesn't match the number of placeholders");
+
+      auto stmt = dbPtr->prepCachedStatement(Q::text.view());
+      Sql::bindAll(stmt, std::forward<Args>(params)...);
+
+      return stmt;
+    }
+
+    //-------------------------------------------------------------------------------------------------
+
     template<typename ...Args>
     SqliteOverlay::SqlStatement stmtWithWhere(const std::string& baseSql, int limit, int firstWhereParaIdx, Col col, Args&& ... whereArgs) const {
       std::string sql = baseSql + " WHERE ";
@@ -302,12 +470,9 @@ namespace SqliteOverlay {
         sql += " LIMIT " + std::to_string(limit);
       }
 
-      std::cout << sql << std::endl;
-
       auto stmt = dbPtr->prepStatement(sql);
       recursiveWhereBuilder_bindStep(stmt, firstWhereParaIdx, col, std::forward<Args>(whereArgs)...);
 
-      std::cout << stmt.getExpandedSQL() << "\n" << std::endl;
       return stmt;
     }
 
@@ -390,7 +555,6 @@ namespace SqliteOverlay {
       // NULL so that we get an SQLite-defined ID
       AC::bindToStmt(obj, stmt);
       stmt.bindNull(1);
-      std::cout << stmt.getExpandedSQL() << std::endl;
 
       stmt.step();  // always suceeds; might throw, though
 
@@ -399,6 +563,118 @@ namespace SqliteOverlay {
 
     //---------------------------------------------------------------
 
+    // inserts all objects with a single prepared statement; if `useTransaction` is `true`
+    // and no transaction is active, all inserts are wrapped in a new transaction.
+    // Returns the new IDs in the order of the objects.
+    template<std::ranges::input_range R>
+    requires std::convertible_to<std::ranges::range_reference_t<R>, const DbObj&>
+    std::vector<IdType> insertMany(R&& objs, bool useTransaction = true) const {
+      std::vector<IdType> result;
+      if constexpr (std::ranges::sized_range<R>) {
+        result.reserve(std::ranges::size(objs));
+      }
+
+      auto tr = startBatchTransaction(useTransaction);
+      auto stmt = this->dbPtr->prepCachedStatement(sqlBaseInsert);
+      for (const DbObj& obj : objs) {
+        AC::bindToStmt(obj, stmt);
+        stmt.bindNull(1);
+        stmt.step();  // always suceeds; might throw, though
+        stmt.reset(false);
+
+        result.push_back(IdType{this->dbPtr->getLastInsertId()});
+      }
+      if (tr) tr->commit();
+
+      return result;
+    }
+
+    //---------------------------------------------------------------
+
+    // overwrites all objects with a single prepared statement; if `useTransaction` is `true`
+    // and no transaction is active, all updates are wrapped in a new transaction.
+    // Returns the number of modified rows.
+    template<std::ranges::input_range R>
+    requires std::convertible_to<std::ranges::range_reference_t<R>, const DbObj&>
+    int overwriteMany(R&& objs, bool useTransaction = true) const {
+      int result{0};
+
+      auto tr = startBatchTransaction(useTransaction);
+      auto stmt = this->dbPtr->prepCachedStatement(sqlOverwriteUpdate);
+      for (const DbObj& obj : objs) {
+        AC::bindToStmt(obj, stmt);
+        stmt.step();  // always suceeds; might throw, though
+        stmt.reset(false);
+
+        result += this->dbPtr->getRowsAffected();
+      }
+      if (tr) tr->commit();
+
+      return result;
+    }
+
+    //---------------------------------------------------------------
+
+    // deletes all objects with the given IDs; the IDs are bound to a single
+    // "IN (?,?,...)" statement that is only split if the list exceeds the
+    // max number of SQL variables. Returns the number of deleted rows.
+    template<std::ranges::input_range R>
+    requires std::convertible_to<std::ranges::range_reference_t<R>, const IdType&>
+    int deleteMany(R&& ids, bool useTransaction = true) const {
+      std::vector<int> rawIds;
+      if constexpr (std::ranges::sized_range<R>) {
+        rawIds.reserve(std::ranges::size(ids));
+      }
+      for (const IdType& id : ids) {
+        if constexpr (std::is_same_v<IdType, int>) {
+          rawIds.push_back(id);
+        } else {
+          rawIds.push_back(id.get());
+        }
+      }
+      if (rawIds.empty()) return 0;
+
+      const size_t maxVars = static_cast<size_t>(this->dbPtr->getLimit(SQLITE_LIMIT_VARIABLE_NUMBER));
+      const size_t chunkSize = std::min(rawIds.size(), maxVars);
+
+      auto sqlForChunk = [&](size_t n) {
+        std::string sql = sqlBaseDelete + " WHERE " + std::string{AC::ColDefs[0].name} + " IN (?";
+        sql.reserve(sql.size() + 2 * n);
+        for (size_t i = 1; i < n; ++i) sql += ",?";
+        sql += ")";
+        return sql;
+      };
+
+      int result{0};
+      auto tr = startBatchTransaction(useTransaction);
+      std::optional<SqliteOverlay::SqlStatement> fullChunkStmt;
+      for (size_t first = 0; first < rawIds.size(); first += chunkSize) {
+        const size_t n = std::min(chunkSize, rawIds.size() - first);
+
+        SqliteOverlay::SqlStatement partialChunkStmt;
+        SqliteOverlay::SqlStatement* stmt{&partialChunkStmt};
+        if (n == chunkSize) {
+          if (!fullChunkStmt) fullChunkStmt = this->dbPtr->prepStatement(sqlForChunk(n));
+          stmt = &(*fullChunkStmt);
+        } else {
+          partialChunkStmt = this->dbPtr->prepStatement(sqlForChunk(n));
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+          stmt->bind(static_cast<int>(i + 1), rawIds[first + i]);
+        }
+        stmt->step();  // always suceeds; might throw, though
+        stmt->reset(false);
+
+        result += this->dbPtr->getRowsAffected();
+      }
+      if (tr) tr->commit();
+
+      return result;
+    }
+
+    //---------------------------------------------------------------
+
     int del(const IdType& id) const {
       auto stmt = this->dbPtr->prepStatement(sqlBaseDeleteById);
 
@@ -425,6 +701,17 @@ namespace SqliteOverlay {
 
     //---------------------------------------------------------------
 
+    template<class Cond, typename ...Args>
+    int delWhere(Args&& ... params) const {
+      using Q = Sql::CompiledSql<AC, Sql::DeleteHead, Sql::WherePart<Cond>>;
+      auto stmt = this->template prepQuery<Q, Cond>(std::forward<Args>(params)...);
+
+      stmt.step();  // always suceeds; might throw, though
+      return this->dbPtr->getRowsAffected();
+    }
+
+    //---------------------------------------------------------------
+
     template<typename ...Args>
     bool updateObject(const IdType& id, Args&& ... columnValuePairs) const {
       std::string sql = sqlBaseUpdate;
@@ -438,7 +725,6 @@ namespace SqliteOverlay {
 
       auto stmt = this->dbPtr->prepStatement(sql);
       recursiveValueBinder(stmt, 1, std::forward<Args>(columnValuePairs)...);
-      std::cout << stmt.getExpandedSQL() << std::endl;
 
       stmt.step();  // always suceeds; might throw, though
       return (this->dbPtr->getRowsAffected() != 0);
@@ -456,7 +742,6 @@ namespace SqliteOverlay {
       } else {
         stmt.bind(1, std::forward<T>(val));
       }
-      std::cout << stmt.getExpandedSQL() << std::endl;
 
       stmt.step();  // always suceeds; might throw, though
       return this->dbPtr->getRowsAffected();
@@ -474,7 +759,6 @@ namespace SqliteOverlay {
       } else {
         stmt.bind(1, std::forward<T>(val));
       }
-      std::cout << stmt.getExpandedSQL() << std::endl;
 
       stmt.step();  // always suceeds; might throw, though
       return this->dbPtr->getRowsAffected();
@@ -485,7 +769,6 @@ namespace SqliteOverlay {
     bool overwrite(const DbObj& obj) const {
       auto stmt = this->dbPtr->prepStatement(sqlOverwriteUpdate);
       AC::bindToStmt(obj, stmt);
-      std::cout << stmt.getExpandedSQL() << std::endl;
 
       stmt.step();  // always suceeds; might throw, though
       return (this->dbPtr->getRowsAffected() != 0);
@@ -518,6 +801,14 @@ namespace SqliteOverlay {
 
   protected:
 
+    std::optional<SqliteOverlay::Transaction> startBatchTransaction(bool useTransaction) const {
+      std::optional<SqliteOverlay::Transaction> tr;
+      if (useTransaction && this->dbPtr->isAutoCommit()) {
+        tr.emplace(this->dbPtr, SqliteOverlay::TransactionType::Immediate, SqliteOverlay::TransactionDtorAction::Rollback);
+      }
+      return tr;
+    }
+
     // Laufende Iteration mit  "Col = Val" und Nachfolgespalte
     template<class T, typename ...Args>
     void recursiveUpdateBuilder_langStep(std::string& s, int nextParaIdx, Col col, T&& val, Args&& ... args) const {
@@ -0,0 +1,238 @@
+#include <algorithm>                // for max
+#include <stdexcept>                // for invalid_argument, logic_error
+
+#include "Transaction.h"            // for Transaction
+
+#include "GroupCommitQueue.h"
+
+using namespace std;
+
+namespace SqliteOverlay
+{
+  GroupCommitQueueBase::GroupCommitQueueBase(unique_ptr<SqliteDatabase>&& _db, size_t _maxBatchSize, chrono::microseconds _maxDelay)
+    :SingleConnectionWorker{std::move(_db), "GroupCommitQueue"}, maxBatchSize{_maxBatchSize}, maxDelay{_maxDelay}
+  {
+    if (maxBatchSize == 0)
+    {
+      throw std::invalid_argument("GroupCommitQueue: max batch size must be positive");
+    }
+
+    startWorker([this]() { writerLoop(); });
+  }
+
+  //----------------------------------------------------------------------------
+
+  OpenOptions GroupCommitQueueBase::defaultOpenOptions()
+  {
+    OpenOptions result;
+    result.synchronous = SynchronousMode::Full;
+    result.busyTimeout_ms = DefaultBusyTimeout_ms;
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  OpenOptions GroupCommitQueueBase::withQueueDefaults(const OpenOptions& oo)
+  {
+    OpenOptions result{oo};
+    if (!result.busyTimeout_ms) result.busyTimeout_ms = DefaultBusyTimeout_ms;
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  GroupCommitQueueBase::~GroupCommitQueueBase()
+  {
+    // the writer drains the queue before it terminates
+    requestStop();
+    joinWorker();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void GroupCommitQueueBase::flush()
+  {
+    unique_lock<mutex> lk{mtx};
+
+    const size_t target = nEnqueued;
+    ++nFlushWaiters;
+    workCv.notify_all();
+    doneCv.wait(lk, [&]() { return nFinished >= target; });
+    --nFlushWaiters;
+  }
+
+  //----------------------------------------------------------------------------
+
+  GroupCommitStats GroupCommitQueueBase::stats() const
+  {
+    lock_guard<mutex> lg{mtx};
+
+    return counters;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void GroupCommitQueueBase::writerLoop()
+  {
+    unique_lock<mutex> lk{mtx};
+
+    while (true)
+    {
+      workCv.wait(lk, [this]() { return isStopping || !queue.empty(); });
+
+      // when stopping, we only terminate after the queue has been drained
+      if (queue.empty()) return;
+
+      runBatch(lk);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void GroupCommitQueueBase::runBatch(unique_lock<mutex>& lk)
+  {
+    // we enter and leave with the lock held
+
+    const auto deadline = chrono::steady_clock::now() + maxDelay;
+    size_t nBatch{0};
+    size_t nFailed{0};
+    vector<unique_ptr<Job>> executed;   // jobs that wait for the commit
+
+    lk.unlock();
+    optional<Transaction> tr;
+    exception_ptr batchErr;
+    try
+    {
+      tr.emplace(db.get(), TransactionType::Immediate, TransactionDtorAction::Rollback);
+    }
+    catch (...)
+    {
+      batchErr = current_exception();
+    }
+    lk.lock();
+
+    // execute jobs until the window closes
+    while (!batchErr && (nBatch < maxBatchSize))
+    {
+      if (queue.empty())
+      {
+        if (isStopping || (nFlushWaiters > 0)) break;
+
+        const bool hasWork = workCv.wait_until(lk, deadline, [this]() {
+          return !queue.empty() || isStopping || (nFlushWaiters > 0);
+        });
+        if (!hasWork) break;   // the time window has closed
+        continue;
+      }
+
+      unique_ptr<Job> job = std::move(queue.front());
+      queue.pop_front();
+      ++nBatch;
+      lk.unlock();
+
+      // each job gets its own savepoint so that a failing job
+      // doesn't affect the other jobs in the batch
+      try
+      {
+        db->execNonQuery("SAVEPOINT GroupCommitJob");
+        job->run(*db);
+        db->execNonQuery("RELEASE GroupCommitJob");
+        executed.push_back(std::move(job));
+      }
+      catch (...)
+      {
+        job->fail(current_exception());
+        ++nFailed;
+
+        try
+        {
+          db->execNonQuery("ROLLBACK TO GroupCommitJob");
+          db->execNonQuery("RELEASE GroupCommitJob");
+        }
+        catch (...)
+        {
+          // the job has messed up the transaction (e.g., by
+          // issuing a ROLLBACK); we can't continue with this batch
+          batchErr = current_exception();
+        }
+      }
+
+      lk.lock();
+    }
+
+    // if BEGIN failed, we fail at least the first job
+    // (and everything else that would have been part of the batch)
+    if (!tr.has_value())
+    {
+      while (!queue.empty() && (executed.size() < maxBatchSize))
+      {
+        executed.push_back(std::move(queue.front()));
+        queue.pop_front();
+      }
+      nBatch = executed.size();
+    } else {
+      lk.unlock();
+
+      if (!batchErr)
+      {
+        try
+        {
+          tr->commit();
+        }
+        catch (...)
+        {
+          batchErr = current_exception();
+        }
+      }
+
+      if (batchErr)
+      {
+        // the transaction is lost; try to clean up but don't care about
+        // errors because the transaction might be gone already. Even then
+        // we call rollback() because the failing ROLLBACK marks the
+        // Transaction as finished and thus keeps its dtor from throwing
+        try
+        {
+          tr->rollback();
+        }
+        catch (...) {}
+      }
+
+      tr.reset();
+      lk.lock();
+    }
+    if (batchErr) nFailed += executed.size();
+
+    // update the counters before resolving the futures so that
+    // submitters see consistent stats as soon as their future is ready
+    if (batchErr)
+    {
+      ++counters.nFailedCommits;
+    } else {
+      ++counters.nCommits;
+    }
+    counters.nJobs += nBatch - nFailed;
+    counters.nFailedJobs += nFailed;
+    counters.maxBatchSize = max(counters.maxBatchSize, nBatch);
+    lk.unlock();
+
+    for (auto& job : executed)
+    {
+      if (batchErr)
+      {
+        job->fail(batchErr);
+      } else {
+        job->committed();
+      }
+    }
+
+    lk.lock();
+    nFinished += nBatch;
+    doneCv.notify_all();
+  }
+
+  //----------------------------------------------------------------------------
+
+}
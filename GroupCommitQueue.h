@@ -0,0 +1,272 @@
+#pragma once
+
+#include <stddef.h>                 // for size_t
+#include <chrono>                   // for microseconds, steady_clock
+#include <condition_variable>       // for condition_variable
+#include <exception>                // for exception_ptr
+#include <functional>               // for function, invoke
+#include <future>                   // for future, promise
+#include <memory>                   // for unique_ptr, make_unique
+#include <mutex>                    // for mutex
+#include <optional>                 // for optional
+#include <string>                   // for string
+#include <type_traits>              // for invoke_result_t, is_void_v
+#include <utility>                  // for move, forward
+#include <vector>                   // for vector
+
+#include "Defs.h"                   // for OpenMode, OpenOptions
+#include "SingleConnectionWorker.h" // for SingleConnectionWorker
+#include "SqliteDatabase.h"         // for SqliteDatabase
+
+namespace SqliteOverlay
+{
+  /** \brief Counters of a GroupCommitQueue
+   */
+  struct GroupCommitStats
+  {
+    size_t nCommits{0};   ///< number of successfully committed transactions
+    size_t nFailedCommits{0};   ///< number of transactions that could not be started or committed
+    size_t nJobs{0};   ///< number of jobs that have been committed
+    size_t nFailedJobs{0};   ///< number of jobs that failed (incl. those of failed commits)
+    size_t maxBatchSize{0};   ///< the largest number of jobs in a single transaction
+  };
+
+  /** \brief A unit of work that is executed inside a shared transaction
+   */
+  struct GroupCommitJob
+  {
+    virtual ~GroupCommitJob() = default;
+
+    /** \brief Executes the job on the writer thread; may throw */
+    virtual void run(SqliteDatabase& db) = 0;
+
+    /** \brief Called after the transaction that contains the job has been committed; must not throw */
+    virtual void committed() = 0;
+
+    /** \brief Called if the job itself or the whole transaction failed; must not throw */
+    virtual void fail(std::exception_ptr err) = 0;
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Non-template part of GroupCommitQueue: the writer
+   * thread and the batching logic.
+   */
+  class GroupCommitQueueBase : public SingleConnectionWorker<GroupCommitJob>
+  {
+  public:
+    /** \brief The busy timeout of the writer connection unless `OpenOptions::busyTimeout_ms` is set */
+    static constexpr int DefaultBusyTimeout_ms{5000};
+
+    /** \returns the OpenOptions that are used if the caller doesn't provide any:
+     * synchronous FULL (a resolved future means that the data is on disk) and
+     * a busy timeout of `DefaultBusyTimeout_ms`
+     *
+     * Test case: yes
+     *
+     */
+    static OpenOptions defaultOpenOptions();
+
+    /** \brief Dtor; commits everything that has been submitted so far,
+     * stops the writer thread and closes the connection
+     */
+    virtual ~GroupCommitQueueBase();
+
+    /** \brief Closes the current commit window immediately and blocks until all jobs
+     * that have been submitted before the call have been committed (or have failed)
+     *
+     * Test case: yes
+     *
+     */
+    void flush();
+
+    /** \returns a copy of the queue's counters
+     *
+     * Test case: yes
+     *
+     */
+    GroupCommitStats stats() const;
+
+  protected:
+    using Job = GroupCommitJob;
+
+    /** \brief Takes ownership of the connection and starts the writer thread
+     *
+     * \throws std::invalid_argument if the max batch size is zero
+     */
+    GroupCommitQueueBase(
+        std::unique_ptr<SqliteDatabase>&& _db,
+        size_t _maxBatchSize,
+        std::chrono::microseconds _maxDelay
+        );
+
+    /** \brief Adds the default busy timeout if the options don't specify one;
+     * without it, a single reader of another connection lets the whole batch fail
+     */
+    static OpenOptions withQueueDefaults(const OpenOptions& oo);
+
+  private:
+    void writerLoop();
+
+    /** \brief Runs a single batch; called with the lock held, returns with the lock held
+     */
+    void runBatch(std::unique_lock<std::mutex>& lk);
+
+    const size_t maxBatchSize;
+    const std::chrono::microseconds maxDelay;
+    GroupCommitStats counters;
+    size_t nFinished{0};   // total number of committed or failed jobs
+    size_t nFlushWaiters{0};
+    std::condition_variable doneCv;   // signals finished batches to flush()
+  };
+
+  //----------------------------------------------------------------------------
+
+  /** \brief A single writer thread that executes write jobs of many submitters
+   * in shared transactions ("group commit").
+   *
+   * Instead of each thread opening its own write transaction, which competes
+   * for the database lock and pays for its own sync to disk, all writes go through
+   * one queue and one connection:
+   *
+   *   * the writer thread takes the first pending job and opens a commit window
+   *     with `BEGIN IMMEDIATE`;
+   *   * all jobs that arrive while the window is open are executed in the same
+   *     transaction, each in its own savepoint;
+   *   * the window closes after `maxBatchSize` jobs, after `maxDelay` or when
+   *     `flush()` is called; the transaction is then committed.
+   *
+   * Every submitter receives a future that is resolved only after the
+   * transaction containing its job has been committed. If a job throws, only its own
+   * savepoint is rolled back and its future receives the exception; the other jobs
+   * of the batch are not affected. If the commit itself fails, all jobs of the
+   * batch fail.
+   *
+   * ```
+   * GroupCommitQueue<> q{"my.db", 100, std::chrono::milliseconds{2}};
+   * auto f = q.submit([](SqliteDatabase& db) {
+   *   DbTab t{db, "t1", false};
+   *   return t.insertRow(cvc);
+   * });
+   * int newId = f.get();   // returns after the COMMIT
+   * ```
+   *
+   * \note Since all writes are serialized on application level, the jobs never run
+   * into SQLITE_BUSY among each other. Other connections that write to the same
+   * database still compete for the lock.
+   *
+   * \note Jobs must not issue `BEGIN`, `COMMIT` or `ROLLBACK` themselves; nested
+   * Transaction objects are fine because they turn into savepoints.
+   *
+   * \note How "durable" a commit is depends on the `synchronous` setting of the connection.
+   * Without explicit OpenOptions, the queue uses `defaultOpenOptions()` (synchronous FULL).
+   * Caller-provided OpenOptions are used as they are, except for a default busy timeout;
+   * note that a default-constructed `OpenOptions{}` disables syncing.
+   *
+   * \note All public methods are thread-safe.
+   */
+  template<class DB_CLASS = SqliteDatabase>
+  class GroupCommitQueue : public GroupCommitQueueBase
+  {
+    static_assert (std::is_base_of_v<SqliteDatabase, DB_CLASS>);
+
+  public:
+    /** \brief Ctor; opens the connection on the calling thread and starts the writer thread
+     *
+     * \throws std::invalid_argument if the max batch size is zero
+     *
+     * \throws GenericSqliteException incl. error code if anything goes wrong
+     * with SQLite when opening the connection
+     *
+     * Test case: yes
+     *
+     */
+    GroupCommitQueue(
+        const std::string& dbFilename,   ///< the name of the database file
+        size_t maxBatchSize = 1000,   ///< the max number of jobs per transaction
+        std::chrono::microseconds maxDelay = std::chrono::milliseconds{2},   ///< the max time a commit window stays open
+        OpenMode om = OpenMode::OpenExisting_RW,   ///< the opening mode for the connection (use a RW-mode here)
+        std::function<void(DB_CLASS&)> initFunc = nullptr,   ///< an optional function that is called for the new connection before the writer starts
+        const OpenOptions& openOptions = defaultOpenOptions()   ///< performance settings for the connection; a missing busy timeout is replaced by `DefaultBusyTimeout_ms`
+        )
+      :GroupCommitQueueBase{openConnection<DB_CLASS>(dbFilename, om, initFunc, withQueueDefaults(openOptions)), maxBatchSize, maxDelay} {}
+
+    /** \brief Queues a write job
+     *
+     * \throws std::logic_error if the queue is shutting down
+     *
+     * \returns a future that receives the job's return value after the transaction
+     * has been committed, or the exception of the job or of the commit
+     *
+     * Test case: yes
+     *
+     */
+    template<class F>
+    auto submit(
+        F&& f   ///< a callable that takes a `DB_CLASS&`
+        ) -> std::future<std::invoke_result_t<F, DB_CLASS&>>
+    {
+      using R = std::invoke_result_t<F, DB_CLASS&>;
+
+      auto job = std::make_unique<FuncJob<R, std::decay_t<F>>>(std::forward<F>(f));
+      auto fut = job->promise.get_future();
+      enqueue(std::move(job));
+
+      return fut;
+    }
+
+    /** \brief Queues a batch of SQL statements that are executed in the given order
+     * as a single job, e.g., a set of INSERTs or UPDATEs
+     *
+     * \throws std::logic_error if the queue is shutting down
+     *
+     * \returns a future that is resolved after the transaction has been committed
+     *
+     * Test case: yes
+     *
+     */
+    std::future<void> submitBatch(
+        std::vector<std::string> sqlStatements   ///< the statements of the batch
+        )
+    {
+      return submit([stmts = std::move(sqlStatements)](DB_CLASS& d) {
+        for (const std::string& sql : stmts) d.execNonQuery(sql);
+      });
+    }
+
+  protected:
+    template<typename R, class F>
+    struct FuncJob : public Job
+    {
+      explicit FuncJob(F _f)
+        :f{std::move(_f)} {}
+
+      void run(SqliteDatabase& d) override
+      {
+        if constexpr (std::is_void_v<R>)
+        {
+          std::invoke(f, static_cast<DB_CLASS&>(d));
+        } else {
+          result.emplace(std::invoke(f, static_cast<DB_CLASS&>(d)));
+        }
+      }
+
+      void committed() override
+      {
+        if constexpr (std::is_void_v<R>)
+        {
+          promise.set_value();
+        } else {
+          promise.set_value(std::move(*result));
+        }
+      }
+
+      void fail(std::exception_ptr err) override { promise.set_exception(err); }
+
+      F f;
+      std::optional<std::conditional_t<std::is_void_v<R>, bool, R>> result;
+      std::promise<R> promise;
+    };
+  };
+
+}
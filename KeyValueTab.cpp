@@ -18,6 +18,7 @@
 
 #include <sys/types.h>                                  // for time_t
 #include <algorithm>                                    // for max
+#include <chrono>                                       // for steady_clock
 #include <cstdint>                                      // for int64_t
 #include <iosfwd>                                       // for std
 #include <stdexcept>                                    // for invalid_argument
@@ -66,6 +67,28 @@ namespace SqliteOverlay
   {
     if (key.empty()) return false;
 
+    if (cache)
+    {
+      lock_guard<mutex> lg{cache->mtx};
+      validateCache_NoLock();
+
+      auto it = cache->entries.find(key);
+      if (it != cache->entries.end())
+      {
+        ++(it->second.exists ? cache->stats.nHits : cache->stats.nNegativeHits);
+        return it->second.exists;
+      }
+
+      // the entry is only stored after the fetch succeeded
+      ++cache->stats.nMisses;
+      CacheEntry fetched;
+      fetchIntoCache_NoLock(key, fetched);
+      const bool result = fetched.exists;
+      cache->entries.emplace(key, std::move(fetched));
+
+      return result;
+    }
+
     return (tab.getMatchCountForColumnValue(KeyColName, key) > 0);
   }
 
@@ -166,6 +189,107 @@ namespace SqliteOverlay
     return result;
   }
 
+  //----------------------------------------------------------------------------
+
+  void KeyValueTab::enableCache(chrono::milliseconds externalCheckInterval)
+  {
+    auto c = make_shared<ValueCache>();
+    c->localWrites = db->getTableWriteCounter(tabName);
+    c->seenLocalWrites = c->localWrites->load(memory_order_acquire);
+    c->dataVersionStmt = db->prepStatement("PRAGMA data_version");
+    c->seenDataVersion = readDataVersion(c->dataVersionStmt);
+    c->externalCheckInterval = externalCheckInterval;
+    c->lastExternalCheck = chrono::steady_clock::now();
+
+    cache = c;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void KeyValueTab::disableCache()
+  {
+    cache.reset();
+  }
+
+  //----------------------------------------------------------------------------
+
+  KeyValueCacheStats KeyValueTab::cacheStats() const
+  {
+    if (!cache) return KeyValueCacheStats{};
+
+    lock_guard<mutex> lg{cache->mtx};
+    return cache->stats;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void KeyValueTab::validateCache_NoLock() const
+  {
+    // local modifications, reported by the update hook
+    const uint64_t nWrites = cache->localWrites->load(memory_order_acquire);
+    bool isStale = (nWrites != cache->seenLocalWrites);
+
+    // modifications by other connections; the query may throw, so
+    // we don't update any state before it succeeded
+    bool needsExternalCheck{true};
+    const auto now = chrono::steady_clock::now();
+    if (cache->externalCheckInterval.count() > 0)
+    {
+      needsExternalCheck = ((now - cache->lastExternalCheck) >= cache->externalCheckInterval);
+    }
+    if (needsExternalCheck)
+    {
+      const int dataVersion = readDataVersion(cache->dataVersionStmt);
+      if (dataVersion != cache->seenDataVersion)
+      {
+        cache->seenDataVersion = dataVersion;
+        isStale = true;
+      }
+      cache->lastExternalCheck = now;
+    }
+    cache->seenLocalWrites = nWrites;
+
+    if (isStale && !cache->entries.empty())
+    {
+      cache->entries.clear();
+      ++cache->stats.nInvalidations;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  int KeyValueTab::readDataVersion(SqlStatement& stmt)
+  {
+    try
+    {
+      stmt.step();
+      const int result = stmt.get<int>(0);
+      stmt.reset(false);
+
+      return result;
+    }
+    catch (...)
+    {
+      // after a failed step(), reset() reports the same error
+      // again; we only need the statement to be usable again
+      try { stmt.reset(false); } catch (GenericSqliteException&) {}
+      throw;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  SqlStatement KeyValueTab::fetchIntoCache_NoLock(const string& key, CacheEntry& e) const
+  {
+    auto stmt = db->prepStatement(sqlSelect);
+    stmt.bind(1, key);
+    stmt.step();
+
+    e.exists = stmt.hasData();
+    e.isNull = e.exists && stmt.isNull(0);
+
+    return stmt;
+  }
 
   //----------------------------------------------------------------------------
   //----------------------------------------------------------------------------
@@ -18,11 +18,17 @@
 
 #pragma once
 
-#include <stdint.h>                                     // for int64_t
+#include <stddef.h>                                     // for size_t
+#include <stdint.h>                                     // for int64_t, uint64_t
+#include <any>                                          // for any, any_cast
+#include <atomic>                                       // for atomic
+#include <chrono>                                       // for milliseconds
 #include <functional>                                   // for reference_wra...
-#include <memory>                                       // for unique_ptr
+#include <memory>                                       // for unique_ptr, shared_ptr
+#include <mutex>                                        // for mutex, lock_guard
 #include <optional>                                     // for optional
 #include <string>                                       // for string
+#include <unordered_map>                                // for unordered_map
 #include <vector>                                       // for vector
 
 #include <Sloppy/ConfigFileParser/ConstraintChecker.h>  // for ValueConstraint
@@ -31,11 +37,22 @@
 
 #include "DbTab.h"                                      // for DbTab
 #include "SqlStatement.h"                               // for SqlStatement
+#include "SqliteExceptions.h"                           // for NoDataException, NullValueException
 
 namespace SqliteOverlay
 {
   class SqliteDatabase;
 
+  /** \brief Counters of the value cache of a KeyValueTab
+   */
+  struct KeyValueCacheStats
+  {
+    size_t nHits{0};   ///< lookups that have been served from the cache
+    size_t nNegativeHits{0};   ///< lookups of non-existing keys that have been served from the cache
+    size_t nMisses{0};   ///< lookups that required a database query
+    size_t nInvalidations{0};   ///< number of times the cache has been flushed because of table modifications
+  };
+
   /** \brief A convience object that treats a given table as a key-value-store
    * and eases creating and retrieval of keys and values.
    *
@@ -47,6 +64,9 @@ namespace SqliteOverlay
    * statements that trigger errors when trying to close the underlying database.
    *
    * Caching is DISABLED by default.
+   *
+   * Independent of the statement cache, there is an optional value cache (see
+   * `enableCache()`) that turns repeated lookups of the same keys into hash map reads.
    */
   class KeyValueTab
   {
@@ -104,6 +124,8 @@ namespace SqliteOverlay
         const std::string& key   ///< the key's name
         )
     {
+      if (cache) return *getCached<T>(key, true);
+
       auto stmt = db->prepStatement(sqlSelect);
       stmt.bind(1, key);
       stmt.step();
@@ -121,6 +143,8 @@ namespace SqliteOverlay
         const std::string& key   ///< the key's name
         )
     {
+      if (cache) return getCached<T>(key, false);
+
       try {
         auto stmt = db->prepStatement(sqlSelect);
         stmt.bind(1, key);
@@ -174,6 +198,61 @@ namespace SqliteOverlay
      */
     std::vector<std::string> allKeys() const;
 
+    /** \brief Enables a read-through cache for `get()`, `get2()` and `hasKey()`
+     *
+     * The cache stores the decoded values of all keys that have been read so far,
+     * including the information that a key does not exist ("negative cache"). A
+     * cached lookup is a hash map read plus, if `externalCheckInterval` is zero,
+     * a single step of a prepared `PRAGMA data_version` statement.
+     *
+     * The cache is flushed:
+     *
+     *   * whenever the table is modified through the same database connection,
+     *     no matter whether the change is done by this or another KeyValueTab instance or
+     *     by plain SQL; this is detected via the update hook (see
+     *     `SqliteDatabase::getTableWriteCounter()` for the limitations);
+     *   * whenever `PRAGMA data_version` indicates that another connection has
+     *     modified the database. This check happens on every lookup if `externalCheckInterval`
+     *     is zero; otherwise it happens at most once per interval and lookups may
+     *     return values that are up to `externalCheckInterval` old. If the database
+     *     is only written through this connection, a long interval is safe.
+     *
+     * Copies of the instance that are made after enabling the cache share the cache.
+     * The cache holds a prepared statement; like any other SqlStatement, it has to be
+     * released (`disableCache()` or destruction of all sharing instances) before the
+     * database connection can be closed.
+     *
+     * Calling the function with an already enabled cache flushes the cache and
+     * applies the new interval.
+     *
+     * Test case: yes
+     *
+     */
+    void enableCache(
+        std::chrono::milliseconds externalCheckInterval = std::chrono::milliseconds{0}   ///< the min time between two checks for external modifications
+        );
+
+    /** \brief Disables and discards the value cache
+     *
+     * Test case: yes
+     *
+     */
+    void disableCache();
+
+    /** \returns `true` if the value cache is enabled
+     *
+     * Test case: yes
+     *
+     */
+    bool isCacheEnabled() const { return (cache != nullptr); }
+
+    /** \returns the counters of the value cache or all zeros if the cache is disabled
+     *
+     * Test case: yes
+     *
+     */
+    KeyValueCacheStats cacheStats() const;
+
   private:
     SqliteDatabase* db;
     std::string tabName;
@@ -181,6 +260,98 @@ namespace SqliteOverlay
     std::string sqlSelect;
     std::string sqlUpdate;
     std::string sqlInsert;
+
+    struct CacheEntry
+    {
+      bool exists{false};
+      bool isNull{false};
+      std::vector<std::any> decoded;   // the value, decoded into each of the types that have been requested
+    };
+
+    struct ValueCache
+    {
+      std::unordered_map<std::string, CacheEntry> entries;
+      std::shared_ptr<const std::atomic<uint64_t>> localWrites;
+      SqlStatement dataVersionStmt;   // a persistent "PRAGMA data_version"
+      uint64_t seenLocalWrites{0};
+      int seenDataVersion{0};
+      std::chrono::milliseconds externalCheckInterval{0};
+      std::chrono::steady_clock::time_point lastExternalCheck;
+      KeyValueCacheStats stats;
+      std::mutex mtx;
+    };
+    std::shared_ptr<ValueCache> cache;
+
+    // flushes the cache if the table has been modified; requires the cache lock
+    void validateCache_NoLock() const;
+
+    // executes the prepared "PRAGMA data_version" statement; requires the cache lock
+    static int readDataVersion(SqlStatement& stmt);
+
+    // reads a key from the database into a cache entry; requires the
+    // cache lock. Returns the statement for decoding the value.
+    SqlStatement fetchIntoCache_NoLock(const std::string& key, CacheEntry& e) const;
+
+    template<typename T>
+    std::optional<T> getCached(const std::string& key, bool throwIfMissing)
+    {
+      std::lock_guard<std::mutex> lg{cache->mtx};
+      validateCache_NoLock();
+
+      auto it = cache->entries.find(key);
+      if (it != cache->entries.end())
+      {
+        const CacheEntry& e = it->second;
+        if (!e.exists)
+        {
+          ++cache->stats.nNegativeHits;
+          if (throwIfMissing) throw NoDataException{"KeyValueTab::get()"};
+          return std::nullopt;
+        }
+        if (e.isNull)
+        {
+          ++cache->stats.nHits;
+          if (throwIfMissing) throw NullValueException{"KeyValueTab::get()"};
+          return std::nullopt;
+        }
+        for (const std::any& a : e.decoded)
+        {
+          if (const T* v = std::any_cast<T>(&a); v != nullptr)
+          {
+            ++cache->stats.nHits;
+            return *v;
+          }
+        }
+      }
+
+      // not yet cached or not yet decoded into the requested type;
+      // the entry is only stored after fetching and decoding succeeded
+      ++cache->stats.nMisses;
+      CacheEntry fetched;
+      auto stmt = fetchIntoCache_NoLock(key, fetched);
+      const bool exists = fetched.exists;
+      std::optional<T> val;
+      if (exists && !fetched.isNull)
+      {
+        val = stmt.get<T>(0);
+        fetched.decoded.emplace_back(*val);
+      }
+
+      if ((it != cache->entries.end()) && val.has_value())
+      {
+        it->second.decoded.push_back(std::move(fetched.decoded.back()));
+      } else {
+        cache->entries.insert_or_assign(key, std::move(fetched));
+      }
+
+      if (val.has_value()) return val;
+      if (throwIfMissing)
+      {
+        if (!exists) throw NoDataException{"KeyValueTab::get()"};
+        throw NullValueException{"KeyValueTab::get()"};
+      }
+      return std::nullopt;
+    }
   };  
 
   //----------------------------------------------------------------------------
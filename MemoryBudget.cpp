@@ -0,0 +1,181 @@
+#include <algorithm>                // for find_if
+#include <stdexcept>                // for invalid_argument
+
+#include <sqlite3.h>                // for sqlite3_soft_heap_limit64, ...
+
+#include "SqliteDatabase.h"         // for SqliteDatabase
+
+#include "MemoryBudget.h"
+
+using namespace std;
+
+namespace SqliteOverlay
+{
+  MemoryBudgetManager& MemoryBudgetManager::instance()
+  {
+    static MemoryBudgetManager mgr;
+    return mgr;
+  }
+
+  //----------------------------------------------------------------------------
+
+  int64_t MemoryBudgetManager::setSoftHeapLimit(int64_t nBytes)
+  {
+    if (nBytes < 0)
+    {
+      throw std::invalid_argument("setSoftHeapLimit(): negative limit");
+    }
+
+    return sqlite3_soft_heap_limit64(nBytes);
+  }
+
+  //----------------------------------------------------------------------------
+
+  int64_t MemoryBudgetManager::setHardHeapLimit(int64_t nBytes)
+  {
+    if (nBytes < 0)
+    {
+      throw std::invalid_argument("setHardHeapLimit(): negative limit");
+    }
+
+    return sqlite3_hard_heap_limit64(nBytes);
+  }
+
+  //----------------------------------------------------------------------------
+
+  int64_t MemoryBudgetManager::softHeapLimit() const
+  {
+    // a negative value only queries the current limit
+    return sqlite3_soft_heap_limit64(-1);
+  }
+
+  //----------------------------------------------------------------------------
+
+  int64_t MemoryBudgetManager::hardHeapLimit() const
+  {
+    // a negative value only queries the current limit
+    return sqlite3_hard_heap_limit64(-1);
+  }
+
+  //----------------------------------------------------------------------------
+
+  int64_t MemoryBudgetManager::memoryUsed()
+  {
+    return sqlite3_memory_used();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void MemoryBudgetManager::registerConnection(SqliteDatabase& db, const string& label)
+  {
+    if (!db.isAlive())
+    {
+      throw std::invalid_argument("registerConnection(): database connection is closed");
+    }
+
+    lock_guard<mutex> lg{mgrMutex};
+
+    auto it = find_if(entries.begin(), entries.end(), [&db](const Entry& e) { return e.db == &db; });
+    if (it != entries.end())
+    {
+      it->label = label;
+      return;
+    }
+
+    entries.push_back(Entry{&db, label});
+    db.isMemoryManaged = true;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void MemoryBudgetManager::unregisterConnection(SqliteDatabase& db)
+  {
+    lock_guard<mutex> lg{mgrMutex};
+
+    auto it = find_if(entries.begin(), entries.end(), [&db](const Entry& e) { return e.db == &db; });
+    if (it == entries.end()) return;
+
+    entries.erase(it);
+    db.isMemoryManaged = false;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool MemoryBudgetManager::isRegistered(const SqliteDatabase& db) const
+  {
+    lock_guard<mutex> lg{mgrMutex};
+
+    return any_of(entries.begin(), entries.end(), [&db](const Entry& e) { return e.db == &db; });
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t MemoryBudgetManager::connectionCount() const
+  {
+    lock_guard<mutex> lg{mgrMutex};
+
+    return entries.size();
+  }
+
+  //----------------------------------------------------------------------------
+
+  MemoryReleaseResult MemoryBudgetManager::releaseMemory(bool flushCaches, bool clearStatementCaches)
+  {
+    MemoryReleaseResult result;
+    result.memoryBefore = memoryUsed();
+
+    {
+      // holding the lock keeps the connections from
+      // being closed while we're working on them
+      lock_guard<mutex> lg{mgrMutex};
+
+      for (const Entry& e : entries)
+      {
+        result.nStatementsFinalized += e.db->releaseMemory(flushCaches, clearStatementCaches);
+        ++result.nConnections;
+      }
+    }
+
+    result.memoryAfter = memoryUsed();
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  vector<ConnectionMemoryUsage> MemoryBudgetManager::usage() const
+  {
+    lock_guard<mutex> lg{mgrMutex};
+
+    vector<ConnectionMemoryUsage> result;
+    result.reserve(entries.size());
+    for (const Entry& e : entries)
+    {
+      ConnectionMemoryUsage u;
+      u.label = e.label;
+      u.fileName = e.db->filename();
+      u.stats = e.db->stats();
+      u.stmtCache = e.db->getStatementCacheStats();
+      result.push_back(std::move(u));
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void MemoryBudgetManager::replaceConnection(SqliteDatabase* oldDb, SqliteDatabase* newDb)
+  {
+    lock_guard<mutex> lg{mgrMutex};
+
+    auto it = find_if(entries.begin(), entries.end(), [oldDb](const Entry& e) { return e.db == oldDb; });
+    if (it == entries.end()) return;
+
+    it->db = newDb;
+    oldDb->isMemoryManaged = false;
+    newDb->isMemoryManaged = true;
+  }
+
+  //----------------------------------------------------------------------------
+
+}
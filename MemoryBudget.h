@@ -0,0 +1,201 @@
+#pragma once
+
+#include <stddef.h>                 // for size_t
+#include <stdint.h>                 // for int64_t
+#include <mutex>                    // for mutex
+#include <string>                   // for string
+#include <vector>                   // for vector
+
+#include "Defs.h"                   // for ConnectionStats
+#include "StatementCache.h"         // for StatementCacheStats
+
+namespace SqliteOverlay
+{
+  class SqliteDatabase;
+
+  /** \brief The memory usage of a single connection that is registered
+   * with the MemoryBudgetManager
+   */
+  struct ConnectionMemoryUsage
+  {
+    std::string label;   ///< the label that has been provided during registration
+    std::string fileName;   ///< the database file of the connection
+    ConnectionStats stats;   ///< page cache, lookaside and memory statistics of the connection
+    StatementCacheStats stmtCache;   ///< statistics of the connection's statement cache (all zero if disabled)
+  };
+
+  /** \brief The outcome of `MemoryBudgetManager::releaseMemory()`
+   */
+  struct MemoryReleaseResult
+  {
+    size_t nConnections{0};   ///< number of connections that have been asked to release memory
+    size_t nStatementsFinalized{0};   ///< number of idle cached statements that have been finalized
+    int64_t memoryBefore{0};   ///< process-wide heap bytes used by SQLite before releasing memory
+    int64_t memoryAfter{0};   ///< process-wide heap bytes used by SQLite after releasing memory
+
+    /** \returns the number of bytes that have been released (never negative)
+     */
+    int64_t bytesReleased() const { return (memoryAfter < memoryBefore) ? (memoryBefore - memoryAfter) : 0; }
+  };
+
+  /** \brief A process-wide manager that limits SQLite's heap usage and releases
+   * memory of all registered connections on demand.
+   *
+   * The heap limits are passed through to `sqlite3_soft_heap_limit64()` and
+   * `sqlite3_hard_heap_limit64()` and thus apply to all connections in the process.
+   *
+   * Connections register themselves via `registerConnection()` and are automatically
+   * unregistered when they are closed or destroyed; moving a SqliteDatabase keeps the registration.
+   * Under memory pressure, `releaseMemory()` shrinks the footprint of all
+   * registered connections without closing them.
+   *
+   * \note All public methods are thread-safe. Releasing memory of a connection
+   * that is concurrently used by another thread is safe as long as SQLite runs
+   * in serialized threading mode (the default) and as long as the other thread
+   * does not enable or disable the connection's statement cache at the same time.
+   */
+  class MemoryBudgetManager
+  {
+  public:
+    /** \returns the process-wide instance
+     *
+     * Test case: yes
+     *
+     */
+    static MemoryBudgetManager& instance();
+
+    /** \brief Disabled copy ctor */
+    MemoryBudgetManager(const MemoryBudgetManager& other) = delete;
+
+    /** \brief Disabled copy assignment */
+    MemoryBudgetManager& operator=(const MemoryBudgetManager& other) = delete;
+
+    /** \brief Sets the soft heap limit; when it is exceeded, SQLite tries to
+     * free page cache memory before allocating more.
+     *
+     * \throws std::invalid_argument if the limit is negative
+     *
+     * \returns the previous limit (0 = no limit)
+     *
+     * Test case: yes
+     *
+     */
+    int64_t setSoftHeapLimit(
+        int64_t nBytes   ///< the new limit in bytes; 0 disables the limit
+        );
+
+    /** \brief Sets the hard heap limit; allocations that would exceed it
+     * fail with SQLITE_NOMEM.
+     *
+     * \throws std::invalid_argument if the limit is negative
+     *
+     * \returns the previous limit (0 = no limit)
+     *
+     * Test case: yes
+     *
+     */
+    int64_t setHardHeapLimit(
+        int64_t nBytes   ///< the new limit in bytes; 0 disables the limit
+        );
+
+    /** \returns the current soft heap limit (0 = no limit)
+     *
+     * Test case: yes
+     *
+     */
+    int64_t softHeapLimit() const;
+
+    /** \returns the current hard heap limit (0 = no limit)
+     *
+     * Test case: yes
+     *
+     */
+    int64_t hardHeapLimit() const;
+
+    /** \returns the heap bytes that are currently allocated by SQLite in the whole process
+     *
+     * Test case: yes
+     *
+     */
+    static int64_t memoryUsed();
+
+    /** \brief Registers a connection with the manager; registering a connection
+     * twice only updates its label
+     *
+     * \throws std::invalid_argument if the connection is closed
+     *
+     * Test case: yes
+     *
+     */
+    void registerConnection(
+        SqliteDatabase& db,   ///< the connection to register
+        const std::string& label = std::string{}   ///< an optional label that is used in `usage()`
+        );
+
+    /** \brief Removes a connection from the manager; unknown connections are ignored
+     *
+     * Test case: yes
+     *
+     */
+    void unregisterConnection(
+        SqliteDatabase& db   ///< the connection to remove
+        );
+
+    /** \returns `true` if the connection is registered with the manager
+     *
+     * Test case: yes
+     *
+     */
+    bool isRegistered(
+        const SqliteDatabase& db   ///< the connection to check
+        ) const;
+
+    /** \returns the number of registered connections
+     *
+     * Test case: yes
+     *
+     */
+    size_t connectionCount() const;
+
+    /** \brief Shrinks the memory footprint of all registered connections; see
+     * `SqliteDatabase::releaseMemory()`
+     *
+     * \returns the number of affected connections and the process-wide memory usage before and after
+     *
+     * Test case: yes
+     *
+     */
+    MemoryReleaseResult releaseMemory(
+        bool flushCaches = true,   ///< if `true`, dirty pages are written to disk first so that they can be released as well
+        bool clearStatementCaches = true   ///< if `true`, all idle statements in the statement caches are finalized
+        );
+
+    /** \returns the memory usage of all registered connections in the order of their registration
+     *
+     * Test case: yes
+     *
+     */
+    std::vector<ConnectionMemoryUsage> usage() const;
+
+  protected:
+    MemoryBudgetManager() = default;
+
+    /** \brief Replaces a registered connection with its moved-to instance;
+     * called by SqliteDatabase's move ctor and move assignment
+     */
+    void replaceConnection(SqliteDatabase* oldDb, SqliteDatabase* newDb);
+
+  private:
+    friend class SqliteDatabase;
+
+    struct Entry
+    {
+      SqliteDatabase* db;
+      std::string label;
+    };
+
+    std::vector<Entry> entries;
+    mutable std::mutex mgrMutex;
+  };
+
+}
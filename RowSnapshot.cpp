@@ -0,0 +1,210 @@
+#include <cstdlib>                // for strtoll, strtod
+#include <stdexcept>              // for invalid_argument
+#include <string_view>            // for string_view
+
+#include <sqlite3.h>              // for sqlite3_column_xxx, sqlite3_stricmp
+
+#include "SqlStatement.h"         // for SqlStatement
+#include "SqliteDatabase.h"       // for SqliteDatabase
+
+#include "RowSnapshot.h"
+
+using namespace std;
+
+namespace SqliteOverlay
+{
+
+  RowSnapshot::RowSnapshot(const SqliteDatabase& _db, const string& _tabName, int _rowId)
+    :db{cref(_db)}, tabName{_tabName}, rowId{_rowId}
+  {
+    if (tabName.empty() || (rowId < 1))
+    {
+      throw std::invalid_argument("RowSnapshot ctor: empty or invalid parameters");
+    }
+
+    refresh();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void RowSnapshot::refresh()
+  {
+    SqlStatement stmt;
+    try
+    {
+      stmt = db.get().prepStatement("SELECT * FROM " + tabName + " WHERE rowid=?");
+    }
+    catch (SqlStatementCreationError)
+    {
+      throw std::invalid_argument("RowSnapshot: invalid table name");
+    }
+
+    stmt.bind(1, rowId);
+    if (!stmt.dataStep())
+    {
+      throw NoDataException{"RowSnapshot: invalid row ID or row has been deleted"};
+    }
+
+    const int nCols = stmt.nDataColumns();
+
+    // always re-read the column names because a schema change
+    // may rename or reorder columns without changing their number
+    colNames.resize(nCols);
+    for (int colId = 0; colId < nCols; ++colId)
+    {
+      colNames[colId] = stmt.getColName(colId);
+    }
+
+    cells.clear();
+    cells.reserve(nCols);
+    buf.clear();
+
+    for (int colId = 0; colId < nCols; ++colId)
+    {
+      Cell c;
+      c.type = stmt.getColDataType(colId);
+
+      switch (c.type)
+      {
+      case ColumnDataType::Integer:
+        c.intVal = stmt.get<int64_t>(colId);
+        break;
+
+      case ColumnDataType::Float:
+        c.dblVal = stmt.get<double>(colId);
+        break;
+
+      // copy text and blobs directly from SQLite's buffer into ours
+      case ColumnDataType::Text:
+      {
+        const string_view sv = stmt.get<string_view>(colId);
+        c.offset = buf.size();
+        c.len = sv.size();
+        buf.append(sv);
+        break;
+      }
+
+      case ColumnDataType::Blob:
+      {
+        const Sloppy::MemView mv = stmt.get<Sloppy::MemView>(colId);
+        c.offset = buf.size();
+        c.len = mv.byteSize();
+        if (c.len > 0) buf.append(mv.to_charPtr(), c.len);
+        break;
+      }
+
+      default:
+        break;   // NULL, nothing to store
+      }
+
+      cells.push_back(c);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  ColumnDataType RowSnapshot::getColDataType(const string& colName) const
+  {
+    return cell(colName).type;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool RowSnapshot::isNull(const string& colName) const
+  {
+    return (cell(colName).type == ColumnDataType::Null);
+  }
+
+  //----------------------------------------------------------------------------
+
+  const RowSnapshot::Cell& RowSnapshot::cell(const string& colName) const
+  {
+    if (colName.empty())
+    {
+      throw std::invalid_argument("Column access: received empty column name");
+    }
+
+    // a linear search is faster than any hash
+    // map for the typical number of columns in a table
+    for (size_t idx = 0; idx < colNames.size(); ++idx)
+    {
+      if (sqlite3_stricmp(colNames[idx].c_str(), colName.c_str()) == 0)
+      {
+        return cells[idx];
+      }
+    }
+
+    throw std::invalid_argument("Column access: received invalid column name");
+  }
+
+  //----------------------------------------------------------------------------
+
+  int64_t RowSnapshot::toInt64(const Cell& c) const
+  {
+    switch (c.type)
+    {
+    case ColumnDataType::Integer:
+      return c.intVal;
+
+    case ColumnDataType::Float:
+      return static_cast<int64_t>(c.dblVal);
+
+    case ColumnDataType::Text:
+    case ColumnDataType::Blob:
+      return strtoll(toString(c).c_str(), nullptr, 10);
+
+    default:
+      return 0;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  double RowSnapshot::toDouble(const Cell& c) const
+  {
+    switch (c.type)
+    {
+    case ColumnDataType::Integer:
+      return static_cast<double>(c.intVal);
+
+    case ColumnDataType::Float:
+      return c.dblVal;
+
+    case ColumnDataType::Text:
+    case ColumnDataType::Blob:
+      return strtod(toString(c).c_str(), nullptr);
+
+    default:
+      return 0.0;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  string RowSnapshot::toString(const Cell& c) const
+  {
+    switch (c.type)
+    {
+    case ColumnDataType::Integer:
+      return to_string(c.intVal);
+
+    case ColumnDataType::Float:
+    {
+      // use the same format as SQLite's internal REAL-to-TEXT conversion
+      char tmp[32];
+      sqlite3_snprintf(sizeof(tmp), tmp, "%!.15g", c.dblVal);
+      return string{tmp};
+    }
+
+    case ColumnDataType::Text:
+    case ColumnDataType::Blob:
+      return buf.substr(c.offset, c.len);
+
+    default:
+      return string{};
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+}
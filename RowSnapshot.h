@@ -0,0 +1,238 @@
+#pragma once
+
+#include <stddef.h>                       // for size_t
+#include <stdint.h>                       // for int64_t
+#include <functional>                     // for reference_wrapper
+#include <optional>                       // for optional
+#include <string>                         // for string
+#include <type_traits>                    // for is_same_v
+#include <vector>                         // for vector
+
+#include <Sloppy/DateTime/DateAndTime.h>  // for WallClockTimepoint_secs
+#include <Sloppy/DateTime/date.h>         // for year_month_day
+#include <Sloppy/Memory.h>                // for MemArray, MemView
+#include <Sloppy/json.hpp>                // for json
+
+#include "Defs.h"                         // for ColumnDataType
+#include "SqliteExceptions.h"             // for NullValueException
+
+namespace SqliteOverlay
+{
+  class SqliteDatabase;
+
+  /** \brief A local copy of all columns of a single table row, fetched
+   * with a single SELECT statement.
+   *
+   * Reading values from the snapshot does not touch the database at all.
+   * The snapshot does not follow later modifications of the row; call
+   * `refresh()` to re-read the row from the database.
+   *
+   * Values are stored in their native SQLite type. Getters for other
+   * types convert the values similar to SQLite's own conversion rules
+   * (e.g., an integer can be read as a string and vice versa).
+   *
+   * Column names are matched case-insensitively, just like SQLite does.
+   */
+  class RowSnapshot
+  {
+  public:
+    /** \brief Ctor that fetches the contents of the row from the database
+     *
+     * \throws std::invalid_argument if the table name is empty or invalid
+     *
+     * \throws NoDataException if the row does not exist
+     *
+     * \throws BusyException if the database wasn't available for reading the row
+     *
+     * \throws GenericSqliteException incl. error code if anything else goes wrong
+     *
+     * Test case: yes
+     *
+     */
+    RowSnapshot(
+        const SqliteDatabase& _db,   ///< the database that contains the table
+        const std::string& _tabName,   ///< the table name
+        int _rowId   ///< the ID of the row
+        );
+
+    /** \brief Re-reads all columns of the row from the database
+     *
+     * \throws NoDataException if the row does not exist anymore
+     *
+     * \throws BusyException if the database wasn't available for reading the row
+     *
+     * \throws GenericSqliteException incl. error code if anything else goes wrong
+     *
+     * Test case: yes
+     *
+     */
+    void refresh();
+
+    /** \returns the rowid of the row
+     *
+     * Test case: yes
+     *
+     */
+    int id() const { return rowId; }
+
+    /** \returns the number of columns in the snapshot
+     *
+     * Test case: yes
+     *
+     */
+    size_t nColumns() const { return cells.size(); }
+
+    /** \returns the names of all columns in the snapshot in their natural order
+     *
+     * Test case: yes
+     *
+     */
+    const std::vector<std::string>& columnNames() const { return colNames; }
+
+    /** \returns the fundamental SQLite data type of a column in the snapshot
+     *
+     * \throws std::invalid_argument if the column name is invalid
+     *
+     * Test case: yes
+     *
+     */
+    ColumnDataType getColDataType(
+        const std::string& colName   ///< the name of the column to query
+        ) const;
+
+    /** \returns `true` if the column contains NULL
+     *
+     * \throws std::invalid_argument if the column name is invalid
+     *
+     * Test case: yes
+     *
+     */
+    bool isNull(
+        const std::string& colName   ///< the name of the column to query
+        ) const;
+
+    /** \returns a string with the contents of a given column
+     *
+     * \throws std::invalid_argument if the column name is invalid
+     *
+     * \throws NullValueException if the column contained NULL
+     *
+     * Test case: yes
+     *
+     */
+    std::string operator[](
+        const std::string& colName   ///< the name of the column to query
+        ) const
+    {
+      return get<std::string>(colName);
+    }
+
+    /** \returns the contents of a given column in various types
+     *
+     * \throws std::invalid_argument if the column name is invalid
+     *
+     * \throws NullValueException if the column contained NULL
+     *
+     * Test case: yes
+     *
+     */
+    template<typename T>
+    T get(
+        const std::string& colName   ///< the name of the column to query
+        ) const
+    {
+      const Cell& c = cell(colName);
+      if (c.type == ColumnDataType::Null)
+      {
+        throw NullValueException();
+      }
+
+      if constexpr (std::is_same_v<T, int>) {
+        return static_cast<int>(toInt64(c));
+      }
+      else if constexpr (std::is_same_v<T, int64_t>) {
+        return toInt64(c);
+      }
+      else if constexpr (std::is_same_v<T, double>) {
+        return toDouble(c);
+      }
+      else if constexpr (std::is_same_v<T, bool>) {
+        return (toInt64(c) != 0);
+      }
+      else if constexpr (std::is_same_v<T, std::string>) {
+        return toString(c);
+      }
+      else if constexpr (std::is_same_v<T, nlohmann::json>) {
+        return nlohmann::json::parse(toString(c));
+      }
+      else if constexpr (std::is_same_v<T, Sloppy::MemArray>) {
+        if ((c.type != ColumnDataType::Text) && (c.type != ColumnDataType::Blob))
+        {
+          const std::string s = toString(c);
+          return Sloppy::MemArray{Sloppy::MemView{s.c_str(), s.size()}};
+        }
+        if (c.len == 0) return Sloppy::MemArray{};
+        return Sloppy::MemArray{Sloppy::MemView{buf.data() + c.offset, c.len}};  // creates a deep copy
+      }
+      else if constexpr (std::is_same_v<T, Sloppy::DateTime::WallClockTimepoint_secs>) {
+        return Sloppy::DateTime::WallClockTimepoint_secs(static_cast<time_t>(toInt64(c)));
+      }
+      else if constexpr (std::is_same_v<T, date::year_month_day>) {
+        return Sloppy::DateTime::ymdFromInt(static_cast<int>(toInt64(c)));
+      }
+      else {
+        static_assert (!std::is_same_v<T, T>, "Unsupported template parameter for RowSnapshot::get<T>");
+      }
+    }
+
+    /** \returns the contents of a given column in various types or an empty optional in case of NULL
+     *
+     * \throws std::invalid_argument if the column name is invalid
+     *
+     * Test case: yes
+     *
+     */
+    template<typename T>
+    std::optional<T> get2(
+        const std::string& colName   ///< the name of the column to query
+        ) const
+    {
+      if (isNull(colName)) return std::nullopt;
+
+      return get<T>(colName);
+    }
+
+  protected:
+    /** \brief A single value of the row; text and blob data
+     * is stored in the shared buffer `buf`
+     */
+    struct Cell
+    {
+      ColumnDataType type{ColumnDataType::Null};
+      int64_t intVal{0};
+      double dblVal{0.0};
+      size_t offset{0};
+      size_t len{0};
+    };
+
+    /** \returns the cell for a given column name
+     *
+     * \throws std::invalid_argument if the column name is invalid
+     */
+    const Cell& cell(const std::string& colName) const;
+
+    int64_t toInt64(const Cell& c) const;
+    double toDouble(const Cell& c) const;
+    std::string toString(const Cell& c) const;
+
+  private:
+    std::reference_wrapper<const SqliteDatabase> db;
+    std::string tabName;
+    int rowId;
+
+    std::vector<std::string> colNames;
+    std::vector<Cell> cells;
+    std::string buf;   // concatenated text and blob data of all cells
+  };
+
+}
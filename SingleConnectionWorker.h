@@ -0,0 +1,162 @@
+#pragma once
+
+#include <stddef.h>                 // for size_t
+#include <condition_variable>       // for condition_variable
+#include <deque>                    // for deque
+#include <functional>               // for function
+#include <memory>                   // for unique_ptr, make_unique
+#include <mutex>                    // for mutex, lock_guard
+#include <stdexcept>                // for logic_error
+#include <string>                   // for string
+#include <thread>                   // for thread
+#include <type_traits>              // for is_constructible_v
+#include <utility>                  // for move
+
+#include "Defs.h"                   // for OpenMode, OpenOptions
+#include "SqliteDatabase.h"         // for SqliteDatabase
+
+namespace SqliteOverlay
+{
+  /** \brief Opens a connection of type `DB_CLASS` and applies the OpenOptions,
+   * either via the `DB_CLASS` ctor (if it takes OpenOptions) or right after opening
+   *
+   * \throws GenericSqliteException incl. error code if anything goes wrong
+   * with SQLite when opening the connection
+   *
+   * Test case: yes, implicitly by SqliteConnectionPool, AsyncExecutor and GroupCommitQueue
+   *
+   */
+  template<class DB_CLASS>
+  std::unique_ptr<DB_CLASS> openConnectionWithOptions(
+      const std::string& dbFilename,   ///< the name of the database file
+      OpenMode om,   ///< the opening mode
+      const OpenOptions& openOptions   ///< performance settings for the connection
+      )
+  {
+    if constexpr (std::is_constructible_v<DB_CLASS, std::string, OpenMode, OpenOptions>)
+    {
+      return std::make_unique<DB_CLASS>(dbFilename, om, openOptions);
+    } else {
+      auto result = std::make_unique<DB_CLASS>(dbFilename, om);
+      result->applyOpenOptions(openOptions);
+      return result;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  /** \brief Common part of all classes that execute jobs from a queue on a
+   * dedicated thread that exclusively owns a database connection
+   * (AsyncExecutor, GroupCommitQueue)
+   *
+   * The derived class starts the thread with `startWorker()` at the end of its
+   * ctor and stops it with `requestStop()` and `joinWorker()` in its dtor. All
+   * protected members except `db` are guarded by `mtx`.
+   */
+  template<class JobType>
+  class SingleConnectionWorker
+  {
+  public:
+    /** \brief Disabled copy ctor */
+    SingleConnectionWorker(const SingleConnectionWorker& other) = delete;
+
+    /** \brief Disabled copy assignment */
+    SingleConnectionWorker& operator=(const SingleConnectionWorker& other) = delete;
+
+    /** \returns the number of jobs that are waiting for execution (excluding a running job)
+     *
+     * Test case: yes
+     *
+     */
+    size_t pendingCount() const
+    {
+      std::lock_guard<std::mutex> lg{mtx};
+
+      return queue.size();
+    }
+
+  protected:
+    /** \brief Takes ownership of the connection; the thread is not yet started
+     */
+    SingleConnectionWorker(
+        std::unique_ptr<SqliteDatabase>&& _db,   ///< the connection that is used by the worker thread
+        const char* _name   ///< the class name for error messages
+        )
+      :db{std::move(_db)}, name{_name} {}
+
+    /** \brief Dtor; the derived class must have joined the thread already
+     */
+    virtual ~SingleConnectionWorker() = default;
+
+    /** \brief Opens the connection for the worker and calls the init function on it
+     */
+    template<class DB_CLASS>
+    static std::unique_ptr<SqliteDatabase> openConnection(
+        const std::string& dbFilename, OpenMode om, const std::function<void(DB_CLASS&)>& initFunc, const OpenOptions& openOptions)
+    {
+      auto result = openConnectionWithOptions<DB_CLASS>(dbFilename, om, openOptions);
+      if (initFunc) initFunc(*result);
+
+      return result;
+    }
+
+    /** \brief Starts the worker thread with the given loop function
+     */
+    void startWorker(std::function<void()> loop)
+    {
+      worker = std::thread{std::move(loop)};
+    }
+
+    /** \brief Sets `isStopping` and wakes up the worker; new jobs are refused from now on
+     */
+    void requestStop()
+    {
+      {
+        std::lock_guard<std::mutex> lg{mtx};
+        isStopping = true;
+      }
+
+      workCv.notify_all();
+    }
+
+    /** \brief Waits for the worker thread to terminate
+     */
+    void joinWorker()
+    {
+      if (worker.joinable()) worker.join();
+    }
+
+    /** \brief Appends a job to the queue and wakes up the worker
+     *
+     * \throws std::logic_error if the worker is shutting down
+     */
+    void enqueue(std::unique_ptr<JobType>&& job)
+    {
+      {
+        std::lock_guard<std::mutex> lg{mtx};
+
+        if (isStopping)
+        {
+          throw std::logic_error(std::string{name} + ": shutting down");
+        }
+
+        queue.push_back(std::move(job));
+        ++nEnqueued;
+      }
+
+      workCv.notify_one();
+    }
+
+    std::unique_ptr<SqliteDatabase> db;
+    std::deque<std::unique_ptr<JobType>> queue;
+    size_t nEnqueued{0};   // total number of enqueued jobs
+    mutable std::mutex mtx;
+    std::condition_variable workCv;   // signals new jobs and the shutdown to the worker
+    bool isStopping{false};
+
+  private:
+    const char* name;
+    std::thread worker;
+  };
+
+}
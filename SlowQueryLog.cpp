@@ -0,0 +1,209 @@
+#include <time.h>                   // for gmtime_r, strftime
+#include <chrono>                   // for system_clock
+#include <cstdio>                   // for snprintf
+#include <filesystem>               // for rename, remove, file_size
+#include <map>                      // for map
+#include <sstream>                  // for ostringstream
+#include <stdexcept>                // for invalid_argument
+
+#include "SqlMetrics.h"             // for SqlMetricsRegistry
+
+#include "SlowQueryLog.h"
+
+namespace fs = std::filesystem;
+using namespace std;
+
+namespace SqliteOverlay
+{
+  namespace
+  {
+    /** \returns the current UTC time in ISO 8601 format with milliseconds
+     */
+    string nowAsIsoString()
+    {
+      const auto now = chrono::system_clock::now();
+      const time_t t = chrono::system_clock::to_time_t(now);
+      const auto ms = chrono::duration_cast<chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+
+      tm utc{};
+      gmtime_r(&t, &utc);
+      char buf[32];
+      const size_t len = strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &utc);
+
+      char msBuf[8];
+      snprintf(msBuf, sizeof(msBuf), ".%03dZ", static_cast<int>(ms));
+      return string{buf, len} + msBuf;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  SlowQueryLog::SlowQueryLog(const SlowQueryLogOptions& _opts)
+    :opts{_opts}
+  {
+    if (opts.fileName.empty())
+    {
+      throw std::invalid_argument("SlowQueryLog ctor: empty file name");
+    }
+
+    out.open(opts.fileName, ios::out | ios::app | ios::binary);
+    if (!out)
+    {
+      throw std::invalid_argument("SlowQueryLog ctor: could not open " + opts.fileName);
+    }
+
+    error_code ec;
+    const auto sz = fs::file_size(opts.fileName, ec);
+    curFileSize = ec ? 0 : static_cast<size_t>(sz);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SlowQueryLog::write(const SlowQueryEntry& entry)
+  {
+    ostringstream ss;
+    ss << nowAsIsoString()
+       << " duration_ms=" << (static_cast<double>(entry.duration_ns) / 1e6)
+       << " rows=" << entry.nRows << "\n";
+    ss << "fingerprint: " << entry.fingerprint << "\n";
+    ss << "sql: " << entry.expandedSql << "\n";
+    if (entry.queryPlan)
+    {
+      ss << "plan:\n" << *entry.queryPlan;
+    }
+    ss << "\n";
+    const string block = ss.str();
+
+    lock_guard<mutex> lg{logMutex};
+
+    if ((curFileSize > 0) && ((curFileSize + block.size()) > opts.maxFileSize))
+    {
+      rotate_NoLock();
+    }
+
+    out << block;
+    out.flush();
+    curFileSize += block.size();
+    ++nEntries;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SlowQueryLog::logStatement(sqlite3_stmt* stmt, uint64_t duration_ns, uint64_t nRows) noexcept
+  {
+    try
+    {
+      const char* sql = sqlite3_sql(stmt);
+      if (sql == nullptr) return;
+
+      SlowQueryEntry entry;
+      entry.fingerprint = SqlMetricsRegistry::normalize(sql);
+      entry.duration_ns = duration_ns;
+      entry.nRows = nRows;
+
+      char* expanded = sqlite3_expanded_sql(stmt);
+      if (expanded != nullptr)
+      {
+        entry.expandedSql = expanded;
+        sqlite3_free(expanded);
+      } else {
+        entry.expandedSql = sql;
+      }
+
+      if (opts.captureQueryPlan)
+      {
+        bool isNewFingerprint;
+        {
+          lock_guard<mutex> lg{logMutex};
+
+          // the set would grow without bounds for dynamic SQL
+          isNewFingerprint = (fingerprintsWithPlan.size() < opts.maxPlanFingerprints) &&
+                             fingerprintsWithPlan.insert(entry.fingerprint).second;
+        }
+
+        if (isNewFingerprint)
+        {
+          entry.queryPlan = getQueryPlan(sqlite3_db_handle(stmt), sql);
+        }
+      }
+
+      write(entry);
+    }
+    catch (...)
+    {
+      // nothing we can do here; we're called from
+      // within SQLite and must not throw
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t SlowQueryLog::entryCount() const
+  {
+    lock_guard<mutex> lg{logMutex};
+    return nEntries;
+  }
+
+  //----------------------------------------------------------------------------
+
+  string SlowQueryLog::getQueryPlan(sqlite3* db, const string& sql)
+  {
+    if ((db == nullptr) || sql.empty()) return string{};
+
+    // we use the raw API here because we don't want
+    // the plan query to be served from or added to a statement cache
+    sqlite3_stmt* stmt{nullptr};
+    const string planSql = "EXPLAIN QUERY PLAN " + sql;
+    if (sqlite3_prepare_v2(db, planSql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+    {
+      sqlite3_finalize(stmt);
+      return string{};
+    }
+
+    // columns: id, parent, notused, detail
+    map<int, int> depthById;
+    string result;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+    {
+      const int id = sqlite3_column_int(stmt, 0);
+      const int parent = sqlite3_column_int(stmt, 1);
+      const char* detail = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+
+      auto it = depthById.find(parent);
+      const int depth = (it == depthById.end()) ? 0 : (it->second + 1);
+      depthById[id] = depth;
+
+      result += string(2 * (depth + 1), ' ');
+      result += (detail == nullptr) ? "" : detail;
+      result += "\n";
+    }
+    sqlite3_finalize(stmt);
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SlowQueryLog::rotate_NoLock()
+  {
+    out.close();
+
+    error_code ec;
+    if (opts.maxRotatedFiles > 0)
+    {
+      // <name>.N-1 --> <name>.N, ..., <name> --> <name>.1
+      fs::remove(opts.fileName + "." + to_string(opts.maxRotatedFiles), ec);
+      for (int idx = opts.maxRotatedFiles - 1; idx >= 1; --idx)
+      {
+        fs::rename(opts.fileName + "." + to_string(idx), opts.fileName + "." + to_string(idx + 1), ec);
+      }
+      fs::rename(opts.fileName, opts.fileName + ".1", ec);
+    }
+
+    out.open(opts.fileName, ios::out | ios::trunc | ios::binary);
+    curFileSize = 0;
+  }
+
+  //----------------------------------------------------------------------------
+
+}
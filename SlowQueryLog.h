@@ -0,0 +1,133 @@
+#pragma once
+
+#include <stddef.h>                 // for size_t
+#include <stdint.h>                 // for uint64_t
+#include <chrono>                   // for microseconds
+#include <fstream>                  // for ofstream
+#include <mutex>                    // for mutex
+#include <optional>                 // for optional
+#include <string>                   // for string
+#include <unordered_set>            // for unordered_set
+
+#include <sqlite3.h>                // for sqlite3_stmt
+
+#include "SqlMetrics.h"             // for SqlMetricsRegistry
+
+namespace SqliteOverlay
+{
+  /** \brief Settings for a slow-query log file
+   */
+  struct SlowQueryLogOptions
+  {
+    std::string fileName;   ///< the name of the log file
+    size_t maxFileSize{10 * 1024 * 1024};   ///< the log file is rotated before it would exceed this size (in bytes)
+    int maxRotatedFiles{3};   ///< number of rotated files (`<fileName>.1` ... `<fileName>.N`) to keep; 0 = simply truncate the log
+    bool captureQueryPlan{true};   ///< if `true`, the output of EXPLAIN QUERY PLAN is logged once per statement fingerprint
+    size_t maxPlanFingerprints{SqlMetricsRegistry::DefaultCapacity};   ///< no more plans are captured after this number of different fingerprints
+  };
+
+  /** \brief A single slow statement execution
+   */
+  struct SlowQueryEntry
+  {
+    std::string expandedSql;   ///< the SQL text incl. the bound values
+    std::string fingerprint;   ///< the normalized SQL text, see `SqlMetricsRegistry::normalize()`
+    uint64_t duration_ns{0};   ///< the execution time
+    uint64_t nRows{0};   ///< number of returned (queries) or modified (all other statements) rows
+    std::optional<std::string> queryPlan;   ///< the indented query plan tree, if captured
+  };
+
+  /** \brief A rotating log file for statements that exceeded a time threshold
+   *
+   * The log is normally fed by the trace hook of one or more connections,
+   * see `SqliteDatabase::enableSlowQueryLog()`; the time threshold is a property
+   * of the connection, not of the log. All methods are thread-safe.
+   *
+   * Each entry is a block of lines, followed by an empty line:
+   *
+   * ```
+   * 2024-03-15T12:34:56.789Z duration_ms=123.456 rows=42
+   * fingerprint: SELECT * FROM t1 WHERE i=?
+   * sql: SELECT * FROM t1 WHERE i=84
+   * plan:
+   *   SCAN t1
+   * ```
+   */
+  class SlowQueryLog
+  {
+  public:
+    /** \brief Ctor; opens (or creates) the log file in append mode
+     *
+     * \throws std::invalid_argument if the file name is empty or if the file can't be opened
+     *
+     * Test case: yes
+     *
+     */
+    explicit SlowQueryLog(
+        const SlowQueryLogOptions& _opts   ///< the log settings
+        );
+
+    /** \brief Disabled copy ctor */
+    SlowQueryLog(const SlowQueryLog& other) = delete;
+
+    /** \brief Disabled copy assignment */
+    SlowQueryLog& operator=(const SlowQueryLog& other) = delete;
+
+    /** \brief Appends an entry to the log and rotates the log file, if necessary
+     *
+     * Test case: yes
+     *
+     */
+    void write(
+        const SlowQueryEntry& entry   ///< the entry to write
+        );
+
+    /** \brief Collects and logs the data of a slow statement that has just
+     * finished executing; the query plan is only captured if this is the first time
+     * that the log sees the statement's fingerprint and if less than `maxPlanFingerprints`
+     * plans have been captured so far.
+     *
+     * \note This is called from within the SQLite trace callback. It
+     * must not throw and silently drops the entry in case of errors.
+     */
+    void logStatement(
+        sqlite3_stmt* stmt,   ///< the statement that has been executed
+        uint64_t duration_ns,   ///< the execution time
+        uint64_t nRows   ///< number of returned or modified rows
+        ) noexcept;
+
+    /** \returns the settings of this log
+     */
+    const SlowQueryLogOptions& options() const { return opts; }
+
+    /** \returns the number of entries that have been written
+     *
+     * Test case: yes
+     *
+     */
+    size_t entryCount() const;
+
+    /** \returns the indented tree of EXPLAIN QUERY PLAN for the provided SQL text
+     * or an empty string if the plan can't be retrieved
+     *
+     * Test case: yes
+     *
+     */
+    static std::string getQueryPlan(
+        sqlite3* db,   ///< the connection for which the plan shall be determined
+        const std::string& sql   ///< the SQL text; parameters may remain unbound
+        );
+
+  protected:
+    void rotate_NoLock();
+
+  private:
+    const SlowQueryLogOptions opts;
+    mutable std::mutex logMutex;
+    std::ofstream out;
+    size_t curFileSize{0};
+    size_t nEntries{0};
+    std::unordered_set<std::string> fingerprintsWithPlan;   // limited to `opts.maxPlanFingerprints` entries
+  };
+
+}
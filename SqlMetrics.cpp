@@ -0,0 +1,562 @@
+#include <algorithm>                // for sort, min
+#include <bit>                      // for bit_width, bit_ceil
+#include <cctype>                   // for isalnum, isdigit, isspace
+#include <cstring>                  // for strncmp
+
+#include <sqlite3.h>                // for sqlite3_stmt, SQLITE_TRACE_xxx
+
+#include "SlowQueryLog.h"           // for SlowQueryLog
+#include "SqlStatement.h"           // for readStatementStatus
+
+#include "SqlMetrics.h"
+
+using namespace std;
+
+namespace SqliteOverlay
+{
+  namespace
+  {
+    /** \brief FNV-1a; never returns zero because zero marks an unused slot
+     */
+    uint64_t hashFingerprint(string_view s)
+    {
+      uint64_t h = 14695981039346656037ull;
+      for (const char c : s)
+      {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+      }
+      return (h == 0) ? 1 : h;
+    }
+
+    /** \returns the state of a statement handle in the trace hooks, created if necessary
+     */
+    SqlTraceHooks::StmtInfo& getStmtInfo(SqlTraceHooks& hooks, sqlite3_stmt* stmt, const char* sql)
+    {
+      // normalize the SQL text only once per statement handle
+      auto it = hooks.stmtInfo.find(stmt);
+      if ((it == hooks.stmtInfo.end()) || (it->second.sql != sql))
+      {
+        if (hooks.stmtInfo.size() >= SqlTraceHooks::MaxCachedStatements) hooks.stmtInfo.clear();
+        it = hooks.stmtInfo.insert_or_assign(stmt, SqlTraceHooks::StmtInfo{sql, hooks.metrics->fingerprintIndex(sql), StatementStatus{}}).first;
+      }
+
+      return it->second;
+    }
+
+    /** \returns the counter increments since `baseline`; if the counters have been
+     * reset in the meantime, the current values are the increments
+     */
+    StatementStatus statusDelta(const StatementStatus& cur, const StatementStatus& baseline)
+    {
+      auto delta = [](int64_t c, int64_t b) { return (c >= b) ? (c - b) : c; };
+
+      StatementStatus result;
+      result.fullscanSteps = delta(cur.fullscanSteps, baseline.fullscanSteps);
+      result.sorts = delta(cur.sorts, baseline.sorts);
+      result.autoIndexes = delta(cur.autoIndexes, baseline.autoIndexes);
+      result.vmSteps = delta(cur.vmSteps, baseline.vmSteps);
+      result.reprepares = delta(cur.reprepares, baseline.reprepares);
+      result.runs = delta(cur.runs, baseline.runs);
+      result.memUsed = cur.memUsed;   // not a counter
+
+      return result;
+    }
+
+    bool isIdentChar(char c)
+    {
+      return (isalnum(static_cast<unsigned char>(c)) || (c == '_') || (c == '$') || (static_cast<unsigned char>(c) >= 0x80));
+    }
+
+    void atomicMin(atomic<uint64_t>& target, uint64_t val)
+    {
+      uint64_t cur = target.load(memory_order_relaxed);
+      while ((val < cur) && !target.compare_exchange_weak(cur, val, memory_order_relaxed)) {}
+    }
+
+    template<typename T>
+    void atomicMax(atomic<T>& target, T val)
+    {
+      T cur = target.load(memory_order_relaxed);
+      while ((val > cur) && !target.compare_exchange_weak(cur, val, memory_order_relaxed)) {}
+    }
+
+    /** \brief Tracks the number of result rows of the statements that are
+     * currently being stepped on this thread
+     */
+    struct RowCounter
+    {
+      sqlite3_stmt* stmt{nullptr};
+      uint64_t n{0};
+    };
+
+    // usually only one or two statements are stepped at the same time, so a linear
+    // search is fast; the vector grows if necessary and keeps its capacity
+    thread_local vector<RowCounter> rowCounters;
+
+    void countRow(sqlite3_stmt* stmt)
+    {
+      for (RowCounter& rc : rowCounters)
+      {
+        if (rc.stmt == stmt)
+        {
+          ++rc.n;
+          return;
+        }
+      }
+
+      rowCounters.push_back(RowCounter{stmt, 1});
+    }
+
+    uint64_t takeRowCount(sqlite3_stmt* stmt)
+    {
+      for (RowCounter& rc : rowCounters)
+      {
+        if (rc.stmt == stmt)
+        {
+          const uint64_t n = rc.n;
+          rc = rowCounters.back();
+          rowCounters.pop_back();
+          return n;
+        }
+      }
+      return 0;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  nlohmann::json SqlMetricsSnapshot::toJson() const
+  {
+    nlohmann::json result;
+    result["dropped"] = nDropped;
+
+    nlohmann::json stmtList = nlohmann::json::array();
+    for (const SqlFingerprintMetrics& m : statements)
+    {
+      nlohmann::json hist = nlohmann::json::object();
+      for (size_t idx = 0; idx < SqlLatencyBuckets; ++idx)
+      {
+        if (m.histogram[idx] == 0) continue;
+        hist[to_string(1ull << idx)] = m.histogram[idx];
+      }
+
+      stmtList.push_back(nlohmann::json{
+                           {"fingerprint", m.fingerprint},
+                           {"count", m.count},
+                           {"rows", m.nRows},
+                           {"total_ns", m.totalTime_ns},
+                           {"min_ns", m.minTime_ns},
+                           {"max_ns", m.maxTime_ns},
+                           {"avg_ns", m.avgTime_ns()},
+                           {"histogram_us", hist},
+                           {"fullscan_steps", m.status.fullscanSteps},
+                           {"sorts", m.status.sorts},
+                           {"autoindex_rows", m.status.autoIndexes},
+                           {"vm_steps", m.status.vmSteps},
+                           {"reprepares", m.status.reprepares},
+                           {"runs", m.status.runs},
+                           {"max_mem_used", m.status.memUsed}
+                         });
+    }
+    result["statements"] = stmtList;
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  vector<const SqlFingerprintMetrics*> SqlMetricsSnapshot::missingIndexCandidates() const
+  {
+    vector<const SqlFingerprintMetrics*> result;
+    for (const SqlFingerprintMetrics& m : statements)
+    {
+      if ((m.status.fullscanSteps > 0) || (m.status.autoIndexes > 0)) result.push_back(&m);
+    }
+
+    sort(result.begin(), result.end(), [](const SqlFingerprintMetrics* a, const SqlFingerprintMetrics* b) {
+      return (a->status.fullscanSteps + a->status.autoIndexes) > (b->status.fullscanSteps + b->status.autoIndexes);
+    });
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  SqlMetricsRegistry::SqlMetricsRegistry(size_t _capacity)
+    :capacity{bit_ceil(max(_capacity, size_t{1}))}, slots{make_unique<Slot[]>(capacity)}
+  {
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqlMetricsRegistry::record(string_view sql, uint64_t time_ns, uint64_t nRows, const StatementStatus& status)
+  {
+    record(fingerprintIndex(sql), time_ns, nRows, status);
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t SqlMetricsRegistry::fingerprintIndex(string_view sql)
+  {
+    // re-use the buffer for the normalized
+    // SQL text in order to avoid allocations
+    thread_local string normSql;
+    normalizeInto(sql, normSql);
+    const uint64_t h = hashFingerprint(normSql);
+
+    // linear probing; slots are never released
+    // so we can stop at the first empty slot
+    for (size_t i = 0; i < capacity; ++i)
+    {
+      const size_t idx = (h + i) & (capacity - 1);
+      Slot& s = slots[idx];
+      uint64_t slotHash = s.hash.load(memory_order_acquire);
+      if (slotHash == h) return idx;
+      if (slotHash == 0)
+      {
+        if (s.hash.compare_exchange_strong(slotHash, h, memory_order_acq_rel))
+        {
+          s.fingerprint = normSql;
+          s.isReady.store(true, memory_order_release);
+          return idx;
+        }
+
+        // another thread was faster; maybe
+        // with the same fingerprint
+        if (slotHash == h) return idx;
+      }
+    }
+
+    return InvalidIndex;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqlMetricsRegistry::record(size_t fpIdx, uint64_t time_ns, uint64_t nRows, const StatementStatus& status)
+  {
+    if (fpIdx >= capacity)
+    {
+      nDropped.fetch_add(1, memory_order_relaxed);
+      return;
+    }
+    Slot* slot = &slots[fpIdx];
+
+    const size_t bucket = min(static_cast<size_t>(bit_width(time_ns / 1000)), SqlLatencyBuckets - 1);
+
+    slot->count.fetch_add(1, memory_order_relaxed);
+    slot->nRows.fetch_add(nRows, memory_order_relaxed);
+    slot->totalTime.fetch_add(time_ns, memory_order_relaxed);
+    slot->histogram[bucket].fetch_add(1, memory_order_relaxed);
+    atomicMin(slot->minTime, time_ns);
+    atomicMax(slot->maxTime, time_ns);
+
+    slot->fullscanSteps.fetch_add(status.fullscanSteps, memory_order_relaxed);
+    slot->sorts.fetch_add(status.sorts, memory_order_relaxed);
+    slot->autoIndexes.fetch_add(status.autoIndexes, memory_order_relaxed);
+    slot->vmSteps.fetch_add(status.vmSteps, memory_order_relaxed);
+    slot->reprepares.fetch_add(status.reprepares, memory_order_relaxed);
+    slot->runs.fetch_add(status.runs, memory_order_relaxed);
+    atomicMax(slot->maxMemUsed, status.memUsed);
+  }
+
+  //----------------------------------------------------------------------------
+
+  SqlMetricsSnapshot SqlMetricsRegistry::snapshot() const
+  {
+    SqlMetricsSnapshot result;
+    result.nDropped = nDropped.load(memory_order_relaxed);
+
+    for (size_t i = 0; i < capacity; ++i)
+    {
+      const Slot& s = slots[i];
+      if (!s.isReady.load(memory_order_acquire)) continue;
+
+      SqlFingerprintMetrics m;
+      m.count = s.count.load(memory_order_relaxed);
+      if (m.count == 0) continue;
+
+      m.fingerprint = s.fingerprint;
+      m.nRows = s.nRows.load(memory_order_relaxed);
+      m.totalTime_ns = s.totalTime.load(memory_order_relaxed);
+      m.minTime_ns = s.minTime.load(memory_order_relaxed);
+      m.maxTime_ns = s.maxTime.load(memory_order_relaxed);
+      for (size_t idx = 0; idx < SqlLatencyBuckets; ++idx)
+      {
+        m.histogram[idx] = s.histogram[idx].load(memory_order_relaxed);
+      }
+      m.status.fullscanSteps = s.fullscanSteps.load(memory_order_relaxed);
+      m.status.sorts = s.sorts.load(memory_order_relaxed);
+      m.status.autoIndexes = s.autoIndexes.load(memory_order_relaxed);
+      m.status.vmSteps = s.vmSteps.load(memory_order_relaxed);
+      m.status.reprepares = s.reprepares.load(memory_order_relaxed);
+      m.status.runs = s.runs.load(memory_order_relaxed);
+      m.status.memUsed = s.maxMemUsed.load(memory_order_relaxed);
+
+      result.statements.push_back(std::move(m));
+    }
+
+    sort(result.statements.begin(), result.statements.end(), [](const SqlFingerprintMetrics& a, const SqlFingerprintMetrics& b) {
+      return a.totalTime_ns > b.totalTime_ns;
+    });
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqlMetricsRegistry::reset()
+  {
+    nDropped.store(0, memory_order_relaxed);
+
+    for (size_t i = 0; i < capacity; ++i)
+    {
+      Slot& s = slots[i];
+      s.count.store(0, memory_order_relaxed);
+      s.nRows.store(0, memory_order_relaxed);
+      s.totalTime.store(0, memory_order_relaxed);
+      s.minTime.store(UINT64_MAX, memory_order_relaxed);
+      s.maxTime.store(0, memory_order_relaxed);
+      for (auto& b : s.histogram) b.store(0, memory_order_relaxed);
+      s.fullscanSteps.store(0, memory_order_relaxed);
+      s.sorts.store(0, memory_order_relaxed);
+      s.autoIndexes.store(0, memory_order_relaxed);
+      s.vmSteps.store(0, memory_order_relaxed);
+      s.reprepares.store(0, memory_order_relaxed);
+      s.runs.store(0, memory_order_relaxed);
+      s.maxMemUsed.store(0, memory_order_relaxed);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  string SqlMetricsRegistry::normalize(string_view sql)
+  {
+    string result;
+    normalizeInto(sql, result);
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqlMetricsRegistry::normalizeInto(string_view sql, string& out)
+  {
+    out.clear();
+
+    bool pendingSpace{false};
+    bool prevIsIdent{false};
+
+    // emits a single character and handles the pending whitespace
+    auto emit = [&](char c) {
+      if (pendingSpace && !out.empty() && (out.back() != '(') && (out.back() != ',') && (c != ')') && (c != ','))
+      {
+        out += ' ';
+      }
+      pendingSpace = false;
+      out += c;
+    };
+
+    // emits a placeholder and collapses lists of placeholders
+    auto emitPlaceholder = [&]() {
+      if ((out.size() >= 2) && (out.back() == ',') && (out[out.size() - 2] == '?'))
+      {
+        out.pop_back();
+        pendingSpace = false;
+        return;
+      }
+      emit('?');
+    };
+
+    // copies a quoted token verbatim, incl. doubled quote chars
+    auto copyQuoted = [&](size_t& i, char closingChar) {
+      emit(sql[i]);
+      for (++i; i < sql.size(); ++i)
+      {
+        out += sql[i];
+        if (sql[i] == closingChar)
+        {
+          if (((i + 1) < sql.size()) && (sql[i + 1] == closingChar) && (closingChar != ']'))
+          {
+            out += sql[++i];
+            continue;
+          }
+          break;
+        }
+      }
+    };
+
+    size_t i = 0;
+    while (i < sql.size())
+    {
+      const char c = sql[i];
+
+      if (isspace(static_cast<unsigned char>(c)))
+      {
+        pendingSpace = true;
+        prevIsIdent = false;
+        ++i;
+        continue;
+      }
+
+      // string literals and blob literals
+      if ((c == '\'') || (((c == 'x') || (c == 'X')) && !prevIsIdent && ((i + 1) < sql.size()) && (sql[i + 1] == '\'')))
+      {
+        if (c != '\'') ++i;
+        for (++i; i < sql.size(); ++i)
+        {
+          if (sql[i] == '\'')
+          {
+            if (((i + 1) < sql.size()) && (sql[i + 1] == '\''))
+            {
+              ++i;
+              continue;
+            }
+            break;
+          }
+        }
+        ++i;
+        emitPlaceholder();
+        prevIsIdent = false;
+        continue;
+      }
+
+      // numeric literals
+      if ((isdigit(static_cast<unsigned char>(c)) || ((c == '.') && ((i + 1) < sql.size()) && isdigit(static_cast<unsigned char>(sql[i + 1])))) && !prevIsIdent)
+      {
+        for (++i; i < sql.size(); ++i)
+        {
+          const char n = sql[i];
+          if (isalnum(static_cast<unsigned char>(n)) || (n == '.')) continue;
+          if (((n == '+') || (n == '-')) && ((sql[i - 1] == 'e') || (sql[i - 1] == 'E'))) continue;
+          break;
+        }
+        emitPlaceholder();
+        prevIsIdent = false;
+        continue;
+      }
+
+      // parameters
+      if ((c == '?') || (((c == ':') || (c == '@') || (c == '$')) && ((i + 1) < sql.size()) && isIdentChar(sql[i + 1])))
+      {
+        for (++i; (i < sql.size()) && isIdentChar(sql[i]); ++i) {}
+        emitPlaceholder();
+        prevIsIdent = false;
+        continue;
+      }
+
+      // quoted identifiers
+      if ((c == '"') || (c == '`') || (c == '['))
+      {
+        copyQuoted(i, (c == '[') ? ']' : c);
+        ++i;
+        prevIsIdent = true;
+        continue;
+      }
+
+      emit(c);
+      ++i;
+      prevIsIdent = isIdentChar(c);
+
+      // collapse lists of rows like "(?),(?),(?)"
+      if ((c == ')') && (out.size() >= 7) && out.ends_with("(?),(?)"))
+      {
+        out.resize(out.size() - 4);
+      }
+    }
+
+    // no trailing semicolon
+    if (!out.empty() && (out.back() == ';')) out.pop_back();
+  }
+
+  //----------------------------------------------------------------------------
+
+  int sqlTraceCallback(unsigned int traceType, void* ctx, void* p, void* x)
+  {
+    SqlTraceHooks* hooks = static_cast<SqlTraceHooks*>(ctx);
+    if (hooks == nullptr) return 0;
+
+    // the slow-query log executes statements on the same
+    // connection; these must not be traced themselves
+    thread_local bool isInCallback{false};
+    if (isInCallback) return 0;
+    struct CallbackGuard
+    {
+      CallbackGuard() { isInCallback = true; }
+      ~CallbackGuard() { isInCallback = false; }
+    } guard;
+
+    sqlite3_stmt* stmt = static_cast<sqlite3_stmt*>(p);
+
+    switch (traceType)
+    {
+    case SQLITE_TRACE_STMT:
+    {
+      // remember the counters at the start of the run; trigger
+      // invocations are reported as comments and don't start a new run
+      const char* sql = sqlite3_sql(stmt);
+      const char* traceText = static_cast<const char*>(x);
+      const bool isTrigger = (traceText != nullptr) && (strncmp(traceText, "--", 2) == 0);
+      if (hooks->metrics && (sql != nullptr) && !isTrigger)
+      {
+        getStmtInfo(*hooks, stmt, sql).baseline = readStatementStatus(stmt, false);
+      }
+
+      if (!hooks->stmtLogger) break;
+
+      char* expanded = sqlite3_expanded_sql(stmt);
+      if (expanded != nullptr)
+      {
+        hooks->stmtLogger(string_view{expanded});
+        sqlite3_free(expanded);
+      }
+      break;
+    }
+
+    case SQLITE_TRACE_ROW:
+      countRow(stmt);
+      break;
+
+    case SQLITE_TRACE_PROFILE:
+    {
+      uint64_t nRows = takeRowCount(stmt);
+
+      // for modifying statements we report the number
+      // of modified rows unless they returned any data (e.g., RETURNING)
+      if ((nRows == 0) && !sqlite3_stmt_readonly(stmt))
+      {
+        nRows = static_cast<uint64_t>(sqlite3_changes64(sqlite3_db_handle(stmt)));
+      }
+
+      const auto time_ns = static_cast<uint64_t>(*static_cast<sqlite3_int64*>(x));
+
+      if (hooks->metrics)
+      {
+        const char* sql = sqlite3_sql(stmt);
+        if (sql != nullptr)
+        {
+          // the counters are left untouched for `SqlStatement::getStatus()`;
+          // we only record the increments of this run
+          SqlTraceHooks::StmtInfo& si = getStmtInfo(*hooks, stmt, sql);
+          const StatementStatus cur = readStatementStatus(stmt, false);
+          hooks->metrics->record(si.fpIdx, time_ns, nRows, statusDelta(cur, si.baseline));
+          si.baseline = cur;
+        }
+      }
+
+      if (hooks->slowLog && (time_ns >= hooks->slowThreshold_ns))
+      {
+        hooks->slowLog->logStatement(stmt, time_ns, nRows);
+      }
+      break;
+    }
+
+    default:
+      break;
+    }
+
+    return 0;
+  }
+
+  //----------------------------------------------------------------------------
+
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <stddef.h>                 // for size_t
+#include <stdint.h>                 // for uint64_t
+#include <array>                    // for array
+#include <atomic>                   // for atomic
+#include <functional>               // for function
+#include <memory>                   // for shared_ptr, unique_ptr
+#include <string>                   // for string
+#include <string_view>              // for string_view
+#include <unordered_map>            // for unordered_map
+#include <vector>                   // for vector
+
+#include <sqlite3.h>                // for sqlite3_stmt
+
+#include <Sloppy/json.hpp>          // for json
+
+#include "Defs.h"                   // for StatementStatus
+
+namespace SqliteOverlay
+{
+  class SlowQueryLog;
+
+  /** \brief Number of latency buckets per fingerprint
+   *
+   * Bucket 0 counts executions that took less than 1 µs, bucket `k > 0`
+   * counts executions that took at least 2^(k-1) µs and less than 2^k µs.
+   * The last bucket also holds everything above its upper limit.
+   */
+  constexpr size_t SqlLatencyBuckets = 32;
+
+  /** \brief Aggregated metrics for all statements with the same fingerprint
+   */
+  struct SqlFingerprintMetrics
+  {
+    std::string fingerprint;   ///< the normalized SQL text
+    uint64_t count{0};   ///< number of executions
+    uint64_t nRows{0};   ///< number of rows that have been returned (queries) or modified (all other statements)
+    uint64_t totalTime_ns{0};   ///< sum of all execution times
+    uint64_t minTime_ns{0};   ///< fastest execution
+    uint64_t maxTime_ns{0};   ///< slowest execution
+    std::array<uint64_t, SqlLatencyBuckets> histogram{};   ///< latency histogram, see `SqlLatencyBuckets`
+    StatementStatus status;   ///< the summed-up statement counters; `memUsed` is the max value
+
+    /** \returns the average execution time in ns or 0 if there were no executions
+     */
+    double avgTime_ns() const { return (count == 0) ? 0.0 : static_cast<double>(totalTime_ns) / count; }
+  };
+
+  /** \brief A point-in-time copy of all metrics in a registry
+   */
+  struct SqlMetricsSnapshot
+  {
+    std::vector<SqlFingerprintMetrics> statements;   ///< all fingerprints with at least one execution, sorted by descending total time
+    uint64_t nDropped{0};   ///< executions that could not be recorded because the registry was full
+
+    /** \returns the snapshot as JSON object; histograms are exported
+     * as a map of "upper limit in µs" to "count" and only contain non-empty buckets
+     *
+     * Test case: yes
+     *
+     */
+    nlohmann::json toJson() const;
+
+    /** \returns pointers to all fingerprints that used full table scans or automatic
+     * indices, ordered by descending number of full-scan steps plus auto-index rows;
+     * these are the prime candidates for missing indices.
+     *
+     * \note The pointers are only valid as long as the snapshot exists.
+     *
+     * Test case: yes
+     *
+     */
+    std::vector<const SqlFingerprintMetrics*> missingIndexCandidates() const;
+  };
+
+  /** \brief Collects execution counts, row counts and latency histograms per
+   * statement fingerprint.
+   *
+   * A fingerprint is the statement's SQL text with all literals and parameters
+   * replaced by `?`, lists of them collapsed into a single `?` and normalized
+   * whitespace. Thus, `SELECT * FROM t WHERE id=42` and `SELECT * FROM t WHERE id=?1`
+   * share the same fingerprint.
+   *
+   * Recording is lock-free: the registry is a fixed-size open-addressing hash table
+   * and all counters are atomics. Thus, one registry can be shared between
+   * several connections (e.g., all connections of a pool) that are used by different threads.
+   *
+   * If the table is full, new fingerprints are not recorded but only counted as "dropped".
+   *
+   * \note The registry is normally fed by the trace hook of a connection, see
+   * `SqliteDatabase::enableSqlMetrics()`.
+   */
+  class SqlMetricsRegistry
+  {
+  public:
+    /** \brief Default number of different fingerprints that can be recorded */
+    static constexpr size_t DefaultCapacity = 1024;
+
+    /** \brief Returned by `fingerprintIndex()` if the registry is full */
+    static constexpr size_t InvalidIndex = SIZE_MAX;
+
+    /** \brief Ctor for an empty registry; the capacity is rounded up to the next power of two
+     *
+     * Test case: yes
+     *
+     */
+    explicit SqlMetricsRegistry(
+        size_t _capacity = DefaultCapacity   ///< the max number of different fingerprints
+        );
+
+    /** \brief Disabled copy ctor */
+    SqlMetricsRegistry(const SqlMetricsRegistry& other) = delete;
+
+    /** \brief Disabled copy assignment */
+    SqlMetricsRegistry& operator=(const SqlMetricsRegistry& other) = delete;
+
+    /** \brief Records a single statement execution
+     *
+     * Test case: yes
+     *
+     */
+    void record(
+        std::string_view sql,   ///< the (non-normalized) SQL text of the statement
+        uint64_t time_ns,   ///< the execution time
+        uint64_t nRows,   ///< the number of returned or modified rows
+        const StatementStatus& status = StatementStatus{}   ///< the statement counters for this execution
+        );
+
+    /** \brief Records a single statement execution for a fingerprint that
+     * has been looked up before; this avoids normalizing the SQL text
+     * again for each execution of the same statement
+     *
+     * Test case: yes
+     *
+     */
+    void record(
+        size_t fpIdx,   ///< the fingerprint index as returned by `fingerprintIndex()`
+        uint64_t time_ns,   ///< the execution time
+        uint64_t nRows,   ///< the number of returned or modified rows
+        const StatementStatus& status = StatementStatus{}   ///< the statement counters for this execution
+        );
+
+    /** \returns the index of the fingerprint of a statement, creating the
+     * fingerprint if necessary, or `InvalidIndex` if the registry is full;
+     * the index remains valid for the lifetime of the registry (`reset()` included)
+     *
+     * Test case: yes
+     *
+     */
+    size_t fingerprintIndex(
+        std::string_view sql   ///< the (non-normalized) SQL text of the statement
+        );
+
+    /** \returns a copy of all metrics
+     *
+     * Test case: yes
+     *
+     */
+    SqlMetricsSnapshot snapshot() const;
+
+    /** \brief Resets all counters to zero; known fingerprints stay allocated
+     *
+     * Test case: yes
+     *
+     */
+    void reset();
+
+    /** \returns the fingerprint (normalized SQL text) for a statement
+     *
+     * Test case: yes
+     *
+     */
+    static std::string normalize(
+        std::string_view sql   ///< the SQL text to normalize
+        );
+
+  protected:
+    /** \brief Writes the normalized SQL text into the target buffer
+     */
+    static void normalizeInto(std::string_view sql, std::string& out);
+
+    struct Slot
+    {
+      std::atomic<uint64_t> hash{0};   // 0 = unused
+      std::atomic<bool> isReady{false};   // true = `fingerprint` has been written
+      std::string fingerprint;
+      std::atomic<uint64_t> count{0};
+      std::atomic<uint64_t> nRows{0};
+      std::atomic<uint64_t> totalTime{0};
+      std::atomic<uint64_t> minTime{UINT64_MAX};
+      std::atomic<uint64_t> maxTime{0};
+      std::array<std::atomic<uint64_t>, SqlLatencyBuckets> histogram{};
+      std::atomic<int64_t> fullscanSteps{0};
+      std::atomic<int64_t> sorts{0};
+      std::atomic<int64_t> autoIndexes{0};
+      std::atomic<int64_t> vmSteps{0};
+      std::atomic<int64_t> reprepares{0};
+      std::atomic<int64_t> runs{0};
+      std::atomic<int64_t> maxMemUsed{0};
+    };
+
+  private:
+    const size_t capacity;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> nDropped{0};
+  };
+
+  /** \brief Everything that is hooked into SQLite's trace interface of a connection
+   *
+   * \note Instances are owned by SqliteDatabase and kept at a stable heap address
+   * because their address is passed as context pointer to `sqlite3_trace_v2()`.
+   */
+  struct SqlTraceHooks
+  {
+    std::shared_ptr<SqlMetricsRegistry> metrics;   ///< receives the execution times and statement counters, if set
+    std::function<void(std::string_view)> stmtLogger;   ///< receives the expanded SQL of each statement that starts executing, if set
+    std::shared_ptr<SlowQueryLog> slowLog;   ///< receives all statements that took `slowThreshold_ns` or longer, if set
+    uint64_t slowThreshold_ns{0};   ///< the threshold for the slow-query log
+
+    /** \brief Metrics state of a statement handle that has been executed before
+     */
+    struct StmtInfo
+    {
+      std::string sql;   ///< the SQL text; detects handles that have been re-used for a different statement
+      size_t fpIdx;   ///< the fingerprint index in `metrics`
+      StatementStatus baseline;   ///< the statement counters at the start of the current run
+    };
+
+    /** \brief Max number of entries in `stmtInfo`; the cache is cleared when it is full */
+    static constexpr size_t MaxCachedStatements = 4096;
+
+    std::unordered_map<sqlite3_stmt*, StmtInfo> stmtInfo;   ///< state per statement handle; must be cleared whenever `metrics` changes
+  };
+
+  /** \brief The callback that is registered with `sqlite3_trace_v2()`; the
+   * context pointer has to point to a `SqlTraceHooks` instance
+   *
+   * The function signature is defined by SQLite
+   */
+  int sqlTraceCallback(
+      unsigned int traceType,   ///< the trace event (`SQLITE_TRACE_xxx`)
+      void* ctx,   ///< pointer to the `SqlTraceHooks`
+      void* p,   ///< event specific, see SQLite docs
+      void* x   ///< event specific, see SQLite docs
+      );
+
+}
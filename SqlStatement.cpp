@@ -13,6 +13,7 @@
 
 
 #include "SqliteExceptions.h"             // for GenericSqliteException, Nul...
+#include "StatementCache.h"               // for StatementCache
 #include "SqlStatement.h"
 
 namespace date { class time_zone; }
@@ -22,6 +23,25 @@ using namespace Sloppy::DateTime;
 
 namespace SqliteOverlay
 {
+  StatementStatus readStatementStatus(sqlite3_stmt* stmt, bool resetCounters)
+  {
+    StatementStatus st;
+    if (stmt == nullptr) return st;
+
+    const int r = resetCounters ? 1 : 0;
+    st.fullscanSteps = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, r);
+    st.sorts = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, r);
+    st.autoIndexes = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_AUTOINDEX, r);
+    st.vmSteps = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, r);
+    st.reprepares = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_REPREPARE, r);
+    st.runs = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_RUN, r);
+    st.memUsed = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_MEMUSED, 0);
+
+    return st;
+  }
+
+  //----------------------------------------------------------------------------
+
   SqlStatement::SqlStatement()
     :_isDone(true)
   {
@@ -52,6 +72,14 @@ namespace SqliteOverlay
 
   //----------------------------------------------------------------------------
 
+  SqlStatement::SqlStatement(sqlite3_stmt* _stmt, std::weak_ptr<StatementCache> _cache, string&& _cacheKey)
+    :stmt{_stmt}, cache{std::move(_cache)}, cacheKey{std::move(_cacheKey)}, _isDone(false)
+  {
+
+  }
+
+  //----------------------------------------------------------------------------
+
   SqlStatement::~SqlStatement()
   {
     forceFinalize();
@@ -61,12 +89,14 @@ namespace SqliteOverlay
 
   SqlStatement& SqlStatement::operator=(SqlStatement&& other)
   {
-    if (stmt != nullptr)
-    {
-      sqlite3_finalize(stmt);
-    }
+    forceFinalize();
+
     stmt = other.stmt;
     other.stmt = nullptr;
+    cache = std::move(other.cache);
+    other.cache.reset();
+    cacheKey = std::move(other.cacheKey);
+    other.cacheKey.clear();
 
     _hasData = other._hasData;
     other._hasData = false;
@@ -76,6 +106,10 @@ namespace SqliteOverlay
     other.resultColCount = -1;
     stepCount = other.stepCount;
     other.stepCount = -1;
+    rowGen = other.rowGen;   // views obtained from `other` remain valid
+    ownedParams = std::move(other.ownedParams);   // moves the map nodes, not the bound values
+    other.ownedParams.clear();
+    other.invalidateViews();
 
     return *this;
   }
@@ -96,6 +130,7 @@ namespace SqliteOverlay
       return false;
     }
 
+    invalidateViews();
     const int err = sqlite3_step(stmt);
     ++stepCount;
 
@@ -208,22 +243,53 @@ namespace SqliteOverlay
         sqlite3_clear_bindings(stmt);
       }
     }
+    if (clearBindings) ownedParams.clear();
 
     _hasData = false;
     _isDone = false;
     resultColCount = -1;
     stepCount = 0;
+    invalidateViews();
   }
 
   //----------------------------------------------------------------------------
 
   void SqlStatement::forceFinalize()
   {
+    if (stmt == nullptr) return;
+
+    invalidateViews();
+
+    if (!cacheKey.empty())
+    {
+      // return leased statements to their cache; if the cache
+      // is already gone, we simply finalize the statement
+      if (auto c = cache.lock(); c)
+      {
+        c->giveBack(std::move(cacheKey), stmt);
+        stmt = nullptr;
+      }
+      cache.reset();
+      cacheKey.clear();
+    }
+
     if (stmt != nullptr)
     {
       sqlite3_finalize(stmt);
       stmt = nullptr;
     }
+
+    // SQLite doesn't reference owned values anymore
+    ownedParams.clear();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqlStatement::invalidateViews()
+  {
+    // unconditionally, because the check is compiled
+    // into the client code, not into the library
+    ++rowGen;
   }
 
   //----------------------------------------------------------------------------
@@ -239,6 +305,13 @@ namespace SqliteOverlay
 
   //----------------------------------------------------------------------------
 
+  StatementStatus SqlStatement::getStatus(bool resetCounters) const
+  {
+    return readStatementStatus(stmt, resetCounters);
+  }
+
+  //----------------------------------------------------------------------------
+
   Sloppy::CSV_Table SqlStatement::toCSV(bool includeHeaders)
   {
     if (isDone())
@@ -398,6 +471,66 @@ namespace SqliteOverlay
 
   //----------------------------------------------------------------------------
 
+  void SqlStatement::bindOwned(int argPos, string&& val)
+  {
+    // release SQLite's reference to a previously owned value
+    // before we replace it
+    auto it = ownedParams.find(argPos);
+    if (it != ownedParams.end()) sqlite3_bind_null(stmt, argPos);
+
+    auto& v = ownedParams.insert_or_assign(argPos, std::move(val)).first->second;
+    const string& s = std::get<string>(v);
+
+    const int e = sqlite3_bind_text64(stmt, argPos, s.data(), s.length(), SQLITE_STATIC, SQLITE_UTF8);
+    if (e != SQLITE_OK)
+    {
+      ownedParams.erase(argPos);
+      throw GenericSqliteException{e, "call to bind() with string ownership of a SqlStatement"};
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqlStatement::bindOwned(int argPos, Sloppy::MemArray&& val)
+  {
+    auto it = ownedParams.find(argPos);
+    if (it != ownedParams.end()) sqlite3_bind_null(stmt, argPos);
+
+    auto& v = ownedParams.insert_or_assign(argPos, std::move(val)).first->second;
+    const Sloppy::MemArray& a = std::get<Sloppy::MemArray>(v);
+
+    const int e = sqlite3_bind_blob64(stmt, argPos, a.to_voidPtr(), a.byteSize(), SQLITE_STATIC);
+    if (e != SQLITE_OK)
+    {
+      ownedParams.erase(argPos);
+      throw GenericSqliteException{e, "call to bind() with blob ownership of a SqlStatement"};
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqlStatement::bindStatic(int argPos, const char* val) const
+  {
+    const int e = sqlite3_bind_text(stmt, argPos, val, strlen(val), SQLITE_STATIC);
+    if (e != SQLITE_OK)
+    {
+      throw GenericSqliteException{e, "call to bindStatic() of a SqlStatement"};
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqlStatement::bindStatic(int argPos, const void* ptr, size_t nBytes) const
+  {
+    const int e = sqlite3_bind_blob64(stmt, argPos, ptr, nBytes, SQLITE_STATIC);
+    if (e != SQLITE_OK)
+    {
+      throw GenericSqliteException{e, "call to bindStatic() of a SqlStatement"};
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
   void SqlStatement::bindNull(int argPos) const
   {
     const int e = sqlite3_bind_null(stmt, argPos);
@@ -2,10 +2,15 @@
 
 #include <stdint.h>                       // for int64_t
 #include <ctime>                          // for size_t
+#include <map>                            // for map
+#include <memory>                         // for weak_ptr
 #include <optional>                       // for optional
+#include <stdexcept>                      // for logic_error
 #include <string>                         // for string, basic_string
+#include <string_view>                    // for string_view
 #include <tuple>                          // for tuple, make_tuple
 #include <type_traits>                    // for is_same
+#include <variant>                        // for variant
 #include <vector>                         // for vector
 
 #include <sqlite3.h>                      // for sqlite3, sqlite3_stmt
@@ -23,8 +28,13 @@ namespace date { class time_zone; }
 
 namespace SqliteOverlay
 {  
+  class StatementCache;
 
   /**  \brief A wrapper class for SQL statements
+   *
+   * \note Statements created by a SqliteDatabase with an enabled statement cache
+   * are "leased" from that cache: instead of being finalized they are reset,
+   * their bindings are cleared and they are handed back to the cache.
    */
   class SqlStatement
   {
@@ -49,6 +59,7 @@ namespace SqliteOverlay
         );
 
     /** \brief Dtor, finalizes the statment if it hasn't been finalized already
+     * (or returns it to its statement cache)
      */
     ~SqlStatement();
 
@@ -121,7 +132,8 @@ namespace SqliteOverlay
       }
       else if constexpr (std::is_same_v<T, Sloppy::MemView>) {
         /** \note SQLite makes an internal copy of the provided buffer; this is safer but
-        * also more memory consuming. Bear this in mind when dealing with very large blobs.
+        * also more memory consuming. Bear this in mind when dealing with very large blobs
+        * and consider `bindStatic()` or passing ownership of a `MemArray` instead.
         */
         bind(argPos, val.to_voidPtr(), val.byteSize());  // forward the call to the generic bindBlob
       }
@@ -168,7 +180,8 @@ namespace SqliteOverlay
      * a specification how placeholders are defined in the SQLite language.
      *
      * \note SQLite makes an internal copy of the provided buffer; this is safer but
-     * also more memory consuming. Bear this in mind when dealing with very large blobs.
+     * also more memory consuming. Bear this in mind when dealing with very large blobs
+     * and consider `bindStatic()` instead.
      *
      * \throws GenericSqliteException incl. error code if anything goes wrong
      *
@@ -181,6 +194,98 @@ namespace SqliteOverlay
         size_t nBytes   ///< number of bytes in the blob data
         ) const;
 
+    /** \brief Binds a string or a blob to a placeholder and takes ownership of it;
+     * the data is handed to SQLite without any copying.
+     *
+     * Only accepts rvalues of `std::string` or `Sloppy::MemArray`; there are no
+     * implicit conversions.
+     *
+     * The value is kept alive by this SqlStatement until the placeholder is bound
+     * again with an owned value, the bindings are cleared or the statement is finalized.
+     *
+     * \throws GenericSqliteException incl. error code if anything goes wrong
+     *
+     * Test case: yes
+     *
+     */
+    template<typename T>
+    requires (std::is_same_v<T, std::string> || std::is_same_v<T, Sloppy::MemArray>)
+    void bind(
+        int argPos,   ///< the placeholder to bind to (1-based if you use "?")
+        T&& val   ///< the value to bind to the placeholder
+        )
+    {
+      bindOwned(argPos, std::move(val));
+    }
+
+    /** \brief Binds text or blob data to a placeholder *without* copying it (`SQLITE_STATIC`)
+     *
+     * Supported types are `std::string`, `std::string_view` and `Sloppy::MemView`.
+     *
+     * \warning The caller guarantees that the data remains valid and unmodified until
+     * the placeholder is bound again, the bindings are cleared or the statement is finalized.
+     * Note that SQLite may also access bound values when executing `getExpandedSQL()`.
+     *
+     * \throws GenericSqliteException incl. error code if anything goes wrong
+     *
+     * Test case: yes
+     *
+     */
+    template<typename T>
+    void bindStatic(
+        int argPos,   ///< the placeholder to bind to (1-based if you use "?")
+        const T& val   ///< the value to bind to the placeholder
+        ) const
+    {
+      int e{SQLITE_OK};
+      if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+        e = sqlite3_bind_text64(stmt, argPos, val.data(), val.length(), SQLITE_STATIC, SQLITE_UTF8);
+      }
+      else if constexpr (std::is_same_v<T, Sloppy::MemView>) {
+        e = sqlite3_bind_blob64(stmt, argPos, val.to_voidPtr(), val.byteSize(), SQLITE_STATIC);
+      }
+      else {
+        static_assert (!std::is_same<T,T>::value, "SqlStatement: call to bindStatic() with a unsupported value type!");
+      }
+
+      if (e != SQLITE_OK)
+      {
+        throw GenericSqliteException{e, "call to bindStatic() of a SqlStatement"};
+      }
+    }
+
+    /** \brief Binding temporaries without copying them is never safe */
+    void bindStatic(int argPos, std::string&& val) const = delete;
+
+    /** \brief Binds a *zero-terminated* C-string to a placeholder *without* copying it (`SQLITE_STATIC`)
+     *
+     * \warning See the template version of `bindStatic()` for lifetime requirements.
+     *
+     * \throws GenericSqliteException incl. error code if anything goes wrong
+     *
+     * Test case: yes
+     *
+     */
+    void bindStatic(
+        int argPos,   ///< the placeholder to bind to (1-based if you use "?")
+        const char* val   ///< the value to bind to the placeholder
+        ) const;
+
+    /** \brief Binds a blob of data to a placeholder *without* copying it (`SQLITE_STATIC`)
+     *
+     * \warning See the template version of `bindStatic()` for lifetime requirements.
+     *
+     * \throws GenericSqliteException incl. error code if anything goes wrong
+     *
+     * Test case: yes
+     *
+     */
+    void bindStatic(
+        int argPos,   ///< the placeholder to bind to (1-based if you use "?")
+        const void* ptr,   ///< a pointer to blob data
+        size_t nBytes   ///< number of bytes in the blob data
+        ) const;
+
     /** \brief Binds a NULL value to a placeholder in the statement
      *
      * Original documentation [here](https://www.sqlite.org/c3ref/bind_blob.html), including
@@ -276,6 +381,11 @@ namespace SqliteOverlay
      *
      * \returns the value in the requested result column in the requested format
      *
+     * \note `std::string_view` and `Sloppy::MemView` return a view into SQLite's
+     * internal buffers without copying anything. These views are only valid until
+     * the next call to `step()`, `reset()` or `forceFinalize()`. Use `rowGeneration()`
+     * and `assertRowGeneration()` for checking that in debug builds.
+     *
      * Test case: FIX
      *
      */
@@ -299,26 +409,33 @@ namespace SqliteOverlay
         return (sqlite3_column_int(stmt, colId) != 0);
       }
       else if constexpr (std::is_same_v<T, std::string>) {
-        return std::string{reinterpret_cast<const char*>(sqlite3_column_text(stmt, colId))};
+        return std::string{get<std::string_view>(colId)};
+      }
+      else if constexpr (std::is_same_v<T, std::string_view>) {
+        // call sqlite3_column_text() BEFORE sqlite3_column_bytes() because
+        // the former might convert the value and thus change its length
+        const char* const txt = reinterpret_cast<const char*>(sqlite3_column_text(stmt, colId));
+        const int nBytes = sqlite3_column_bytes(stmt, colId);
+        if ((txt == nullptr) || (nBytes <= 0)) return std::string_view{};
+        return std::string_view{txt, static_cast<size_t>(nBytes)};
+      }
+      else if constexpr (std::is_same_v<T, Sloppy::MemView>) {
+        // same order of calls as above
+        const void* const srcPtr = sqlite3_column_blob(stmt, colId);
+        const int nBytes = sqlite3_column_bytes(stmt, colId);
+        if ((srcPtr == nullptr) || (nBytes <= 0)) return Sloppy::MemView{};
+        return Sloppy::MemView{static_cast<const char*>(srcPtr), static_cast<size_t>(nBytes)};
       }
       else if constexpr (std::is_same_v<T, nlohmann::json>) {
         return nlohmann::json::parse(sqlite3_column_text(stmt, colId));
       }
       else if constexpr (std::is_same_v<T, Sloppy::MemArray>) {
-        // get the number of bytes in the blob
-        const size_t nBytes = sqlite3_column_bytes(stmt, colId);
-        if (nBytes == 0)
-        {
-          return Sloppy::MemArray{}; // empty blob
-        }
-
         // wrap the data from SQLite into a MemView
-        const void* const srcPtr = sqlite3_column_blob(stmt, colId);
-        if (srcPtr == nullptr)  // shouldn't happen after the previous check, but we want to be sure
+        const Sloppy::MemView fakeView = get<Sloppy::MemView>(colId);
+        if (fakeView.byteSize() == 0)
         {
           return Sloppy::MemArray{}; // empty blob
         }
-        const Sloppy::MemView fakeView{static_cast<const char*>(srcPtr), nBytes};
 
         return Sloppy::MemArray{fakeView};  // creates a deep copy
       }
@@ -466,6 +583,9 @@ namespace SqliteOverlay
      * The function is useful if statements failed (e.g., because the database was busy) and they
      * should not be retried later. Finalizing the statement then releases the associated locks.
      *
+     * If the statement has been leased from a statement cache, it is reset and returned
+     * to the cache instead of being finalized. This releases the locks as well.
+     *
      * Test case: yes,implicitly in the dtor and in the transaction test cases
      */
     void forceFinalize();
@@ -478,6 +598,28 @@ namespace SqliteOverlay
      */
     std::string getExpandedSQL() const;
 
+    /** \returns `true` if the statement has been leased from a statement cache
+     * and will be returned to that cache instead of being finalized
+     *
+     * Test case: yes
+     *
+     */
+    bool isCached() const { return !cacheKey.empty(); }
+
+    /** \brief Retrieves the performance counters of this statement
+     *
+     * The counters accumulate over all runs of the statement unless
+     * they are reset.
+     *
+     * \note The metrics registry of the connection (see `SqliteDatabase::enableSqlMetrics()`)
+     * only reads the counters and doesn't reset them. Resetting them here doesn't affect the registry.
+     *
+     * Test case: yes
+     *
+     */
+    StatementStatus getStatus(
+        bool resetCounters = false   ///< if `true`, the counters are reset to zero after reading them
+        ) const;
 
 
     /** \brief Simple wrapper for retrieving two column values in a tuple.
@@ -580,6 +722,40 @@ namespace SqliteOverlay
       };
     }
 
+    /** \returns an ID for the current result row; views returned by `get<std::string_view>()`
+     * and `get<Sloppy::MemView>()` are valid as long as the ID doesn't change.
+     *
+     * \note The ID is maintained in all builds of the library, so the check in
+     * `assertRowGeneration()` works no matter how the library itself has been built.
+     *
+     * Test case: yes
+     *
+     */
+    uint64_t rowGeneration() const { return rowGen; }
+
+    /** \brief Debug-mode check that views obtained in a given row generation are still valid;
+     * does nothing if the calling code is compiled with `NDEBUG`.
+     *
+     * \throws std::logic_error if the statement has been stepped, reset or
+     * finalized since `gen` was obtained
+     *
+     * Test case: yes
+     *
+     */
+    void assertRowGeneration(
+        uint64_t gen   ///< the value of `rowGeneration()` at the time the views were obtained
+        ) const
+    {
+#ifndef NDEBUG
+      if (gen != rowGen)
+      {
+        throw std::logic_error("SqlStatement: column view used after step(), reset() or forceFinalize()");
+      }
+#else
+      (void) gen;
+#endif
+    }
+
     /** \returns the number of data columns in the result data set or -1 if the statement
      * does not contain any data.
      *
@@ -669,10 +845,44 @@ namespace SqliteOverlay
         ) const;
 
   private:
+    friend class StatementCache;
+    friend class ColumnarReaderBase;
+
+    /** \brief Ctor for a statement that has been leased from a statement cache
+     *
+     * For use by StatementCache only.
+     */
+    SqlStatement(
+        sqlite3_stmt* _stmt,   ///< the already prepared statement
+        std::weak_ptr<StatementCache> _cache,   ///< the cache that receives the statement when we're done
+        std::string&& _cacheKey   ///< the SQL text that was used for preparing the statement
+        );
+
     sqlite3_stmt* stmt{nullptr};
+    std::weak_ptr<StatementCache> cache;   // only set for leased statements
+    std::string cacheKey;   // the SQL text of leased statements; empty otherwise
     bool _hasData{false};
     bool _isDone;
     int resultColCount{-1};
     int stepCount{0};
+    uint64_t rowGen{0};   // changes whenever views into the current row become invalid
+    std::map<int, std::variant<std::string, Sloppy::MemArray>> ownedParams;   // bound values owned by this statement; map nodes never move
+
+    /** \brief Stores a value in `ownedParams` and binds it with `SQLITE_STATIC`
+     */
+    void bindOwned(int argPos, std::string&& val);
+    void bindOwned(int argPos, Sloppy::MemArray&& val);
+
+    /** \brief Assigns a new value to `rowGen`
+     */
+    void invalidateViews();
   };
+
+  /** \returns the performance counters of a raw statement handle (all zero
+   * for a `nullptr`); see `SqlStatement::getStatus()`
+   */
+  StatementStatus readStatementStatus(
+      sqlite3_stmt* stmt,   ///< the statement handle
+      bool resetCounters   ///< if `true`, the counters are reset to zero after reading them
+      );
 }
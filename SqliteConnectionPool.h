@@ -0,0 +1,548 @@
+#pragma once
+
+#include <stddef.h>              // for size_t
+#include <chrono>                // for steady_clock, milliseconds
+#include <condition_variable>    // for condition_variable
+#include <functional>            // for function
+#include <memory>                // for unique_ptr
+#include <mutex>                 // for mutex, unique_lock
+#include <stdexcept>             // for invalid_argument
+#include <string>                // for string
+#include <type_traits>           // for is_base_of_v, is_constructible_v
+#include <vector>                // for vector
+
+#include "Defs.h"                // for OpenMode, OpenOptions, ConnectionStats
+#include "SingleConnectionWorker.h"  // for openConnectionWithOptions
+#include "SqliteDatabase.h"      // for SqliteDatabase
+#include "SqliteExceptions.h"    // for BusyException
+
+namespace SqliteOverlay
+{
+  /** \brief Usage counters of a single pooled connection
+   */
+  struct PooledConnectionStats
+  {
+    size_t nLeases{0};   ///< number of times the connection has been handed out
+    std::chrono::microseconds totalWaitTime{0};   ///< accumulated time that callers had to wait for this connection
+    std::chrono::microseconds totalLeaseTime{0};   ///< accumulated time the connection has been leased
+    std::chrono::microseconds maxLeaseTime{0};   ///< the longest single lease of the connection
+  };
+
+  /** \brief A snapshot of the state and the counters of a connection pool
+   */
+  struct ConnectionPoolStats
+  {
+    size_t nReadersOpen{0};   ///< number of reader connections that are currently open
+    size_t nReadersLeased{0};   ///< number of reader connections that are currently in use
+    size_t nReadersCreated{0};   ///< total number of reader connections that have been opened
+    size_t nReadersReaped{0};   ///< total number of reader connections that have been closed because they were idle
+    size_t nTimeouts{0};   ///< number of lease requests that failed because the pool was exhausted
+    PooledConnectionStats writer;   ///< counters of the writer connection
+    PooledConnectionStats readers;   ///< accumulated counters of all reader connections, including reaped ones
+  };
+
+  /** \brief A sample of the SQLite-level statistics of all open connections in a pool
+   */
+  struct ConnectionPoolDbStats
+  {
+    ConnectionStats writer;   ///< statistics of the writer connection
+    ConnectionStats readers;   ///< accumulated statistics of all currently open reader connections
+    bool isWriterSampled{false};   ///< `false` if the writer connection has been skipped and `writer` only contains the process-wide values
+    size_t nReadersSampled{0};   ///< number of reader connections that contributed to `readers`
+  };
+
+  /** \brief A pool of connections to a single database file with one
+   * writer connection and up to N reader connections.
+   *
+   * The writer connection is opened in read/write mode by the ctor. Reader
+   * connections are opened in read-only mode on demand and are closed again
+   * by `reapIdleReaders()` if they haven't been used for a configurable time.
+   * Idle readers are also reaped whenever a lease is returned.
+   *
+   * Connections are handed out as RAII `Lease` objects that return the
+   * connection to the pool when they are destroyed. If no connection is
+   * available, the caller waits until a connection is returned or until
+   * the timeout expires.
+   *
+   * \note All public methods are thread-safe. The pool has to outlive
+   * all its leases.
+   *
+   * \note Since there is only one writer connection, all writes through the
+   * pool are serialized on application level and never run into SQLITE_BUSY
+   * among each other.
+   */
+  template<class DB_CLASS = SqliteDatabase>
+  class SqliteConnectionPool
+  {
+    static_assert (std::is_base_of_v<SqliteDatabase, DB_CLASS>);
+
+    using Clock = std::chrono::steady_clock;
+
+    // a single pooled connection
+    struct Slot
+    {
+      std::unique_ptr<DB_CLASS> db;
+      bool isLeased{false};
+      Clock::time_point lastReturn;
+      PooledConnectionStats stats;
+    };
+
+  public:
+    /** \brief The busy timeout of all pooled connections unless `OpenOptions::busyTimeout_ms` is set */
+    static constexpr int DefaultBusyTimeout_ms{5000};
+
+    /** \brief An RAII handle to a leased connection
+     *
+     * The connection is returned to the pool when the lease is destroyed
+     * or when `release()` is called.
+     */
+    class Lease
+    {
+    public:
+      /** \brief Dtor, returns the connection to the pool */
+      ~Lease() { release(); }
+
+      /** \brief Disabled copy ctor */
+      Lease(const Lease& other) = delete;
+
+      /** \brief Disabled copy assignment */
+      Lease& operator=(const Lease& other) = delete;
+
+      /** \brief Move ctor, invalidates the source lease */
+      Lease(Lease&& other)
+        :pool{other.pool}, slot{other.slot}, waited{other.waited}, acquiredAt{other.acquiredAt}
+      {
+        other.pool = nullptr;
+        other.slot = nullptr;
+      }
+
+      /** \brief Move assignment, returns our own connection before taking over the other's */
+      Lease& operator=(Lease&& other)
+      {
+        release();
+        pool = other.pool;
+        slot = other.slot;
+        waited = other.waited;
+        acquiredAt = other.acquiredAt;
+        other.pool = nullptr;
+        other.slot = nullptr;
+
+        return *this;
+      }
+
+      /** \returns a reference to the leased database connection
+       *
+       * \throws std::invalid_argument if the lease has already been released
+       */
+      DB_CLASS& db() const
+      {
+        if (slot == nullptr)
+        {
+          throw std::invalid_argument("SqliteConnectionPool::Lease: access to released lease");
+        }
+        return *(slot->db);
+      }
+
+      /** \brief Convenience access to the leased database connection */
+      DB_CLASS* operator->() const { return &(db()); }
+
+      /** \brief Convenience access to the leased database connection */
+      DB_CLASS& operator*() const { return db(); }
+
+      /** \returns `true` if the lease still holds a connection */
+      bool isValid() const { return (slot != nullptr); }
+
+      /** \returns the time the caller had to wait for this lease */
+      std::chrono::microseconds waitTime() const { return waited; }
+
+      /** \returns the time since the lease has been acquired */
+      std::chrono::microseconds leaseTime() const
+      {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - acquiredAt);
+      }
+
+      /** \returns how often the underlying connection has been leased, including this lease */
+      size_t connectionLeaseCount() const { return (slot == nullptr) ? 0 : slot->stats.nLeases; }
+
+      /** \brief Returns the connection to the pool; the lease is invalid afterwards */
+      void release()
+      {
+        if (slot == nullptr) return;
+        pool->giveBack(slot, leaseTime());
+        pool = nullptr;
+        slot = nullptr;
+      }
+
+    private:
+      friend class SqliteConnectionPool;
+
+      Lease(SqliteConnectionPool* _pool, Slot* _slot, std::chrono::microseconds _waited)
+        :pool{_pool}, slot{_slot}, waited{_waited}, acquiredAt{Clock::now()} {}
+
+      SqliteConnectionPool* pool;
+      Slot* slot;
+      std::chrono::microseconds waited;
+      Clock::time_point acquiredAt;
+    };
+
+    /** \brief Ctor for a new pool; it opens the writer connection immediately
+     *
+     * \throws std::invalid_argument if the filename is empty or refers to an in-memory database
+     * or if the max number of readers is zero
+     *
+     * \throws GenericSqliteException incl. error code if anything goes wrong
+     * with SQLite when opening the writer connection
+     *
+     * Test case: yes
+     *
+     */
+    SqliteConnectionPool(
+        const std::string& _dbFilename,   ///< the name of the database file
+        size_t _maxReaders,   ///< the max number of concurrently open reader connections
+        std::chrono::milliseconds _maxIdleTime = std::chrono::seconds{60},   ///< reader connections that are idle for longer are closed
+        OpenMode writerOpenMode = OpenMode::OpenOrCreate_RW,   ///< the opening mode for the writer connection (use a RW-mode here)
+        std::function<void(DB_CLASS&)> _initFunc = nullptr,   ///< an optional function that is called for every newly opened connection (e.g., for enabling the statement cache)
+        const OpenOptions& _openOptions = OpenOptions{}   ///< performance settings for all connections in the pool
+        )
+      :dbFilename{_dbFilename}, maxIdleTime{_maxIdleTime}, initFunc{_initFunc}, openOptions{withPoolDefaults(_openOptions)}, readers(_maxReaders)
+    {
+      if (dbFilename.empty() || (dbFilename == ":memory:"))
+      {
+        throw std::invalid_argument("SqliteConnectionPool ctor: empty filename or in-memory database");
+      }
+      if (_maxReaders == 0)
+      {
+        throw std::invalid_argument("SqliteConnectionPool ctor: need at least one reader connection");
+      }
+      if (writerOpenMode == OpenMode::OpenExisting_RO)
+      {
+        throw std::invalid_argument("SqliteConnectionPool ctor: the writer connection requires a read/write mode");
+      }
+
+      writer.db = openConnection(writerOpenMode);
+      if (initFunc) initFunc(*(writer.db));
+    }
+
+    /** \brief Disabled copy ctor */
+    SqliteConnectionPool(const SqliteConnectionPool& other) = delete;
+
+    /** \brief Disabled copy assignment */
+    SqliteConnectionPool& operator=(const SqliteConnectionPool& other) = delete;
+
+    /** \brief Leases the writer connection; blocks until the connection is available
+     * or until the timeout has expired.
+     *
+     * \throws BusyException if the writer connection could not be leased within the timeout
+     *
+     * \returns a lease for the writer connection
+     *
+     * Test case: yes
+     *
+     */
+    Lease writerLease(
+        std::chrono::milliseconds timeout   ///< the max waiting time; use zero for not waiting at all
+        )
+    {
+      const auto t0 = Clock::now();
+      std::unique_lock<std::mutex> lk{poolMutex};
+
+      if (!cv.wait_for(lk, timeout, [&](){ return !writer.isLeased; }))
+      {
+        ++nTimeouts;
+        throw BusyException("SqliteConnectionPool: timeout while waiting for the writer connection");
+      }
+
+      return lease_NoLock(writer, t0);
+    }
+
+    /** \brief Leases a reader connection; blocks until a connection is available
+     * or until the timeout has expired.
+     *
+     * Idle connections are preferred over opening new connections. New
+     * connections are only opened as long as the pool's max size hasn't
+     * been reached.
+     *
+     * \throws BusyException if no reader connection could be leased within the timeout
+     *
+     * \throws GenericSqliteException incl. error code if anything goes wrong
+     * with SQLite when opening a new connection
+     *
+     * \returns a lease for a read-only connection
+     *
+     * Test case: yes
+     *
+     */
+    Lease readerLease(
+        std::chrono::milliseconds timeout   ///< the max waiting time; use zero for not waiting at all
+        )
+    {
+      const auto t0 = Clock::now();
+      std::unique_lock<std::mutex> lk{poolMutex};
+
+      Slot* freeSlot{nullptr};
+      Slot* unusedSlot{nullptr};
+      auto findSlot = [&]()
+      {
+        freeSlot = nullptr;
+        unusedSlot = nullptr;
+        for (Slot& s : readers)
+        {
+          if (s.isLeased) continue;
+          if (s.db != nullptr)
+          {
+            freeSlot = &s;
+            return true;
+          }
+          if (unusedSlot == nullptr) unusedSlot = &s;
+        }
+        return (unusedSlot != nullptr);
+      };
+
+      if (!cv.wait_for(lk, timeout, findSlot))
+      {
+        ++nTimeouts;
+        throw BusyException("SqliteConnectionPool: timeout while waiting for a reader connection");
+      }
+
+      if (freeSlot != nullptr) return lease_NoLock(*freeSlot, t0);
+
+      // open a new connection; we reserve the slot
+      // and release the lock while opening the connection
+      // because that's a comparably slow operation
+      unusedSlot->isLeased = true;
+      lk.unlock();
+
+      std::unique_ptr<DB_CLASS> newDb;
+      try
+      {
+        newDb = openConnection(OpenMode::OpenExisting_RO);
+        if (initFunc) initFunc(*newDb);
+      }
+      catch (...)
+      {
+        lk.lock();
+        unusedSlot->isLeased = false;
+        lk.unlock();
+        cv.notify_one();
+        throw;
+      }
+
+      lk.lock();
+      unusedSlot->db = std::move(newDb);
+      unusedSlot->isLeased = false;
+      ++nReadersCreated;
+
+      return lease_NoLock(*unusedSlot, t0);
+    }
+
+    /** \brief Closes all reader connections that haven't been used for longer than
+     * the max idle time.
+     *
+     * \returns the number of closed connections
+     *
+     * Test case: yes
+     *
+     */
+    size_t reapIdleReaders()
+    {
+      std::lock_guard<std::mutex> lg{poolMutex};
+      return reapIdleReaders_NoLock(maxIdleTime);
+    }
+
+    /** \brief Closes all reader connections that are currently not leased
+     *
+     * \returns the number of closed connections
+     *
+     * Test case: yes
+     *
+     */
+    size_t closeIdleReaders()
+    {
+      std::lock_guard<std::mutex> lg{poolMutex};
+      return reapIdleReaders_NoLock(std::chrono::milliseconds{0});
+    }
+
+    /** \returns a snapshot of the pool's state and counters
+     *
+     * Test case: yes
+     *
+     */
+    ConnectionPoolStats stats() const
+    {
+      std::lock_guard<std::mutex> lg{poolMutex};
+
+      ConnectionPoolStats result;
+      result.nReadersCreated = nReadersCreated;
+      result.nReadersReaped = nReadersReaped;
+      result.nTimeouts = nTimeouts;
+      result.writer = writer.stats;
+      result.readers = reapedReaderStats;
+      for (const Slot& s : readers)
+      {
+        if (s.db != nullptr) ++result.nReadersOpen;
+        if (s.isLeased && (s.db != nullptr)) ++result.nReadersLeased;
+        accumulate(result.readers, s.stats);
+      }
+
+      return result;
+    }
+
+    /** \brief Samples the page cache and memory statistics of all open connections,
+     * see `SqliteDatabase::stats()`
+     *
+     * Leased connections are only sampled if they use the serialized threading mode
+     * (see `SqliteDatabase::isSerialized()`), which the pool requests by default; otherwise
+     * they are skipped and their counters are picked up by a later sample. Statistics
+     * of readers that have been reaped in the meantime are lost.
+     *
+     * The process-wide memory usage is read once per call and reported for the
+     * writer and the readers alike.
+     *
+     * Meant to be called periodically, e.g. by a monitoring thread; with
+     * `resetCounters == true` each sample contains only the deltas since the last sample.
+     *
+     * Test case: yes
+     *
+     */
+    ConnectionPoolDbStats sampleConnectionStats(
+        bool resetCounters = false   ///< if `true`, the counters of all connections are reset after reading them
+        ) const
+    {
+      std::lock_guard<std::mutex> lg{poolMutex};
+
+      // a leased connection may be in use by another thread
+      auto isSafe = [](const Slot& s) {
+        return (s.db != nullptr) && (!s.isLeased || s.db->isSerialized());
+      };
+
+      ConnectionPoolDbStats result;
+      if (isSafe(writer))
+      {
+        result.writer = writer.db->stats(resetCounters, false);
+        result.isWriterSampled = true;
+      }
+      for (const Slot& s : readers)
+      {
+        if (!isSafe(s)) continue;
+        result.readers += s.db->stats(resetCounters, false);
+        ++result.nReadersSampled;
+      }
+
+      // process-wide values; read and reset only once
+      SqliteDatabase::readMemoryStatus(result.writer, resetCounters);
+      result.readers.memoryUsed = result.writer.memoryUsed;
+      result.readers.memoryHighwater = result.writer.memoryHighwater;
+
+      return result;
+    }
+
+    /** \returns the max number of reader connections
+     *
+     * Test case: yes
+     *
+     */
+    size_t maxReaders() const { return readers.size(); }
+
+    /** \returns the name of the database file
+     *
+     * Test case: not yet
+     *
+     */
+    std::string filename() const { return dbFilename; }
+
+  protected:
+    Lease lease_NoLock(Slot& s, Clock::time_point t0)
+    {
+      const auto waited = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0);
+
+      s.isLeased = true;
+      ++s.stats.nLeases;
+      s.stats.totalWaitTime += waited;
+
+      return Lease{this, &s, waited};
+    }
+
+    void giveBack(Slot* s, std::chrono::microseconds leaseTime)
+    {
+      {
+        std::lock_guard<std::mutex> lg{poolMutex};
+
+        s->isLeased = false;
+        s->lastReturn = Clock::now();
+        s->stats.totalLeaseTime += leaseTime;
+        if (leaseTime > s->stats.maxLeaseTime) s->stats.maxLeaseTime = leaseTime;
+
+        // opportunistically close readers that have been idle for too long
+        reapIdleReaders_NoLock(maxIdleTime);
+      }
+
+      // wake up all waiters because we can't tell whether
+      // they're waiting for the writer or for a reader
+      cv.notify_all();
+    }
+
+    size_t reapIdleReaders_NoLock(std::chrono::milliseconds idleLimit)
+    {
+      const auto now = Clock::now();
+      size_t cnt{0};
+      for (Slot& s : readers)
+      {
+        if (s.isLeased || (s.db == nullptr)) continue;
+        if ((now - s.lastReturn) < idleLimit) continue;
+
+        s.db.reset();
+        accumulate(reapedReaderStats, s.stats);
+        s.stats = PooledConnectionStats{};
+        ++cnt;
+      }
+      nReadersReaped += cnt;
+
+      return cnt;
+    }
+
+    /** \brief Pooled connections are used concurrently by design; without a busy timeout,
+     * readers in rollback-journal mode would fail immediately while the writer commits.
+     * The serialized threading mode allows for sampling the statistics of leased connections.
+     */
+    static OpenOptions withPoolDefaults(const OpenOptions& oo)
+    {
+      OpenOptions result{oo};
+      if (!result.busyTimeout_ms) result.busyTimeout_ms = DefaultBusyTimeout_ms;
+      result.serializedAccess = true;
+      return result;
+    }
+
+    /** \brief Opens a new connection with the pool's OpenOptions
+     */
+    std::unique_ptr<DB_CLASS> openConnection(OpenMode om) const
+    {
+      return openConnectionWithOptions<DB_CLASS>(dbFilename, om, openOptions);
+    }
+
+    static void accumulate(PooledConnectionStats& dst, const PooledConnectionStats& src)
+    {
+      dst.nLeases += src.nLeases;
+      dst.totalWaitTime += src.totalWaitTime;
+      dst.totalLeaseTime += src.totalLeaseTime;
+      if (src.maxLeaseTime > dst.maxLeaseTime) dst.maxLeaseTime = src.maxLeaseTime;
+    }
+
+  private:
+    const std::string dbFilename;
+    const std::chrono::milliseconds maxIdleTime;
+    std::function<void(DB_CLASS&)> initFunc;
+    const OpenOptions openOptions;
+
+    Slot writer;
+    std::vector<Slot> readers;   // fixed size; closed connections have `db == nullptr`
+
+    size_t nReadersCreated{0};
+    size_t nReadersReaped{0};
+    size_t nTimeouts{0};
+    PooledConnectionStats reapedReaderStats;
+
+    mutable std::mutex poolMutex;
+    std::condition_variable cv;
+  };
+
+}
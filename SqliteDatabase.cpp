@@ -1,14 +1,24 @@
 #include <sys/stat.h>              // for stat
+#ifndef IS_WINDOWS_BUILD
+#include <poll.h>                  // for poll, pollfd
+#include <sys/eventfd.h>           // for eventfd
+#include <sys/inotify.h>           // for inotify_init1, inotify_add_watch
+#include <unistd.h>                // for read, close
+#endif
+#include <algorithm>               // for min, clamp
 #include <cstddef>                 // for size_t, std
 #include <cstdint>                 // for int64_t
 #include <initializer_list>        // for initializer_list
+#include <limits>                  // for numeric_limits
 #include <memory>                  // for allocator
+#include <thread>                  // for sleep_for
 #include <utility>                 // for move
 
 #include <Sloppy/Crypto/Crypto.h>  // for getRandomAlphanumString
 #include <Sloppy/String.h>         // for estring, StringList
 
 #include "KeyValueTab.h"           // for KeyValueTab, KeyValueTab::KEY_COL_...
+#include "MemoryBudget.h"          // for MemoryBudgetManager
 #include "SqliteExceptions.h"      // for NullValueException, BusyException
 #include "TableCreator.h"          // for TableCreator
 #include "Transaction.h"           // for Transaction
@@ -71,7 +81,7 @@ namespace SqliteOverlay
 
   //----------------------------------------------------------------------------
 
-  SqliteDatabase::SqliteDatabase(string dbFilename, OpenMode om)
+  SqliteDatabase::SqliteDatabase(string dbFilename, OpenMode om, const OpenOptions& opts)
   {
     // check if the filename is valid
     if (dbFilename.empty())
@@ -123,7 +133,7 @@ namespace SqliteOverlay
     }(om);
 
     // try to open the database
-    const int err = sqlite3_open_v2(dbFilename.c_str(), &dbPtr, oFlags, nullptr);
+    const int err = sqlite3_open_v2(dbFilename.c_str(), &dbPtr, oFlags | (opts.serializedAccess ? SQLITE_OPEN_FULLMUTEX : 0), nullptr);
     if (dbPtr == nullptr)
     {
       throw std::runtime_error("No memory for allocating sqlite instance");
@@ -139,15 +149,15 @@ namespace SqliteOverlay
 
     // we're all set
     //
-    // Explicitly enable support for foreign keys
-    // and disable synchronous writes for better performance.
+    // Apply the connection settings; by default this enables
+    // support for foreign keys and disables synchronous writes
+    // for better performance.
     //
     // Should anything go wrong, close the connection and
     // re-throw the original exception
     try
     {
-      execNonQuery("PRAGMA foreign_keys = ON");
-      enforceSynchronousWrites(false);
+      applyOpenOptions(opts);
       resetDirtyFlag();
     }
     catch (...)
@@ -158,15 +168,17 @@ namespace SqliteOverlay
 
       throw;
     }
-
-    // initialize the pointers in the changeLogCallbackContext
-    logCallbackContext.logMutex = &changeLogMutex;
-    logCallbackContext.logPtr = &changeLog;  }
+  }
 
   //----------------------------------------------------------------------------
 
   SqliteDatabase::~SqliteDatabase()
   {
+    if (isMemoryManaged) MemoryBudgetManager::instance().unregisterConnection(*this);
+
+    // finalize all idle statements in the cache
+    stmtCache.reset();
+
     // close the database, if not already done so
     // no need to react to errors here because we're in
     // the dtor anyway....
@@ -195,22 +207,27 @@ namespace SqliteOverlay
     // now move all members over to this object
     dbPtr = other.dbPtr;
     other.dbPtr = nullptr;
+    stmtCache = std::move(other.stmtCache);
+    openOptions = other.openOptions;
+    traceHooks = std::move(other.traceHooks);
+    if (other.isMemoryManaged) MemoryBudgetManager::instance().replaceConnection(&other, this);
 
     localChangeCounter_resetValue = other.localChangeCounter_resetValue;
     externalChangeCounter_resetValue = other.externalChangeCounter_resetValue;
     isChangeLogEnabled = other.isChangeLogEnabled;
     other.isChangeLogEnabled = false;
-    changeLog = std::move(other.changeLog);
-
-    // initialize the pointers in the changeLogCallbackContext
-    logCallbackContext.logMutex = &changeLogMutex;
-    logCallbackContext.logPtr = &changeLog;
-
-    // re-enable the changelog if it was active before
-    if (isChangeLogEnabled)
-    {
-      setDataChangeNotificationCallback(changeLogCallback, &logCallbackContext);
-    }
+    changeLogBuf = std::move(other.changeLogBuf);
+    changeWatcher = std::move(other.changeWatcher);
+    activeChangeLog = other.activeChangeLog.exchange(nullptr);
+    userUpdateHook = other.userUpdateHook;
+    userUpdateHookPtr = other.userUpdateHookPtr;
+    other.userUpdateHook = nullptr;
+    other.userUpdateHookPtr = nullptr;
+    tabWriteCounters = std::move(other.tabWriteCounters);
+    activeTabWriteCounters = other.activeTabWriteCounters.exchange(nullptr);
+
+    // re-register the update hook with the new object
+    updateHookRegistration();
 
     return *this;
   }
@@ -228,22 +245,27 @@ namespace SqliteOverlay
     // now move all members over to this object
     dbPtr = other.dbPtr;
     other.dbPtr = nullptr;
+    stmtCache = std::move(other.stmtCache);
+    openOptions = other.openOptions;
+    traceHooks = std::move(other.traceHooks);
+    if (other.isMemoryManaged) MemoryBudgetManager::instance().replaceConnection(&other, this);
 
     localChangeCounter_resetValue = other.localChangeCounter_resetValue;
     externalChangeCounter_resetValue = other.externalChangeCounter_resetValue;
     isChangeLogEnabled = other.isChangeLogEnabled;
     other.isChangeLogEnabled = false;
-    changeLog = std::move(other.changeLog);
-
-    // initialize the pointers in the changeLogCallbackContext
-    logCallbackContext.logMutex = &changeLogMutex;
-    logCallbackContext.logPtr = &changeLog;
-
-    // re-enable the changelog if it was active before
-    if (isChangeLogEnabled)
-    {
-      setDataChangeNotificationCallback(changeLogCallback, &logCallbackContext);
-    }
+    changeLogBuf = std::move(other.changeLogBuf);
+    changeWatcher = std::move(other.changeWatcher);
+    activeChangeLog = other.activeChangeLog.exchange(nullptr);
+    userUpdateHook = other.userUpdateHook;
+    userUpdateHookPtr = other.userUpdateHookPtr;
+    other.userUpdateHook = nullptr;
+    other.userUpdateHookPtr = nullptr;
+    tabWriteCounters = std::move(other.tabWriteCounters);
+    activeTabWriteCounters = other.activeTabWriteCounters.exchange(nullptr);
+
+    // re-register the update hook with the new object
+    updateHookRegistration();
   }
 
   //----------------------------------------------------------------------------
@@ -252,6 +274,12 @@ namespace SqliteOverlay
   {
     if (dbPtr == nullptr) return;
 
+    if (isMemoryManaged) MemoryBudgetManager::instance().unregisterConnection(*this);
+
+    // idle statements in the cache would keep
+    // the connection from being closed
+    if (stmtCache) stmtCache->clear();
+
     const int result = sqlite3_close(dbPtr);
 
     if (result != SQLITE_OK)
@@ -264,6 +292,8 @@ namespace SqliteOverlay
     }
 
     dbPtr = nullptr;
+    stmtCache.reset();
+    changeWatcher.reset();
   }
 
   //----------------------------------------------------------------------------
@@ -312,6 +342,77 @@ namespace SqliteOverlay
 
   //----------------------------------------------------------------------------
 
+  void SqliteDatabase::applyOpenOptions(const OpenOptions& opts)
+  {
+    if (dbPtr == nullptr)
+    {
+      throw std::invalid_argument("applyOpenOptions(): database is not open");
+    }
+
+    const bool isReadOnly = (sqlite3_db_readonly(dbPtr, "main") == 1);
+
+    // the busy timeout comes first because the following
+    // PRAGMAs may already need to wait for locks
+    if (opts.busyTimeout_ms)
+    {
+      sqlite3_busy_timeout(dbPtr, *opts.busyTimeout_ms);
+    }
+
+    // the page size has to be set before the first
+    // table is created and before switching to WAL mode
+    if (opts.pageSize && !isReadOnly && (execScalarQuery<int>("PRAGMA page_count") == 0))
+    {
+      execNonQuery("PRAGMA page_size = " + to_string(*opts.pageSize));
+    }
+
+    // the journal mode can't be changed on read-only connections;
+    // WAL mode is persistent anyway and thus inherited from the writer
+    if (opts.journalMode && !isReadOnly)
+    {
+      // "PRAGMA journal_mode" returns the new mode; if SQLite
+      // refuses to switch, it silently returns the old mode
+      const string requested = to_string(*opts.journalMode);
+      const string actual = execScalarQuery<string>("PRAGMA journal_mode = " + requested);
+
+      // in-memory and temporary databases only support MEMORY and OFF
+      if ((sqlite3_stricmp(actual.c_str(), requested.c_str()) != 0) && !filename().empty())
+      {
+        throw GenericSqliteException(SQLITE_ERROR, "applyOpenOptions(): could not switch the journal mode to " + requested + ", it is still " + actual);
+      }
+    }
+
+    if (opts.synchronous)
+    {
+      execNonQuery("PRAGMA synchronous = " + to_string(*opts.synchronous));
+    }
+
+    if (opts.cacheSize)
+    {
+      execNonQuery("PRAGMA cache_size = " + to_string(*opts.cacheSize));
+    }
+
+    if (opts.mmapSize)
+    {
+      execContentQuery("PRAGMA mmap_size = " + to_string(*opts.mmapSize));
+    }
+
+    if (opts.tempStore)
+    {
+      execNonQuery("PRAGMA temp_store = " + to_string(*opts.tempStore));
+    }
+
+    if (opts.lockingMode)
+    {
+      execContentQuery("PRAGMA locking_mode = " + to_string(*opts.lockingMode));
+    }
+
+    execNonQuery(opts.foreignKeys ? "PRAGMA foreign_keys = ON" : "PRAGMA foreign_keys = OFF");
+
+    openOptions = opts;
+  }
+
+  //----------------------------------------------------------------------------
+
   void SqliteDatabase::viewCreationHelper(const string& viewName, const string& selectStmt) const
   {
     string sql = "CREATE VIEW IF NOT EXISTS ";
@@ -431,6 +532,13 @@ namespace SqliteOverlay
 
   //----------------------------------------------------------------------------
 
+  int SqliteDatabase::getLimit(int limitId) const
+  {
+    return sqlite3_limit(dbPtr, limitId, -1);
+  }
+
+  //----------------------------------------------------------------------------
+
   int SqliteDatabase::getRowsAffected() const
   {
     return sqlite3_changes(dbPtr);
@@ -681,7 +789,107 @@ namespace SqliteOverlay
 
   void* SqliteDatabase::setDataChangeNotificationCallback(void(*f)(void*, int, const char*, const char*, sqlite3_int64), void* customPtr)
   {
-    return sqlite3_update_hook(dbPtr, f, customPtr);
+    void* oldPtr = userUpdateHookPtr;
+
+    userUpdateHook = f;
+    userUpdateHookPtr = (f == nullptr) ? nullptr : customPtr;
+    updateHookRegistration();
+
+    return oldPtr;
+  }
+
+  //----------------------------------------------------------------------------
+
+  shared_ptr<const atomic<uint64_t>> SqliteDatabase::getTableWriteCounter(const string& tabName)
+  {
+    lock_guard<mutex> lg{tabWriteCounterMutex};
+
+    if (tabWriteCounters != nullptr)
+    {
+      for (const auto& [name, cnt] : tabWriteCounters->counters)
+      {
+        if (sqlite3_stricmp(name.c_str(), tabName.c_str()) == 0) return cnt;
+      }
+    }
+
+    // build a new list that contains the new counter and all counters
+    // that are still in use; the active list is never modified
+    auto newList = make_unique<TabWriteCounterList>();
+    if (tabWriteCounters != nullptr)
+    {
+      for (const auto& wc : tabWriteCounters->counters)
+      {
+        if (wc.second.use_count() > 1) newList->counters.push_back(wc);
+      }
+    }
+    auto cnt = make_shared<atomic<uint64_t>>(0);
+    newList->counters.emplace_back(tabName, cnt);
+
+    // the update hook is only called with the connection mutex held (a
+    // no-op for non-serialized connections which can't be used concurrently
+    // anyway); once we own the mutex, nobody uses the old list anymore
+    sqlite3_mutex* connMutex = (dbPtr == nullptr) ? nullptr : sqlite3_db_mutex(dbPtr);
+    sqlite3_mutex_enter(connMutex);
+    activeTabWriteCounters.store(newList.get(), std::memory_order_release);
+    tabWriteCounters = std::move(newList);
+    sqlite3_mutex_leave(connMutex);
+
+    updateHookRegistration();
+
+    return cnt;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::TabWriteCounterList::increment(const char* tabName)
+  {
+    // consecutive changes usually affect the same table; the linear
+    // search is only necessary if the table name changes
+    if (lastTabName.compare(tabName) != 0)
+    {
+      lastTabName = tabName;
+      lastIdx = counters.size();
+      for (size_t i = 0; i < counters.size(); ++i)
+      {
+        if (sqlite3_stricmp(counters[i].first.c_str(), tabName) == 0)
+        {
+          lastIdx = i;
+          break;
+        }
+      }
+    }
+
+    if (lastIdx < counters.size()) counters[lastIdx].second->fetch_add(1, std::memory_order_release);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::updateHookDispatcher(void* customPtr, int modType, const char* dbName, const char* tabName, sqlite3_int64 id)
+  {
+    SqliteDatabase* self = static_cast<SqliteDatabase*>(customPtr);
+
+    if (self->userUpdateHook != nullptr) self->userUpdateHook(self->userUpdateHookPtr, modType, dbName, tabName, id);
+
+    ChangeLogBuffer* buf = self->activeChangeLog.load(std::memory_order_acquire);
+    if (buf != nullptr) buf->append(modType, dbName, tabName, id);
+
+    TabWriteCounterList* twc = self->activeTabWriteCounters.load(std::memory_order_acquire);
+    if (twc != nullptr) twc->increment(tabName);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::updateHookRegistration()
+  {
+    if (dbPtr == nullptr) return;
+
+    const bool isNeeded = (userUpdateHook != nullptr) || (activeChangeLog.load() != nullptr) || (activeTabWriteCounters.load() != nullptr);
+    if (isNeeded)
+    {
+      sqlite3_update_hook(dbPtr, updateHookDispatcher, this);
+    } else {
+      sqlite3_update_hook(dbPtr, nullptr, nullptr);
+    }
   }
 
   //----------------------------------------------------------------------------
@@ -689,19 +897,292 @@ namespace SqliteOverlay
   size_t SqliteDatabase::getChangeLogLength()
   {
     lock_guard<mutex> lg{changeLogMutex};
-    return changeLog.size();
+    return (changeLogBuf == nullptr) ? 0 : changeLogBuf->size();
+  }
+
+  //----------------------------------------------------------------------------
+
+  ChangeLogList SqliteDatabase::getAllChangesAndClearQueue(bool coalesce)
+  {
+    lock_guard<mutex> lg{changeLogMutex};
+
+    ChangeLogList result;
+    if (changeLogBuf == nullptr) return result;
+
+    vector<CompactChangeLogEntry> compact;
+    changeLogBuf->drain(compact);
+    if (coalesce) coalesceChangeLog(compact);
+
+    // resolve the names only once per ID
+    vector<string> dbNames;
+    vector<string> tabNames;
+    auto resolve = [](vector<string>& cache, uint32_t id, auto getter) -> const string& {
+      if (id >= cache.size()) cache.resize(id + 1);
+      if (cache[id].empty()) cache[id] = getter(id);
+      return cache[id];
+    };
+
+    result.reserve(compact.size());
+    for (const CompactChangeLogEntry& e : compact)
+    {
+      const string& dn = resolve(dbNames, e.dbId, [this](uint32_t id) { return changeLogBuf->dbName(static_cast<uint16_t>(id)); });
+      const string& tn = resolve(tabNames, e.tabId, [this](uint32_t id) { return changeLogBuf->tabName(id); });
+      result.emplace_back(e.action, dn, tn, static_cast<size_t>(e.rowId));
+    }
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t SqliteDatabase::drainChangeLog(vector<CompactChangeLogEntry>& dst, bool coalesce)
+  {
+    lock_guard<mutex> lg{changeLogMutex};
+
+    if (changeLogBuf == nullptr) return 0;
+
+    const size_t oldSize = dst.size();
+    const size_t cnt = changeLogBuf->drain(dst);
+
+    return coalesce ? coalesceChangeLog(dst, oldSize) : cnt;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::setChangeLogTableFilter(const vector<string>& tabNames)
+  {
+    lock_guard<mutex> lg{changeLogMutex};
+
+    if (changeLogBuf == nullptr) changeLogBuf = make_unique<ChangeLogBuffer>();
+
+    changeLogBuf->setTableFilter(tabNames);
+  }
+
+  //----------------------------------------------------------------------------
+
+  string SqliteDatabase::changeLogDbName(uint16_t dbId) const
+  {
+    lock_guard<mutex> lg{changeLogMutex};
+
+    if (changeLogBuf == nullptr)
+    {
+      throw std::invalid_argument("SqliteDatabase: unknown changelog database ID");
+    }
+
+    return changeLogBuf->dbName(dbId);
   }
 
   //----------------------------------------------------------------------------
 
-  ChangeLogList SqliteDatabase::getAllChangesAndClearQueue()
+  string SqliteDatabase::changeLogTabName(uint32_t tabId) const
   {
     lock_guard<mutex> lg{changeLogMutex};
 
-    ChangeLogList tmpLog{std::move(changeLog)};
-    changeLog = ChangeLogList{};
+    if (changeLogBuf == nullptr)
+    {
+      throw std::invalid_argument("SqliteDatabase: unknown changelog table ID");
+    }
+
+    return changeLogBuf->tabName(tabId);
+  }
+
+  //----------------------------------------------------------------------------
+
+#ifndef IS_WINDOWS_BUILD
+  struct SqliteDatabase::ExternalChangeWatcher
+  {
+    explicit ExternalChangeWatcher(const string& dbFileName);
+    ~ExternalChangeWatcher();
+
+    /** \brief Reads all pending events and resets the wake-up eventfd; (re-)adds
+     * the watch for the WAL file if the file has been created in the meantime
+     */
+    void consumeEvents();
+
+    int inFd{-1};
+    int wakeFd{-1};
+    int walWd{-1};
+    string walPath;
+    string walName;   // without the directory
+  };
+
+  //----------------------------------------------------------------------------
+
+  SqliteDatabase::ExternalChangeWatcher::ExternalChangeWatcher(const string& dbFileName)
+  {
+    inFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inFd < 0)
+    {
+      throw std::runtime_error("SqliteDatabase: could not create inotify instance");
+    }
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0)
+    {
+      ::close(inFd);
+      throw std::runtime_error("SqliteDatabase: could not create eventfd");
+    }
+
+    // in-memory databases can't be modified by others
+    if (dbFileName.empty()) return;
+
+    walPath = dbFileName + "-wal";
+    const auto sepPos = walPath.rfind('/');
+    const string dirName = (sepPos == string::npos) ? "." : walPath.substr(0, sepPos + 1);
+    walName = (sepPos == string::npos) ? walPath : walPath.substr(sepPos + 1);
+
+    // watch the directory before the WAL file so that we
+    // can't miss its creation; a missing WAL file simply means
+    // that the database is not (yet) in WAL mode
+    const bool isWatched = (inotify_add_watch(inFd, dbFileName.c_str(), IN_MODIFY | IN_CLOSE_WRITE) >= 0) &&
+                           (inotify_add_watch(inFd, dirName.c_str(), IN_CREATE | IN_MOVED_TO) >= 0);
+    if (!isWatched)
+    {
+      ::close(wakeFd);
+      ::close(inFd);
+      throw std::runtime_error("SqliteDatabase: could not watch the database file for changes");
+    }
+    walWd = inotify_add_watch(inFd, walPath.c_str(), IN_MODIFY | IN_CLOSE_WRITE);
+  }
+
+  //----------------------------------------------------------------------------
+
+  SqliteDatabase::ExternalChangeWatcher::~ExternalChangeWatcher()
+  {
+    ::close(wakeFd);
+    ::close(inFd);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::ExternalChangeWatcher::consumeEvents()
+  {
+    alignas(inotify_event) char evBuf[4096];
+    while (true)
+    {
+      const ssize_t n = read(inFd, evBuf, sizeof(evBuf));
+      if (n <= 0) break;
+
+      for (ssize_t pos = 0; pos < n; )
+      {
+        const inotify_event* ev = reinterpret_cast<const inotify_event*>(evBuf + pos);
+        pos += sizeof(inotify_event) + ev->len;
+
+        // the kernel removes the watch when the WAL file is deleted
+        if ((ev->wd == walWd) && ((ev->mask & IN_IGNORED) != 0)) walWd = -1;
+
+        const bool isCreated = ((ev->mask & (IN_CREATE | IN_MOVED_TO)) != 0);
+        if (isCreated && (ev->len > 0) && (walName == ev->name))
+        {
+          walWd = inotify_add_watch(inFd, walPath.c_str(), IN_MODIFY | IN_CLOSE_WRITE);
+        }
+      }
+    }
 
-    return tmpLog;
+    uint64_t cnt;
+    [[maybe_unused]] auto rc = read(wakeFd, &cnt, sizeof(cnt));
+  }
+#else
+  struct SqliteDatabase::ExternalChangeWatcher {};
+#endif
+
+  //----------------------------------------------------------------------------
+
+  ChangeSource SqliteDatabase::waitForChanges(chrono::milliseconds timeout, ChangeSource filter)
+  {
+    const bool wantLocal = (static_cast<int>(filter) & static_cast<int>(ChangeSource::Local)) != 0;
+    const bool wantExternal = (static_cast<int>(filter) & static_cast<int>(ChangeSource::External)) != 0;
+
+    ChangeLogBuffer* buf{nullptr};
+    if (wantLocal)
+    {
+      lock_guard<mutex> lg{changeLogMutex};
+
+      if (!isChangeLogEnabled)
+      {
+        throw std::logic_error("SqliteDatabase: waiting for local changes requires an enabled changelog");
+      }
+      buf = changeLogBuf.get();
+    }
+
+    auto pendingChanges = [&]() {
+      int result{0};
+      if (wantLocal && (buf->size() > 0)) result |= static_cast<int>(ChangeSource::Local);
+      if (wantExternal && hasExternalChanges()) result |= static_cast<int>(ChangeSource::External);
+      return static_cast<ChangeSource>(result);
+    };
+
+    // "forever" (e.g., `milliseconds::max()`) would overflow the clock arithmetic
+    constexpr chrono::milliseconds MaxTimeout = chrono::hours{24 * 365 * 10};
+    timeout = std::clamp(timeout, chrono::milliseconds{0}, MaxTimeout);
+
+    // local changes only: no file descriptors involved
+    if (!wantExternal)
+    {
+      return buf->waitForEntries(timeout) ? ChangeSource::Local : ChangeSource::None;
+    }
+
+    const auto deadline = chrono::steady_clock::now() + timeout;
+
+#ifndef IS_WINDOWS_BUILD
+    if (!changeWatcher) changeWatcher = make_unique<ExternalChangeWatcher>(filename());
+    const int inFd = changeWatcher->inFd;
+    const int wakeFd = changeWatcher->wakeFd;
+
+    // discard old events before the first check; the check
+    // covers everything that happened before
+    changeWatcher->consumeEvents();
+
+    if (wantLocal) buf->addWakeFd(wakeFd);
+
+    ChangeSource result{ChangeSource::None};
+    try
+    {
+      while (true)
+      {
+        result = pendingChanges();
+        if (result != ChangeSource::None) break;
+
+        const auto remaining = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+        if (remaining.count() <= 0) break;
+
+        pollfd fds[2] = {{inFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+        const auto pollTimeout = std::min<chrono::milliseconds::rep>(remaining.count(), std::numeric_limits<int>::max());
+        const int rc = poll(fds, wantLocal ? 2 : 1, static_cast<int>(pollTimeout));
+        if (rc <= 0) continue;   // timeout or EINTR; we re-check and terminate in the next round
+
+        // the content of the events doesn't matter because
+        // we confirm all changes with the checks above
+        changeWatcher->consumeEvents();
+      }
+    }
+    catch (...)
+    {
+      if (wantLocal) buf->removeWakeFd(wakeFd);
+      throw;
+    }
+    if (wantLocal) buf->removeWakeFd(wakeFd);
+
+    return result;
+#else
+    // no inotify: check for external changes at regular intervals
+    // and wait for local changes in between
+    while (true)
+    {
+      ChangeSource result = pendingChanges();
+      if (result != ChangeSource::None) return result;
+
+      const auto remaining = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+      if (remaining.count() <= 0) return ChangeSource::None;
+
+      const auto slice = std::min(remaining, chrono::milliseconds{50});
+      if (wantLocal)
+      {
+        buf->waitForEntries(slice);
+      } else {
+        this_thread::sleep_for(slice);
+      }
+    }
+#endif
   }
 
   //----------------------------------------------------------------------------
@@ -712,9 +1193,18 @@ namespace SqliteOverlay
 
     if (isChangeLogEnabled) return;
 
-    if (clearLog) changeLog.clear();
+    if (changeLogBuf == nullptr)
+    {
+      changeLogBuf = make_unique<ChangeLogBuffer>();
+    } else {
+      if (clearLog) changeLogBuf->clear();
+    }
 
-    setDataChangeNotificationCallback(changeLogCallback, &logCallbackContext);
+    // the changelog replaces any user-provided callback
+    userUpdateHook = nullptr;
+    userUpdateHookPtr = nullptr;
+    activeChangeLog = changeLogBuf.get();
+    updateHookRegistration();
     isChangeLogEnabled = true;
   }
 
@@ -726,10 +1216,13 @@ namespace SqliteOverlay
 
     if (!isChangeLogEnabled) return;
 
-    if (clearLog) changeLog.clear();
-
-    setDataChangeNotificationCallback(nullptr, nullptr);
+    userUpdateHook = nullptr;
+    userUpdateHookPtr = nullptr;
+    activeChangeLog = nullptr;
+    updateHookRegistration();
     isChangeLogEnabled = false;
+
+    if (clearLog) changeLogBuf->clear();
   }
 
   //----------------------------------------------------------------------------
@@ -813,11 +1306,279 @@ namespace SqliteOverlay
 
   SqlStatement SqliteDatabase::prepStatement(const string& sqlText) const
   {
+    if (stmtCache) return stmtCache->acquire(sqlText);
+
     return SqlStatement{dbPtr, sqlText};
   }
 
   //----------------------------------------------------------------------------
 
+  SqlStatement SqliteDatabase::prepCachedStatement(string_view sqlText) const
+  {
+    if (stmtCache) return stmtCache->acquire(sqlText);
+
+    return SqlStatement{dbPtr, string{sqlText}};
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::enableStatementCache(size_t maxIdleStatements)
+  {
+    if (dbPtr == nullptr)
+    {
+      throw std::invalid_argument("enableStatementCache(): database connection is closed");
+    }
+
+    if (stmtCache)
+    {
+      stmtCache->setCapacity(maxIdleStatements);
+      return;
+    }
+
+    stmtCache = make_shared<StatementCache>(dbPtr, maxIdleStatements);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::disableStatementCache()
+  {
+    stmtCache.reset();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::interrupt() const
+  {
+    if (dbPtr == nullptr)
+    {
+      throw std::invalid_argument("interrupt(): database connection is closed");
+    }
+
+    sqlite3_interrupt(dbPtr);
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::setProgressHandler(int nOps, int (*handler)(void*), void* ctx) const
+  {
+    if (dbPtr == nullptr)
+    {
+      throw std::invalid_argument("setProgressHandler(): database connection is closed");
+    }
+
+    sqlite3_progress_handler(dbPtr, nOps, handler, ctx);
+  }
+
+  //----------------------------------------------------------------------------
+
+  size_t SqliteDatabase::releaseMemory(bool flushCache, bool clearStatementCache)
+  {
+    if (dbPtr == nullptr)
+    {
+      throw std::invalid_argument("releaseMemory(): database connection is closed");
+    }
+
+    size_t nFinalized{0};
+    if (clearStatementCache && stmtCache)
+    {
+      nFinalized = stmtCache->stats().nIdle;
+      stmtCache->clear();
+    }
+
+    // dirty pages can't be released; ignore errors because
+    // flushing is just a best-effort attempt
+    if (flushCache) sqlite3_db_cacheflush(dbPtr);
+
+    sqlite3_db_release_memory(dbPtr);
+
+    return nFinalized;
+  }
+
+  //----------------------------------------------------------------------------
+
+  ConnectionStats SqliteDatabase::stats(bool resetCounters, bool includeMemoryStatus) const
+  {
+    if (dbPtr == nullptr)
+    {
+      throw std::invalid_argument("stats(): database connection is closed");
+    }
+
+    const int r = resetCounters ? 1 : 0;
+    ConnectionStats result;
+
+    // returns either the current value or the highwater mark of a counter
+    auto dbStatus = [&](int op, bool useHighwater, int reset) -> int64_t
+    {
+      int cur{0};
+      int hi{0};
+      sqlite3_db_status(dbPtr, op, &cur, &hi, reset);
+      return useHighwater ? hi : cur;
+    };
+
+    result.cacheHits = dbStatus(SQLITE_DBSTATUS_CACHE_HIT, false, r);
+    result.cacheMisses = dbStatus(SQLITE_DBSTATUS_CACHE_MISS, false, r);
+    result.cacheWrites = dbStatus(SQLITE_DBSTATUS_CACHE_WRITE, false, r);
+    result.cacheSpills = dbStatus(SQLITE_DBSTATUS_CACHE_SPILL, false, r);
+    result.cacheUsed = dbStatus(SQLITE_DBSTATUS_CACHE_USED, false, 0);
+    result.lookasideHits = dbStatus(SQLITE_DBSTATUS_LOOKASIDE_HIT, true, r);
+    result.lookasideMissSize = dbStatus(SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE, true, r);
+    result.lookasideMissFull = dbStatus(SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL, true, r);
+    result.schemaUsed = dbStatus(SQLITE_DBSTATUS_SCHEMA_USED, false, 0);
+    result.stmtUsed = dbStatus(SQLITE_DBSTATUS_STMT_USED, false, 0);
+
+    // current value and highwater mark with a single call
+    // because a reset affects both of them
+    int luCur{0};
+    int luHi{0};
+    sqlite3_db_status(dbPtr, SQLITE_DBSTATUS_LOOKASIDE_USED, &luCur, &luHi, r);
+    result.lookasideUsed = luCur;
+    result.lookasideHighwater = luHi;
+
+    if (includeMemoryStatus) readMemoryStatus(result, resetCounters);
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::readMemoryStatus(ConnectionStats& dst, bool resetHighwater)
+  {
+    sqlite3_int64 memCur{0};
+    sqlite3_int64 memHi{0};
+    sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &memCur, &memHi, resetHighwater ? 1 : 0);
+    dst.memoryUsed = memCur;
+    dst.memoryHighwater = memHi;
+  }
+
+  //----------------------------------------------------------------------------
+
+  bool SqliteDatabase::isSerialized() const
+  {
+    return (dbPtr != nullptr) && (sqlite3_db_mutex(dbPtr) != nullptr);
+  }
+
+  //----------------------------------------------------------------------------
+
+  shared_ptr<SqlMetricsRegistry> SqliteDatabase::enableSqlMetrics(shared_ptr<SqlMetricsRegistry> registry)
+  {
+    if (dbPtr == nullptr)
+    {
+      throw std::invalid_argument("enableSqlMetrics(): database connection is closed");
+    }
+
+    if (!registry) registry = make_shared<SqlMetricsRegistry>();
+    if (!traceHooks) traceHooks = make_unique<SqlTraceHooks>();
+    traceHooks->metrics = registry;
+    traceHooks->stmtInfo.clear();
+    updateTraceRegistration();
+
+    return registry;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::disableSqlMetrics()
+  {
+    if (!traceHooks) return;
+
+    traceHooks->metrics.reset();
+    traceHooks->stmtInfo.clear();
+    updateTraceRegistration();
+  }
+
+  //----------------------------------------------------------------------------
+
+  shared_ptr<SqlMetricsRegistry> SqliteDatabase::getSqlMetrics() const
+  {
+    return traceHooks ? traceHooks->metrics : nullptr;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::enableSlowQueryLog(shared_ptr<SlowQueryLog> log, chrono::microseconds threshold)
+  {
+    if (dbPtr == nullptr)
+    {
+      throw std::invalid_argument("enableSlowQueryLog(): database connection is closed");
+    }
+    if (!log)
+    {
+      throw std::invalid_argument("enableSlowQueryLog(): received empty log");
+    }
+
+    if (!traceHooks) traceHooks = make_unique<SqlTraceHooks>();
+    traceHooks->slowLog = log;
+    traceHooks->slowThreshold_ns = static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(threshold).count());
+    updateTraceRegistration();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::disableSlowQueryLog()
+  {
+    if (!traceHooks) return;
+
+    traceHooks->slowLog.reset();
+    updateTraceRegistration();
+  }
+
+  //----------------------------------------------------------------------------
+
+  shared_ptr<SlowQueryLog> SqliteDatabase::getSlowQueryLog() const
+  {
+    return traceHooks ? traceHooks->slowLog : nullptr;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::setSqlTraceCallback(function<void (string_view)> cb)
+  {
+    if (dbPtr == nullptr)
+    {
+      throw std::invalid_argument("setSqlTraceCallback(): database connection is closed");
+    }
+
+    if (!traceHooks) traceHooks = make_unique<SqlTraceHooks>();
+    traceHooks->stmtLogger = std::move(cb);
+    updateTraceRegistration();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::updateTraceRegistration()
+  {
+    if (dbPtr == nullptr) return;
+
+    unsigned int mask{0};
+    if (traceHooks && (traceHooks->metrics || traceHooks->slowLog)) mask |= (SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW);
+    if (traceHooks && (traceHooks->metrics || traceHooks->stmtLogger)) mask |= SQLITE_TRACE_STMT;
+
+    if (mask == 0)
+    {
+      sqlite3_trace_v2(dbPtr, 0, nullptr, nullptr);
+    } else {
+      sqlite3_trace_v2(dbPtr, mask, sqlTraceCallback, traceHooks.get());
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  StatementCacheStats SqliteDatabase::getStatementCacheStats() const
+  {
+    if (!stmtCache) return StatementCacheStats{};
+
+    return stmtCache->stats();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void SqliteDatabase::resetStatementCacheStats()
+  {
+    if (stmtCache) stmtCache->resetStats();
+  }
+
+  //----------------------------------------------------------------------------
+
   string buildColumnConstraint(ConflictClause uniqueConflictClause, ConflictClause notNullConflictClause, const string& defaultVal)
   {
     string result = buildColumnConstraint(uniqueConflictClause, notNullConflictClause);
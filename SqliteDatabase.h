@@ -1,25 +1,38 @@
 #pragma once
 
 #include <stddef.h>         // for size_t
-#include <stdint.h>         // for int64_t
+#include <stdint.h>         // for int64_t, uint64_t
+#include <atomic>           // for atomic
+#include <chrono>           // for microseconds
+#include <functional>       // for function
+#include <memory>           // for shared_ptr, unique_ptr
 #include <mutex>            // for mutex
 #include <optional>         // for optional
 #include <stdexcept>        // for invalid_argument
 #include <string>           // for string, allocator
+#include <utility>          // for pair
+#include <vector>           // for vector
 
 #include <sqlite3.h>        // for sqlite3, sqlite3_int64
 
 #include <Sloppy/String.h>  // for StringList
 
-#include "Changelog.h"      // for ChangeLogList, ChangeLogCallbackContext
+#include "Changelog.h"      // for ChangeLogList, ChangeLogBuffer, CompactChangeLogEntry
 #include "Defs.h"           // for ConflictClause, OpenMode, TransactionDtor...
+#include "SlowQueryLog.h"   // for SlowQueryLog
+#include "SqlMetrics.h"     // for SqlMetricsRegistry, SqlTraceHooks
 #include "SqlStatement.h"   // for SqlStatement
+#include "StatementCache.h" // for StatementCache, StatementCacheStats
 
 namespace SqliteOverlay
 {
   // a forward definitions
   class KeyValueTab;
   class Transaction;
+  class MemoryBudgetManager;
+
+  // the default capacity of a statement cache
+  constexpr size_t DefaultStatementCacheSize = 64;
 
   // a pseudo-always-false expression for conditional static_asserts
   // in templates
@@ -164,14 +177,15 @@ namespace SqliteOverlay
      * on a non-existing file).
      *
      * \throws GenericSqliteException incl. error code if anything goes wrong
-     * with SQLite
+     * with SQLite, e.g. if an OpenOptions setting couldn't be applied
      *
      * Test case: yes
      *
      */
     SqliteDatabase(
         std::string dbFilename, ///< the name of the database file to open or create
-        OpenMode om   ///< the opening mode (e.g., read-only)
+        OpenMode om,   ///< the opening mode (e.g., read-only)
+        const OpenOptions& opts = OpenOptions{}   ///< performance settings that are applied right after opening
         );
 
     /** \brief Dtor; closes the database connections and cleans up table cache
@@ -251,6 +265,9 @@ namespace SqliteOverlay
     bool isAlive() const;
 
     /** \brief Creates a new SQL statement for this database connection
+     *
+     * If the statement cache is enabled, the statement is taken from the cache
+     * if possible and it is returned to the cache when the SqlStatement is destroyed.
      *
      * \throws std::invalid_argument if the provided SQL string is empty or if the connection has been closed before calling this method
      *
@@ -265,6 +282,26 @@ namespace SqliteOverlay
         const std::string& sqlText   ///< the SQL text for which to create the statement
         ) const;
 
+    /** \brief Creates a new SQL statement for this database connection without
+     * copying the SQL text on statement cache hits
+     *
+     * Meant for SQL texts that are re-used many times, e.g. the compile-time
+     * generated SQL of GenericView / GenericTable. If the statement cache is
+     * disabled, the statement is freshly prepared just like in `prepStatement()`.
+     *
+     * \throws std::invalid_argument if the provided SQL string is empty or if the connection has been closed before calling this method
+     *
+     * \throws SqlStatementCreationError if the statement could not be created, most likely due to invalid SQL syntax
+     *
+     * \returns a SqlStatement instance for the provided SQL text
+     *
+     * Test case: yes
+     *
+     */
+    SqlStatement prepCachedStatement(
+        std::string_view sqlText   ///< the SQL text for which to create the statement
+        ) const;
+
     /** \brief Executes a SQL statement that isn't expected to return any data.
      *
      * If the SQL statement consists of multiple steps, all steps are executed
@@ -460,6 +497,41 @@ namespace SqliteOverlay
         bool syncOn   ///< `true`: activate sync write, `false`: deactivate sync writes
         ) const;
 
+    /** \brief Applies a set of performance settings (PRAGMAs, busy timeout)
+     * to the connection.
+     *
+     * This is called from the ctor but can also be used to re-tune an already
+     * open connection. Settings that are not set in `opts` are left untouched.
+     *
+     * The page size is only applied if the database is still empty. The
+     * page size and the journal mode are skipped for read-only connections.
+     *
+     * The busy timeout is applied first so that it already covers the other settings.
+     *
+     * \throws std::invalid_argument if the database is not open
+     *
+     * \throws BusyException if a setting couldn't be applied because the DB was busy
+     *
+     * \throws GenericSqliteException if SQLite refused to switch to the requested journal
+     * mode (e.g., WAL on a file system without shared memory support); in-memory and temporary
+     * databases are exempt from this check because they only support MEMORY and OFF
+     *
+     * \throws GenericSqliteException incl. error code if anything else goes wrong
+     *
+     * Test case: yes
+     *
+     */
+    void applyOpenOptions(
+        const OpenOptions& opts   ///< the settings to apply
+        );
+
+    /** \returns the settings that have most recently been applied to this connection
+     *
+     * Test case: yes
+     *
+     */
+    const OpenOptions& getOpenOptions() const { return openOptions; }
+
     /** \brief Hook for derived database classes to fill in their code for populating
      * all database tables.
      *
@@ -597,6 +669,18 @@ namespace SqliteOverlay
      */
     int getLastInsertId() const;
 
+    /** \returns the current value of a run-time limit of the connection, e.g.
+     * `SQLITE_LIMIT_VARIABLE_NUMBER`
+     *
+     * See also [here](https://www.sqlite.org/c3ref/limit.html)
+     *
+     * Test case: implicitly in the `DbTab_InsertRows` test case
+     *
+     */
+    int getLimit(
+        int limitId   ///< the ID of the limit, one of the `SQLITE_LIMIT_...` constants
+        ) const;
+
     /** \returns the number of rows modified, inserted or deleted by the most recently completed INSERT, UPDATE or DELETE statement
      *
      * See also [here](https://www.sqlite.org/c3ref/changes.html)
@@ -764,6 +848,9 @@ namespace SqliteOverlay
      *
      * See also [here](https://www.sqlite.org/c3ref/update_hook.html)
      *
+     * There is only one user-provided callback per connection; internal consumers
+     * of the update hook (e.g., the table write counters) are not affected by this call.
+     *
      * \returns the custom data pointer that was previously set or nullptr if there was none
      */
     void* setDataChangeNotificationCallback(
@@ -771,13 +858,136 @@ namespace SqliteOverlay
         void* customPtr   ///< a pointer that will be passed to the callback function
         );
 
+    /** \brief Provides a counter that is incremented whenever a row of a given table
+     * is inserted, updated or deleted through this connection.
+     *
+     * Comparing the counter with a previously seen value is a cheap way of detecting
+     * local modifications of a specific table, e.g. for invalidating caches. The counter
+     * is maintained by the update hook and thus has the same limitations: changes
+     * by other connections, `DELETE` statements without `WHERE` clause (truncate
+     * optimization) and rows removed by `REPLACE` conflict resolution are not reported.
+     *
+     * All callers that request the counter for the same table share the same counter. The
+     * counter is maintained as long as at least one caller holds a reference to it.
+     *
+     * Test case: yes
+     *
+     */
+    std::shared_ptr<const std::atomic<uint64_t>> getTableWriteCounter(
+        const std::string& tabName   ///< the name of the table (case-insensitive)
+        );
+
     /** \returns the current number of entries in the changelog
      */
     size_t getChangeLogLength();
 
     /** \returns all entries in the changelog and clears the log afterwards
+     *
+     * If `coalesce` is `true`, the list is sorted by table and rowid and contains only
+     * the net effect per row; see `coalesceChangeLog()` for details.
      */
-    ChangeLogList getAllChangesAndClearQueue();
+    ChangeLogList getAllChangesAndClearQueue(
+        bool coalesce = false   ///< if `true`, multiple changes of the same row are merged into one entry
+        );
+
+    /** \brief Moves all entries of the changelog to the end of a caller-provided
+     * vector and clears the log.
+     *
+     * Compared to `getAllChangesAndClearQueue()` this avoids any per-entry string
+     * copies: database and table names are returned as integer IDs that can be
+     * resolved with `changeLogDbName()` and `changeLogTabName()`. By reusing the
+     * same vector, repeated draining doesn't allocate memory either.
+     *
+     * Draining is safe while another thread is writing to the database.
+     *
+     * If `coalesce` is `true`, the new entries are reduced to the net effect
+     * per row (see `coalesceChangeLog()`). Coalescing only covers the changes since
+     * the last drain; the existing content of `dst` is not modified.
+     *
+     * \returns the number of entries that have been appended to `dst`
+     *
+     * Test case: yes
+     *
+     */
+    size_t drainChangeLog(
+        std::vector<CompactChangeLogEntry>& dst,   ///< the vector that receives the entries
+        bool coalesce = false   ///< if `true`, multiple changes of the same row are merged into one entry
+        );
+
+    /** \brief Restricts the changelog to a set of tables
+     *
+     * Changes to other tables are dropped at capture time and never
+     * enter the log. The filter applies to tables of any attached database
+     * and takes effect for the next change. An empty list disables the filter.
+     *
+     * The filter can be set independently of whether the changelog
+     * is currently enabled and is kept when the changelog is disabled.
+     *
+     * Test case: yes
+     *
+     */
+    void setChangeLogTableFilter(
+        const std::vector<std::string>& tabNames   ///< the names of the tables that shall be logged
+        );
+
+    /** \brief Blocks until the database has been modified or until a timeout has expired
+     *
+     * This replaces polling loops around `getChangeLogLength()` and `hasExternalChanges()`:
+     *
+     *   * local changes are changelog entries that have not been retrieved yet; the thread
+     *     that writes the changes wakes up the waiter directly, so the changelog must
+     *     be enabled (see `enableChangeLog()`) and respects the table filter;
+     *   * external changes are detected with an inotify watch on the database
+     *     file and its `-wal` file; a watch on the directory catches the creation of
+     *     the `-wal` file. The watches are set up by the first call and are kept for
+     *     the lifetime of the connection. Every file event is confirmed with `hasExternalChanges()`
+     *     because the files are also modified by this connection and by readers. Like
+     *     `hasExternalChanges()`, this reports changes since the last call
+     *     to `resetExternalChangeCounter()`.
+     *
+     * The function returns immediately if there are pending changes already.
+     *
+     * Local changes can be written by other threads through this connection
+     * while a thread is waiting. However, only one thread at a time may wait.
+     *
+     * \note Without inotify (e.g., on Windows), external changes are polled every 50 ms.
+     *
+     * \throws std::logic_error if `filter` contains `ChangeSource::Local` but the changelog is not enabled
+     *
+     * \throws std::runtime_error if the inotify watches for the database file and its directory could not be created
+     *
+     * \returns the kinds of changes that are pending (`ChangeSource::Any` for both)
+     * or `ChangeSource::None` if the timeout has expired
+     *
+     * Test case: yes
+     *
+     */
+    ChangeSource waitForChanges(
+        std::chrono::milliseconds timeout,   ///< the max time to wait; `std::chrono::milliseconds::max()` waits (practically) forever
+        ChangeSource filter = ChangeSource::Any   ///< the kinds of changes to wait for
+        );
+
+    /** \returns the name of the database for an ID in a CompactChangeLogEntry
+     *
+     * \throws std::invalid_argument if the ID is unknown
+     *
+     * Test case: yes
+     *
+     */
+    std::string changeLogDbName(
+        uint16_t dbId   ///< the database ID of a changelog entry
+        ) const;
+
+    /** \returns the name of the table for an ID in a CompactChangeLogEntry
+     *
+     * \throws std::invalid_argument if the ID is unknown
+     *
+     * Test case: yes
+     *
+     */
+    std::string changeLogTabName(
+        uint32_t tabId   ///< the table ID of a changelog entry
+        ) const;
 
     /** \brief Enables a built-in callback function that implements a simple
      * changelog.
@@ -810,6 +1020,230 @@ namespace SqliteOverlay
         int ms   ///< the timeout in milliseconds; if less or equal to 0, we don't wait an throw BusyException immediately
         );
 
+    /** \brief Enables an LRU cache of prepared statements for this connection, keyed by the
+     * statement's SQL text; if the cache is already enabled, only its capacity is changed.
+     *
+     * All subsequent calls to `prepStatement()` (and thus all functions that are built
+     * on top of it) will be served from the cache, if possible. The statements are
+     * reset and their bindings are cleared when they are handed back to the cache.
+     *
+     * \note The cache is disabled by default.
+     *
+     * \note Idle statements in the cache are finalized by `close()`; leased statements
+     * that are still alive will still prevent the connection from being closed.
+     *
+     * Test case: yes
+     *
+     */
+    void enableStatementCache(
+        size_t maxIdleStatements = DefaultStatementCacheSize   ///< the max number of idle statements in the cache
+        );
+
+    /** \brief Disables the statement cache and finalizes all idle statements in it;
+     * statements that are currently leased will be finalized when they are destroyed.
+     *
+     * Test case: yes
+     *
+     */
+    void disableStatementCache();
+
+    /** \returns `true` if the statement cache is enabled
+     *
+     * Test case: yes
+     *
+     */
+    bool isStatementCacheEnabled() const { return (stmtCache != nullptr); }
+
+    /** \returns the hit/miss counters of the statement cache; all values are zero
+     * if the cache is disabled.
+     *
+     * Test case: yes
+     *
+     */
+    StatementCacheStats getStatementCacheStats() const;
+
+    /** \brief Resets the hit/miss counters of the statement cache (if enabled)
+     *
+     * Test case: yes
+     *
+     */
+    void resetStatementCacheStats();
+
+    /** \brief Retrieves the page cache, lookaside and memory statistics of this
+     * connection plus the process-wide memory usage of SQLite.
+     *
+     * Useful for checking whether `cache_size` fits the workload: a high
+     * miss ratio or a growing number of cache spills indicates that the
+     * connection is thrashing its page cache.
+     *
+     * \note If `resetCounters` is `true`, the cache and lookaside counters of
+     * this connection as well as the process-wide memory highwater mark are
+     * reset after reading them; this allows for periodic sampling of deltas.
+     *
+     * \throws std::invalid_argument if the connection is closed
+     *
+     * Test case: yes
+     *
+     */
+    ConnectionStats stats(
+        bool resetCounters = false,   ///< if `true`, counters and highwater marks are reset after reading them
+        bool includeMemoryStatus = true   ///< if `false`, the process-wide memory usage is neither read nor reset
+        ) const;
+
+    /** \brief Reads the process-wide memory usage of SQLite into `memoryUsed`
+     * and `memoryHighwater`; all other fields of `dst` remain unchanged
+     *
+     * Test case: yes, implicitly by `stats()`
+     *
+     */
+    static void readMemoryStatus(
+        ConnectionStats& dst,   ///< the target for the memory values
+        bool resetHighwater = false   ///< if `true`, the process-wide highwater mark is reset after reading it
+        );
+
+    /** \returns `true` if the connection uses the serialized threading mode, i.e. if SQLite
+     * itself serializes concurrent API calls on this connection (see `OpenOptions::serializedAccess`)
+     *
+     * Test case: yes
+     *
+     */
+    bool isSerialized() const;
+
+    /** \brief Aborts all statements that are currently running on this connection;
+     * they fail with `PrimaryResultCode::INTERRUPT`.
+     *
+     * This is the only method that may be called from a different thread while
+     * the connection is in use (see `sqlite3_interrupt()`). It has no
+     * effect if no statement is running.
+     *
+     * \throws std::invalid_argument if the connection is closed
+     *
+     * Test case: yes, implicitly in the AsyncExecutor test cases
+     *
+     */
+    void interrupt() const;
+
+    /** \brief Registers a callback that SQLite invokes approximately every `nOps`
+     * virtual machine operations while a statement is running on this connection;
+     * if the callback returns non-zero, the statement fails with `PrimaryResultCode::INTERRUPT`.
+     *
+     * There is only one handler per connection; a `nullptr` handler removes the
+     * current one (see `sqlite3_progress_handler()`).
+     *
+     * \throws std::invalid_argument if the connection is closed
+     *
+     * Test case: yes, implicitly in the AsyncExecutor test cases
+     *
+     */
+    void setProgressHandler(
+        int nOps,   ///< the approximate number of VM operations between two invocations of the handler
+        int (*handler)(void*),   ///< the callback or `nullptr`
+        void* ctx   ///< the argument for the callback
+        ) const;
+
+    /** \brief Shrinks the memory footprint of this connection without closing it
+     *
+     * Optionally writes all dirty pages to disk (`sqlite3_db_cacheflush()`) and finalizes
+     * all idle statements in the statement cache. Afterwards, as much page cache memory
+     * as possible is released (`sqlite3_db_release_memory()`).
+     *
+     * Flushing is best effort: if the database is locked by another connection,
+     * the dirty pages simply stay in memory.
+     *
+     * \throws std::invalid_argument if the connection is closed
+     *
+     * \returns the number of idle statements that have been finalized
+     *
+     * Test case: yes
+     *
+     */
+    size_t releaseMemory(
+        bool flushCache = true,   ///< if `true`, dirty pages are written to disk first so that they can be released as well
+        bool clearStatementCache = true   ///< if `true`, all idle statements in the statement cache are finalized
+        );
+
+    /** \brief Starts recording execution counts, row counts and latencies of all
+     * statements on this connection, aggregated by statement fingerprint;
+     * see `SqlMetricsRegistry`.
+     *
+     * If metrics are already enabled, the previous registry is replaced.
+     *
+     * \note Metrics are disabled by default. When enabled, every statement
+     * execution costs a SQL normalization and a few atomic increments.
+     *
+     * \throws std::invalid_argument if the connection is closed
+     *
+     * \returns the registry that receives the data
+     *
+     * Test case: yes
+     *
+     */
+    std::shared_ptr<SqlMetricsRegistry> enableSqlMetrics(
+        std::shared_ptr<SqlMetricsRegistry> registry = nullptr   ///< a (potentially shared) registry; if empty, a new registry is created
+        );
+
+    /** \brief Stops recording metrics; the registry itself remains valid
+     * for everyone who holds a pointer to it
+     *
+     * Test case: yes
+     *
+     */
+    void disableSqlMetrics();
+
+    /** \returns the registry that currently receives the metrics of this connection
+     * or an empty pointer if metrics are disabled
+     *
+     * Test case: yes
+     *
+     */
+    std::shared_ptr<SqlMetricsRegistry> getSqlMetrics() const;
+
+    /** \brief Writes all statements on this connection that take `threshold` or longer
+     * to a slow-query log, incl. their expanded SQL, duration, number of rows
+     * and (once per fingerprint) their query plan; see `SlowQueryLog`.
+     *
+     * This also covers all SQL that is built internally (e.g., by DbTab, WhereClause
+     * or GenericView). If a slow-query log is already enabled, it is replaced.
+     *
+     * \throws std::invalid_argument if the connection is closed or if the log is empty
+     *
+     * Test case: yes
+     *
+     */
+    void enableSlowQueryLog(
+        std::shared_ptr<SlowQueryLog> log,   ///< the (potentially shared) log that receives the statements
+        std::chrono::microseconds threshold   ///< the min execution time for a statement to be logged
+        );
+
+    /** \brief Stops logging slow statements on this connection
+     *
+     * Test case: yes
+     *
+     */
+    void disableSlowQueryLog();
+
+    /** \returns the current slow-query log of this connection or
+     * an empty pointer if there is none
+     *
+     * Test case: yes
+     *
+     */
+    std::shared_ptr<SlowQueryLog> getSlowQueryLog() const;
+
+    /** \brief Sets a callback that receives the expanded SQL text (incl. bound values)
+     * of each statement when it starts executing.
+     *
+     * Meant for debugging; an empty function disables the callback.
+     *
+     * \throws std::invalid_argument if the connection is closed
+     *
+     * Test case: yes
+     *
+     */
+    void setSqlTraceCallback(
+        std::function<void(std::string_view)> cb   ///< the callback or an empty function
+        );
+
     /** \brief Creates a new SqliteDatabase object that works on the same database
      * file as the current connection.
      *
@@ -827,9 +1261,9 @@ namespace SqliteOverlay
      * with SQLite
      *
      * \returns a new SqliteDatabase instance that works on the same database file
-     * as the current instance
+     * as the current instance and that uses the same OpenOptions
      *
-     * Test case: not yet
+     * Test case: yes
      *
      */
     template<class DB_CLASS = SqliteDatabase>
@@ -847,7 +1281,15 @@ namespace SqliteOverlay
 
       OpenMode om = readOnly ? OpenMode::OpenExisting_RO : OpenMode::OpenExisting_RW;
 
-      return DB_CLASS{fn, om};
+      // the new connection inherits the settings of this connection
+      if constexpr (std::is_constructible_v<DB_CLASS, std::string, OpenMode, OpenOptions>)
+      {
+        return DB_CLASS{fn, om, openOptions};
+      } else {
+        DB_CLASS result{fn, om};
+        result.applyOpenOptions(openOptions);
+        return result;
+      }
     }
 
     /** \brief Function for creating a new, empty key-value-table in the database
@@ -930,11 +1372,56 @@ namespace SqliteOverlay
     int localChangeCounter_resetValue;  // used for calls to sqlite3_total_changes(), reporting changes on the local connection
     int externalChangeCounter_resetValue;   // used for calls to "PRAGMA data_version" which reports changes other than on the local connection
 
+    // the (optional) cache for prepared statements
+    std::shared_ptr<StatementCache> stmtCache;
+
+    // the most recently applied connection settings
+    OpenOptions openOptions;
+
+    // the targets of the trace hook; kept on the heap because
+    // its address is registered with SQLite and must survive moves
+    std::unique_ptr<SqlTraceHooks> traceHooks;
+
+    // (re-)registers or removes the SQLite trace callback
+    // depending on the current content of `traceHooks`
+    void updateTraceRegistration();
+
+    // the update hook is shared by the user-provided callback, the changelog and
+    // the table write counters; `this` is registered as the custom pointer
+    static void updateHookDispatcher(void* customPtr, int modType, const char* dbName, const char* tabName, sqlite3_int64 id);
+    void updateHookRegistration();
+    void(*userUpdateHook)(void*, int, const char*, const char*, sqlite3_int64){nullptr};
+    void* userUpdateHookPtr{nullptr};
+    std::atomic<ChangeLogBuffer*> activeChangeLog{nullptr};   // set while the changelog is enabled
+
+    // the table write counters; the update hook reads the active list without
+    // locking, getTableWriteCounter() replaces the whole list (copy-on-write)
+    struct TabWriteCounterList
+    {
+      std::vector<std::pair<std::string, std::shared_ptr<std::atomic<uint64_t>>>> counters;
+
+      // the result of the most recent lookup; only used by the update hook
+      std::string lastTabName;
+      size_t lastIdx{0};
+
+      void increment(const char* tabName);
+    };
+    std::unique_ptr<TabWriteCounterList> tabWriteCounters;   // owns the active list
+    std::atomic<TabWriteCounterList*> activeTabWriteCounters{nullptr};
+    std::mutex tabWriteCounterMutex;   // serializes the writers of the list
+
+    // `true` if the connection is registered with the MemoryBudgetManager
+    friend class MemoryBudgetManager;
+    bool isMemoryManaged{false};
+
     // a queue of changes
     bool isChangeLogEnabled{false};
-    ChangeLogList changeLog;
-    std::mutex changeLogMutex;
-    ChangeLogCallbackContext logCallbackContext;
+    std::unique_ptr<ChangeLogBuffer> changeLogBuf;   // created on first use
+    mutable std::mutex changeLogMutex;   // serializes the readers of the changelog
+
+    // the file system watches of waitForChanges(); created on first use
+    struct ExternalChangeWatcher;
+    std::unique_ptr<ExternalChangeWatcher> changeWatcher;
   };
 
 }
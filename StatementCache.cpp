@@ -0,0 +1,179 @@
+#include <iterator>               // for prev
+#include <stdexcept>              // for invalid_argument
+#include <utility>                // for move
+
+#include "SqliteExceptions.h"     // for SqlStatementCreationError
+
+#include "StatementCache.h"
+
+using namespace std;
+
+namespace SqliteOverlay
+{
+
+  StatementCache::StatementCache(sqlite3* _dbPtr, size_t _maxIdle)
+    :dbPtr{_dbPtr}, maxIdle{_maxIdle}
+  {
+    if (dbPtr == nullptr)
+    {
+      throw std::invalid_argument("StatementCache ctor: received null-pointer for database handle");
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+  StatementCache::~StatementCache()
+  {
+    clear();
+  }
+
+  //----------------------------------------------------------------------------
+
+  SqlStatement StatementCache::acquire(string_view sqlText)
+  {
+    if (sqlText.empty())
+    {
+      throw std::invalid_argument("Received empty SQL statement");
+    }
+
+    // try to serve the request from the cache
+    {
+      lock_guard<mutex> lg{cacheMutex};
+
+      auto it = index.find(sqlText);
+      if (it != index.end())
+      {
+        auto listIt = it->second;
+        index.erase(it);   // before the key string gets moved out of the list
+
+        sqlite3_stmt* stmt = listIt->second;
+        string key = std::move(listIt->first);
+        idle.erase(listIt);
+
+        ++nHits;
+
+        return SqlStatement{stmt, weak_from_this(), std::move(key)};
+      }
+
+      ++nMisses;
+    }
+
+    // cache miss: prepare a new statement; this
+    // can happen without holding the lock
+    sqlite3_stmt* stmt{nullptr};
+    const int err = sqlite3_prepare_v3(dbPtr, sqlText.data(), static_cast<int>(sqlText.size()), SQLITE_PREPARE_PERSISTENT, &stmt, nullptr);
+    if (err != SQLITE_OK)
+    {
+      throw SqlStatementCreationError(err, string{sqlText}, sqlite3_errmsg(dbPtr));
+    }
+
+    return SqlStatement{stmt, weak_from_this(), string{sqlText}};
+  }
+
+  //----------------------------------------------------------------------------
+
+  void StatementCache::giveBack(string&& sqlText, sqlite3_stmt* stmt)
+  {
+    if (stmt == nullptr) return;
+
+    // sqlite3_reset() returns the error code of the most
+    // recent call to sqlite3_step(). If the statement is
+    // stale (schema change that couldn't be handled by
+    // re-preparing), we don't want it back.
+    const int err = sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    lock_guard<mutex> lg{cacheMutex};
+
+    if ((err == SQLITE_SCHEMA) || (err == SQLITE_ERROR) || (maxIdle == 0))
+    {
+      sqlite3_finalize(stmt);
+      ++nEvictions;
+      return;
+    }
+
+    idle.emplace_front(std::move(sqlText), stmt);
+    index.emplace(idle.front().first, idle.begin());
+
+    trim_NoLock();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void StatementCache::clear()
+  {
+    lock_guard<mutex> lg{cacheMutex};
+
+    for (auto& [sql, stmt] : idle)
+    {
+      sqlite3_finalize(stmt);
+    }
+
+    index.clear();
+    idle.clear();
+  }
+
+  //----------------------------------------------------------------------------
+
+  void StatementCache::setCapacity(size_t newMaxIdle)
+  {
+    lock_guard<mutex> lg{cacheMutex};
+
+    maxIdle = newMaxIdle;
+    trim_NoLock();
+  }
+
+  //----------------------------------------------------------------------------
+
+  StatementCacheStats StatementCache::stats() const
+  {
+    lock_guard<mutex> lg{cacheMutex};
+
+    return StatementCacheStats{
+      .hits = nHits,
+      .misses = nMisses,
+      .evictions = nEvictions,
+      .nIdle = idle.size()
+    };
+  }
+
+  //----------------------------------------------------------------------------
+
+  void StatementCache::resetStats()
+  {
+    lock_guard<mutex> lg{cacheMutex};
+
+    nHits = 0;
+    nMisses = 0;
+    nEvictions = 0;
+  }
+
+  //----------------------------------------------------------------------------
+
+  void StatementCache::trim_NoLock()
+  {
+    while (idle.size() > maxIdle)
+    {
+      auto lastIt = std::prev(idle.end());
+
+      // find the index entry that points to exactly this list element;
+      // there could be more idle statements with the same SQL text
+      auto [first, last] = index.equal_range(lastIt->first);
+      for (auto it = first; it != last; ++it)
+      {
+        if (it->second == lastIt)
+        {
+          index.erase(it);
+          break;
+        }
+      }
+
+      sqlite3_finalize(lastIt->second);
+      idle.erase(lastIt);
+      ++nEvictions;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+
+}
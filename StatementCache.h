@@ -0,0 +1,153 @@
+#pragma once
+
+#include <stddef.h>         // for size_t
+#include <list>             // for list
+#include <memory>           // for enable_shared_from_this, weak_ptr
+#include <mutex>            // for mutex
+#include <string>           // for string
+#include <string_view>      // for string_view
+#include <unordered_map>    // for unordered_multimap
+#include <utility>          // for pair
+
+#include <sqlite3.h>        // for sqlite3, sqlite3_stmt
+
+#include "SqlStatement.h"   // for SqlStatement
+
+namespace SqliteOverlay
+{
+  /** \brief A snapshot of the counters of a statement cache
+   */
+  struct StatementCacheStats
+  {
+    size_t hits{0};   ///< number of requests that were served with an idle, already prepared statement
+    size_t misses{0};   ///< number of requests that required a fresh call to `sqlite3_prepare_v3()`
+    size_t evictions{0};   ///< number of statements that were finalized instead of being put back into the cache
+    size_t nIdle{0};   ///< number of prepared statements that are currently idle in the cache
+  };
+
+  /** \brief A per-connection LRU cache of prepared statements, keyed by their SQL text
+   *
+   * The cache hands out regular SqlStatement instances that "lease" the
+   * underlying `sqlite3_stmt`. When the lease is destroyed (or finalized, or
+   * overwritten by move assignment), the statement is reset, all bindings
+   * are cleared and the statement is put back into the cache instead of
+   * being finalized.
+   *
+   * Statements are prepared with `SQLITE_PREPARE_PERSISTENT` because we
+   * expect them to be re-used many times.
+   *
+   * If the most recent step of a returning statement failed with
+   * `SQLITE_SCHEMA` or `SQLITE_ERROR` (e.g., because a table has been
+   * dropped and the automatic re-preparation failed), the statement is
+   * evicted instead of being cached.
+   *
+   * If more than `maxIdle` statements are idle in the cache, the least
+   * recently returned statements are finalized.
+   *
+   * \note Instances are always managed by a `shared_ptr` in SqliteDatabase;
+   * the leases only keep a `weak_ptr` so that statements which outlive the cache
+   * are simply finalized.
+   *
+   * \note All public methods are protected by an internal mutex.
+   */
+  class StatementCache : public std::enable_shared_from_this<StatementCache>
+  {
+  public:
+    /** \brief Ctor for an empty cache
+     *
+     * \throws std::invalid_argument if the database handle is `nullptr`
+     *
+     * Test case: yes
+     */
+    StatementCache(
+        sqlite3* _dbPtr,   ///< the database connection for which statements will be prepared
+        size_t _maxIdle   ///< the max number of idle statements in the cache
+        );
+
+    /** \brief Dtor, finalizes all idle statements
+     */
+    ~StatementCache();
+
+    /** \brief Disabled copy ctor */
+    StatementCache(const StatementCache& other) = delete;
+
+    /** \brief Disabled copy assignment */
+    StatementCache& operator=(const StatementCache& other) = delete;
+
+    /** \brief Hands out a statement for the provided SQL text, either from the
+     * cache or freshly prepared.
+     *
+     * \throws std::invalid_argument if the provided SQL string is empty
+     *
+     * \throws SqlStatementCreationError if the statement could not be created, most likely due to invalid SQL syntax
+     *
+     * \returns a SqlStatement that returns its handle to this cache when it is destroyed
+     *
+     * Test case: yes
+     */
+    SqlStatement acquire(
+        std::string_view sqlText   ///< the SQL text for which to create the statement
+        );
+
+    /** \brief Takes back a statement from a lease; the statement is reset, its bindings are cleared
+     * and it becomes the most recently used statement in the cache.
+     *
+     * For lib-internal use only; this is called by SqlStatement.
+     *
+     * Test case: implicitly by all cache tests
+     */
+    void giveBack(
+        std::string&& sqlText,   ///< the SQL text that has been used for preparing the statement
+        sqlite3_stmt* stmt   ///< the statement itself
+        );
+
+    /** \brief Finalizes all idle statements; statements that are currently leased are not affected
+     *
+     * Test case: yes
+     */
+    void clear();
+
+    /** \brief Changes the max number of idle statements and evicts statements, if necessary
+     *
+     * Test case: yes
+     */
+    void setCapacity(
+        size_t newMaxIdle   ///< the new max number of idle statements
+        );
+
+    /** \returns a snapshot of the cache counters
+     *
+     * Test case: yes
+     */
+    StatementCacheStats stats() const;
+
+    /** \brief Resets the hit/miss/eviction counters to zero
+     *
+     * Test case: yes
+     */
+    void resetStats();
+
+  protected:
+    /** \brief Finalizes the least recently used idle statements until we're within the capacity limit
+     *
+     * \pre The caller has to hold the mutex.
+     */
+    void trim_NoLock();
+
+  private:
+    using IdleList = std::list<std::pair<std::string, sqlite3_stmt*>>;
+
+    sqlite3* dbPtr;
+    size_t maxIdle;
+
+    IdleList idle;   // most recently returned statements are at the front
+    std::unordered_multimap<std::string_view, IdleList::iterator> index;   // keys point into the strings in `idle`
+
+    size_t nHits{0};
+    size_t nMisses{0};
+    size_t nEvictions{0};
+
+    mutable std::mutex cacheMutex;
+  };
+
+}
@@ -26,8 +26,8 @@ namespace SqliteOverlay
 
   TabRow::TabRow(const SqliteDatabase& _db, const string& _tabName, int _rowId, bool skipCheck)
     : db{cref(_db)}, tabName(_tabName), rowId(_rowId),
-    cachedWhereStatementForRow{" FROM " + tabName + " WHERE rowid = " + to_string(rowId)},
-    cachedUpdateStatementForRow{"UPDATE " + tabName + " SET %1=? WHERE rowid=" + to_string(rowId)}
+    cachedWhereStatementForRow{" FROM " + tabName + " WHERE rowid=?"},
+    cachedUpdateStatementForRow{"UPDATE " + tabName + " SET %1=? WHERE rowid=?"}
   {
     if (tabName.empty() || (rowId < 1))
     {
@@ -38,7 +38,8 @@ namespace SqliteOverlay
 
     try
     {
-      SqlStatement stmt = db.get().prepStatement("SELECT rowid " + cachedWhereStatementForRow);
+      SqlStatement stmt = db.get().prepStatement("SELECT rowid" + cachedWhereStatementForRow);
+      stmt.bind(1, rowId);
       stmt.step();
       stmt.get<int>(0);
     }
@@ -79,8 +80,8 @@ namespace SqliteOverlay
       throw std::invalid_argument("TabRow ctor: invalid WHERE clause or no match for WHERE clause");
     }
 
-    cachedWhereStatementForRow = " FROM " + tabName + " WHERE rowid = " + to_string(rowId);
-    cachedUpdateStatementForRow = "UPDATE " + tabName + " SET %1=? WHERE rowid=" + to_string(rowId);
+    cachedWhereStatementForRow = " FROM " + tabName + " WHERE rowid=?";
+    cachedUpdateStatementForRow = "UPDATE " + tabName + " SET %1=? WHERE rowid=?";
   }
 
   //----------------------------------------------------------------------------
@@ -194,8 +195,9 @@ namespace SqliteOverlay
 
   void TabRow::erase() const
   {
-    string sql = "DELETE " + cachedWhereStatementForRow;
-    db.get().execNonQuery(sql);
+    SqlStatement stmt = db.get().prepStatement("DELETE" + cachedWhereStatementForRow);
+    stmt.bind(1, rowId);
+    db.get().execNonQuery(stmt);
   }
 
   //----------------------------------------------------------------------------
@@ -217,6 +219,7 @@ namespace SqliteOverlay
 
     sql += "*" + cachedWhereStatementForRow;
     auto stmt = db.get().prepStatement(sql);
+    stmt.bind(1, rowId);
     stmt.step();
 
     return stmt.toCSV_currentRowOnly();
@@ -237,11 +240,19 @@ namespace SqliteOverlay
     }
 
     auto stmt = db.get().prepStatement("SELECT " + colList + cachedWhereStatementForRow);
+    stmt.bind(1, rowId);
     stmt.step();
 
     return stmt.toCSV_currentRowOnly();
   }
 
+  //----------------------------------------------------------------------------
+
+  RowSnapshot TabRow::snapshot() const
+  {
+    return RowSnapshot{db, tabName, rowId};
+  }
+
 //----------------------------------------------------------------------------
 
 
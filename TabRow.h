@@ -29,6 +29,7 @@
 #include <Sloppy/Memory.h>                              // for MemArray
 #include <Sloppy/String.h>                              // for estring
 
+#include "RowSnapshot.h"                                // for RowSnapshot
 #include "SqlStatement.h"                               // for SqlStatement
 #include "SqliteDatabase.h"                             // for SqliteDatabase
 #include "SqliteExceptions.h"                           // for SqlStatementC...
@@ -190,6 +191,7 @@ namespace SqliteOverlay
       }
 
       stmt.bind(1, newVal);
+      stmt.bind(2, rowId);
       db.get().execNonQuery(stmt);
     }
 
@@ -268,6 +270,7 @@ namespace SqliteOverlay
         throw;
       }
 
+      stmt.bind(1, rowId);
       stmt.step();
 
       return stmt.get<T>(0);
@@ -298,6 +301,7 @@ namespace SqliteOverlay
         throw;
       }
 
+      stmt.bind(1, rowId);
       stmt.step();
 
       return stmt.get2<T>(0);
@@ -548,6 +552,23 @@ namespace SqliteOverlay
         const std::vector<std::string>& colNames   ///< the list of columns that shall be exported
         ) const;
 
+    /** \brief Reads all columns of the row with a single SELECT statement
+     * into a local snapshot.
+     *
+     * Use the snapshot's getters if you need to read several columns
+     * of the same row; they don't touch the database anymore.
+     *
+     * \throws NoDataException if the row does not exist anymore
+     *
+     * \throws BusyException if the database wasn't available for reading the row
+     *
+     * \returns a RowSnapshot with a copy of the row's contents
+     *
+     * Test case: yes
+     *
+     */
+    RowSnapshot snapshot() const;
+
     /** \returns a reference to the underlying database instance
      */
     const SqliteDatabase& dbRef() const
@@ -591,6 +612,8 @@ namespace SqliteOverlay
         throw;
       }
 
+      stmt.bind(1, rowId);
+
       return stmt;
     }
 
@@ -609,6 +632,9 @@ namespace SqliteOverlay
      */
     int rowId;
 
+    // SQL snippets for this row's table; the row ID is always the
+    // last placeholder so that all TabRows of the same table produce
+    // identical SQL text and can share prepared statements
     std::string cachedWhereStatementForRow;
     Sloppy::estring cachedUpdateStatementForRow;
   };
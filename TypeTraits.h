@@ -0,0 +1,16 @@
+#pragma once
+
+#include <optional>      // for optional
+#include <type_traits>   // for false_type, true_type
+
+/** \brief Internal type traits that are shared by several headers; not part of the public API
+ */
+namespace SqliteOverlay::detail
+{
+  /** \brief `value` is `true` if `T` is a `std::optional`
+   */
+  template<typename T>
+  struct IsOptional : std::false_type {};
+  template<typename T>
+  struct IsOptional<std::optional<T>> : std::true_type {};
+}
@@ -0,0 +1,90 @@
+#include <filesystem>
+
+#include "SqlStatement.h"
+#include "Transaction.h"
+
+#include "BenchDataset.h"
+
+namespace fs = std::filesystem;
+using namespace std;
+
+namespace
+{
+  size_t scale{1};
+}
+
+size_t benchScale()
+{
+  return scale;
+}
+
+//----------------------------------------------------------------------------
+
+void setBenchScale(size_t s)
+{
+  scale = (s < 1) ? 1 : s;
+}
+
+//----------------------------------------------------------------------------
+
+BenchDataset::BenchDataset(const string& tag, size_t nRows)
+  :fName{tempFilePath("SqliteOverlayBench_" + tag + ".db")}
+{
+  if (fs::exists(fName)) fs::remove(fName);
+
+  dbPtr = make_unique<SampleDB>(fName, OpenMode::ForceNew);
+  SampleDB& d = *dbPtr;
+
+  d.execNonQuery("CREATE TABLE t1 (i INT, f DOUBLE, s VARCHAR(40), d DATETIME)");
+  d.execNonQuery("CREATE TABLE t2 (i INT, f DOUBLE, s VARCHAR(40), d DATETIME)");
+  d.execNonQuery("CREATE VIEW v1 AS SELECT i, f, s FROM t1 WHERE i=84");
+
+  // deterministic data with the same mix of values and
+  // NULLs as in the test scenario
+  auto tr = d.startTransaction();
+  auto stmt = d.prepStatement("INSERT INTO t1 VALUES (?,?,?,date('now'))");
+  for (size_t k = 0; k < nRows; ++k)
+  {
+    if ((k % 5) == 1) stmt.bindNull(1);
+    else stmt.bind(1, static_cast<int>((k * 7919) % 1000));
+
+    if ((k % 5) == 2) stmt.bindNull(2);
+    else stmt.bind(2, static_cast<double>(k) * 0.25);
+
+    stmt.bind(3, "Str" + to_string(k % 500));
+
+    stmt.step();
+    stmt.reset(false);
+  }
+  tr.commit();
+}
+
+//----------------------------------------------------------------------------
+
+BenchDataset::~BenchDataset()
+{
+  dbPtr.reset();
+  fs::remove(fName);
+}
+
+//----------------------------------------------------------------------------
+
+string BenchDataset::tempFilePath(const string& name)
+{
+  fs::path p = fs::temp_directory_path();
+  p /= name;
+  return p.native();
+}
+
+//----------------------------------------------------------------------------
+
+string BenchDataset::makeCsv(size_t nRows)
+{
+  string csv{"i,f,s,d\n"};
+  for (size_t k = 0; k < nRows; ++k)
+  {
+    csv += to_string((k * 7919) % 1000) + "," + to_string(static_cast<double>(k) * 0.25);
+    csv += ",\"Str " + to_string(k % 500) + "\",2024-03-15\n";
+  }
+  return csv;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "../tests/SampleDB.h"
+
+/** \brief The global scaling factor for all benchmark datasets; set via `--scale=N`
+ *
+ * A scale of 1 corresponds to `BaseRowCount` rows per table.
+ */
+size_t benchScale();
+
+void setBenchScale(size_t s);
+
+/** \brief Number of rows per table at scale 1 */
+constexpr size_t BaseRowCount = 1000;
+
+/** \returns the number of rows per table for the current scale */
+inline size_t benchRowCount() { return BaseRowCount * benchScale(); }
+
+/** \brief A database file with the same schema as the test scenario 01
+ * (tables `t1` and `t2`, view `v1`), populated with deterministic synthetic data.
+ *
+ * The file is created in the system's temp directory and deleted by the dtor.
+ */
+class BenchDataset
+{
+public:
+  BenchDataset(
+      const std::string& tag,   ///< a unique tag for the file name
+      size_t nRows   ///< the number of rows in `t1`; `t2` remains empty
+      );
+
+  ~BenchDataset();
+
+  BenchDataset(const BenchDataset&) = delete;
+  BenchDataset& operator=(const BenchDataset&) = delete;
+
+  /** \returns the connection to the dataset */
+  SampleDB& db() { return *dbPtr; }
+
+  /** \returns the name of the database file */
+  const std::string& fileName() const { return fName; }
+
+  /** \returns a path in the temp directory for additional files */
+  static std::string tempFilePath(const std::string& name);
+
+  /** \returns a CSV string with `nRows` rows that matches the columns of `t1` */
+  static std::string makeCsv(size_t nRows);
+
+private:
+  std::string fName;
+  std::unique_ptr<SampleDB> dbPtr;
+};
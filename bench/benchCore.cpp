@@ -0,0 +1,226 @@
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "ClausesAndQueries.h"
+#include "DbTab.h"
+#include "SqlStatement.h"
+#include "TabRow.h"
+#include "Transaction.h"
+
+#include "BenchDataset.h"
+
+using namespace SqliteOverlay;
+
+namespace
+{
+  /** \returns a row ID in the range [1..nRows] for the n-th iteration
+   */
+  int rowIdForIteration(size_t n, size_t nRows)
+  {
+    return static_cast<int>(((n * 7919) % nRows) + 1);
+  }
+}
+
+//----------------------------------------------------------------------------
+
+static void BM_PrepStatement(benchmark::State& state)
+{
+  BenchDataset ds{"prep", BaseRowCount};
+
+  for (auto _ : state)
+  {
+    auto stmt = ds.db().prepStatement("SELECT i, f, s FROM t1 WHERE rowid=?");
+    benchmark::DoNotOptimize(stmt);
+  }
+}
+BENCHMARK(BM_PrepStatement);
+
+//----------------------------------------------------------------------------
+
+static void BM_StatementQuery(benchmark::State& state)
+{
+  const size_t nRows = benchRowCount();
+  BenchDataset ds{"stmtQuery", nRows};
+  auto stmt = ds.db().prepStatement("SELECT i, f, s FROM t1 WHERE rowid=?");
+
+  size_t n{0};
+  for (auto _ : state)
+  {
+    stmt.bind(1, rowIdForIteration(n++, nRows));
+    stmt.dataStep();
+    benchmark::DoNotOptimize(stmt.get<std::string_view>(2));
+    stmt.reset(true);
+  }
+}
+BENCHMARK(BM_StatementQuery);
+
+//----------------------------------------------------------------------------
+
+static void BM_TabRowGet(benchmark::State& state)
+{
+  const size_t nRows = benchRowCount();
+  BenchDataset ds{"tabRowGet", nRows};
+
+  size_t n{0};
+  for (auto _ : state)
+  {
+    TabRow r{ds.db(), "t1", rowIdForIteration(n++, nRows), true};
+    benchmark::DoNotOptimize(r.get<std::string>("s"));
+    benchmark::DoNotOptimize(r.get2<double>("f"));
+  }
+}
+BENCHMARK(BM_TabRowGet);
+
+//----------------------------------------------------------------------------
+
+static void BM_TabRowUpdate(benchmark::State& state)
+{
+  const size_t nRows = benchRowCount();
+  BenchDataset ds{"tabRowUpdate", nRows};
+  auto tr = ds.db().startTransaction();
+
+  size_t n{0};
+  for (auto _ : state)
+  {
+    TabRow r{ds.db(), "t1", rowIdForIteration(n, nRows), true};
+    r.update("i", static_cast<int>(n));
+    ++n;
+  }
+
+  tr.rollback();
+}
+BENCHMARK(BM_TabRowUpdate);
+
+//----------------------------------------------------------------------------
+
+static void BM_DbTabInsertRow(benchmark::State& state)
+{
+  BenchDataset ds{"insertRow", 0};
+  DbTab t1{ds.db(), "t1", false};
+  auto tr = ds.db().startTransaction();
+
+  int n{0};
+  for (auto _ : state)
+  {
+    ColumnValueClause cvc;
+    cvc.addCol("i", n++);
+    cvc.addCol("f", 42.42);
+    cvc.addCol("s", "Some text");
+    benchmark::DoNotOptimize(t1.insertRow(cvc));
+  }
+
+  tr.rollback();
+}
+BENCHMARK(BM_DbTabInsertRow);
+
+//----------------------------------------------------------------------------
+
+static void BM_DbTabInsertRows(benchmark::State& state)
+{
+  const size_t nRows = benchRowCount();
+  BenchDataset ds{"insertRows", 0};
+  DbTab t1{ds.db(), "t1", false};
+
+  std::vector<int> iCol;
+  std::vector<double> fCol;
+  std::vector<std::string> sCol;
+  for (size_t k = 0; k < nRows; ++k)
+  {
+    iCol.push_back(static_cast<int>(k));
+    fCol.push_back(static_cast<double>(k) * 0.25);
+    sCol.push_back("Str" + std::to_string(k));
+  }
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(t1.insertRows({"i", "f", "s"}, std::tie(iCol, fCol, sCol)));
+
+    state.PauseTiming();
+    t1.clear();
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(state.iterations() * nRows);
+}
+BENCHMARK(BM_DbTabInsertRows)->Unit(benchmark::kMillisecond);
+
+//----------------------------------------------------------------------------
+
+static void BM_DbTabQueryByColumnValue(benchmark::State& state)
+{
+  BenchDataset ds{"queryByCol", benchRowCount()};
+  DbTab t1{ds.db(), "t1", false};
+
+  int n{0};
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(t1.getRowsByColumnValue("i", n));
+    n = (n + 1) % 1000;
+  }
+}
+BENCHMARK(BM_DbTabQueryByColumnValue)->Unit(benchmark::kMicrosecond);
+
+//----------------------------------------------------------------------------
+
+static void BM_DbTabQueryByWhereClause(benchmark::State& state)
+{
+  BenchDataset ds{"queryByWhere", benchRowCount()};
+  DbTab t1{ds.db(), "t1", false};
+
+  int n{0};
+  for (auto _ : state)
+  {
+    WhereClause w;
+    w.addCol("i", ">", n);
+    w.addCol("s", "Str42");
+    benchmark::DoNotOptimize(t1.getRowsByWhereClause(w));
+    n = (n + 1) % 1000;
+  }
+}
+BENCHMARK(BM_DbTabQueryByWhereClause)->Unit(benchmark::kMicrosecond);
+
+//----------------------------------------------------------------------------
+
+static void BM_SingleColumnIterator(benchmark::State& state)
+{
+  const size_t nRows = benchRowCount();
+  BenchDataset ds{"singleColIter", nRows};
+  DbTab t1{ds.db(), "t1", false};
+
+  for (auto _ : state)
+  {
+    double sum{0};
+    for (auto it = t1.singleColumnIterator<double>("f"); it.hasData(); ++it)
+    {
+      auto v = it.get2();
+      if (v) sum += *v;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetItemsProcessed(state.iterations() * nRows);
+}
+BENCHMARK(BM_SingleColumnIterator)->Unit(benchmark::kMicrosecond);
+
+//----------------------------------------------------------------------------
+
+static void BM_TabRowIterator(benchmark::State& state)
+{
+  const size_t nRows = benchRowCount();
+  BenchDataset ds{"tabRowIter", nRows};
+  DbTab t1{ds.db(), "t1", false};
+
+  for (auto _ : state)
+  {
+    size_t len{0};
+    for (auto it = t1.tabRowIterator(); it.hasData(); ++it)
+    {
+      len += it->get<std::string>("s").size();
+    }
+    benchmark::DoNotOptimize(len);
+  }
+
+  state.SetItemsProcessed(state.iterations() * nRows);
+}
+BENCHMARK(BM_TabRowIterator)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,377 @@
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <Sloppy/CSV.h>
+
+#include "DbTab.h"
+#include "GroupCommitQueue.h"
+#include "KeyValueTab.h"
+#include "Transaction.h"
+
+#include "../tests/ExampleTableAdapter.h"
+#include "BenchDataset.h"
+
+using namespace SqliteOverlay;
+
+//----------------------------------------------------------------------------
+
+static void BM_GenericSelectById(benchmark::State& state)
+{
+  const size_t nRows = benchRowCount();
+  BenchDataset ds{"genSelect", nRows};
+  ExampleTable t{&ds.db()};
+
+  size_t n{0};
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(t.singleObjectById(ExampleId{static_cast<int>((n++ % nRows) + 1)}));
+  }
+}
+BENCHMARK(BM_GenericSelectById);
+
+//----------------------------------------------------------------------------
+
+static void BM_GenericSelectByColumnValue(benchmark::State& state)
+{
+  BenchDataset ds{"genSelectCol", benchRowCount()};
+  ExampleTable t{&ds.db()};
+
+  int n{0};
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(t.objectsByColumnValue(ExampleTable::Col::intCol, n));
+    n = (n + 1) % 1000;
+  }
+}
+BENCHMARK(BM_GenericSelectByColumnValue)->Unit(benchmark::kMicrosecond);
+
+//----------------------------------------------------------------------------
+
+static void BM_GenericCountRuntimeWhere(benchmark::State& state)
+{
+  const size_t nRows = benchRowCount();
+  BenchDataset ds{"genCountRt", nRows};
+  ds.db().enableStatementCache();
+  ExampleTable t{&ds.db()};
+
+  size_t n{0};
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(t.objCount(ExampleTable::Col::id, static_cast<int>((n++ % nRows) + 1)));
+  }
+}
+BENCHMARK(BM_GenericCountRuntimeWhere);
+
+//----------------------------------------------------------------------------
+
+static void BM_GenericCountCompiledWhere(benchmark::State& state)
+{
+  const size_t nRows = benchRowCount();
+  BenchDataset ds{"genCountCt", nRows};
+  ds.db().enableStatementCache();
+  ExampleTable t{&ds.db()};
+
+  size_t n{0};
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(t.objCountWhere<Sql::Eq<ExampleTable::Col::id>>(static_cast<int>((n++ % nRows) + 1)));
+  }
+}
+BENCHMARK(BM_GenericCountCompiledWhere);
+
+//----------------------------------------------------------------------------
+
+static void BM_GenericInsertUpdateDelete(benchmark::State& state)
+{
+  BenchDataset ds{"genCrud", BaseRowCount};
+  ExampleTable t{&ds.db()};
+  auto tr = ds.db().startTransaction();
+
+  ExampleObj o{
+    .id = ExampleId{0},
+    .i = 42,
+    .f = 23.23,
+    .s = "Hallo",
+    .d = date::year_month_day{date::year{2024}, date::month{3}, date::day{15}}
+  };
+
+  for (auto _ : state)
+  {
+    o.id = t.insert(o);
+    o.s = "Ho";
+    t.overwrite(o);
+    t.updateObject(o.id, ExampleTable::Col::intCol, 84);
+    t.del(o.id);
+  }
+
+  tr.rollback();
+}
+BENCHMARK(BM_GenericInsertUpdateDelete);
+
+//----------------------------------------------------------------------------
+
+static void BM_GenericBatchInsertDelete(benchmark::State& state)
+{
+  BenchDataset ds{"genBatch", BaseRowCount};
+  ExampleTable t{&ds.db()};
+
+  const std::vector<ExampleObj> objs(benchRowCount(), ExampleObj{
+    .id = ExampleId{0},
+    .i = 42,
+    .f = 23.23,
+    .s = "Hallo",
+    .d = date::year_month_day{date::year{2024}, date::month{3}, date::day{15}}
+  });
+
+  for (auto _ : state)
+  {
+    auto ids = t.insertMany(objs);
+    t.deleteMany(ids);
+  }
+  state.SetItemsProcessed(state.iterations() * objs.size());
+}
+BENCHMARK(BM_GenericBatchInsertDelete)->Unit(benchmark::kMillisecond);
+
+//----------------------------------------------------------------------------
+
+static void BM_GenericRowwiseSum(benchmark::State& state)
+{
+  BenchDataset ds{"genRowSum", benchRowCount()};
+  ExampleTable t{&ds.db()};
+
+  for (auto _ : state)
+  {
+    double sum{0};
+    for (const ExampleObj& o : t.streamAllObj())
+    {
+      if (o.f.has_value()) sum += *o.f;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * benchRowCount());
+}
+BENCHMARK(BM_GenericRowwiseSum)->Unit(benchmark::kMicrosecond);
+
+//----------------------------------------------------------------------------
+
+static void BM_GenericColumnarSum(benchmark::State& state)
+{
+  BenchDataset ds{"genColSum", benchRowCount()};
+  ExampleTable t{&ds.db()};
+
+  for (auto _ : state)
+  {
+    auto rd = t.columnarReader<ExampleTable::Col::realCol>();
+    double sum{0};
+    while (rd.nextChunk() > 0) sum += columnSum(rd.column<0>());
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * benchRowCount());
+}
+BENCHMARK(BM_GenericColumnarSum)->Unit(benchmark::kMicrosecond);
+
+//----------------------------------------------------------------------------
+
+// single-row inserts from several concurrent writers; Arg 0 = one
+// transaction per insert, Arg 1 = inserts go through a GroupCommitQueue
+static void BM_ConcurrentInserts(benchmark::State& state)
+{
+  BenchDataset ds{"concInserts", 0};
+  constexpr int nThreads{4};
+  constexpr int nPerThread{50};
+  const bool useQueue = (state.range(0) != 0);
+
+  OpenOptions oo;
+  oo.busyTimeout_ms = 5000;
+  oo.synchronous = SynchronousMode::Full;
+  GroupCommitQueue<> q{ds.fileName(), 1000, std::chrono::microseconds{500}, OpenMode::OpenExisting_RW, nullptr, oo};
+  std::vector<std::unique_ptr<SampleDB>> conns;
+  for (int t = 0; t < nThreads; ++t)
+  {
+    conns.push_back(std::make_unique<SampleDB>(ds.fileName(), OpenMode::OpenExisting_RW));
+    conns.back()->applyOpenOptions(oo);
+  }
+
+  for (auto _ : state)
+  {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nThreads; ++t)
+    {
+      threads.emplace_back([&, t]() {
+        if (useQueue)
+        {
+          std::vector<std::future<void>> futures;
+          for (int k = 0; k < nPerThread; ++k)
+          {
+            futures.push_back(q.submitBatch({"INSERT INTO t1(i) VALUES(1)"}));
+          }
+          for (auto& f : futures) f.get();
+        } else {
+          SampleDB& db = *conns[t];
+          for (int k = 0; k < nPerThread; ++k)
+          {
+            auto tr = db.startTransaction(TransactionType::Immediate);
+            db.execNonQuery("INSERT INTO t1(i) VALUES(1)");
+            tr.commit();
+          }
+        }
+      });
+    }
+    for (auto& th : threads) th.join();
+  }
+  state.SetItemsProcessed(state.iterations() * nThreads * nPerThread);
+}
+BENCHMARK(BM_ConcurrentInserts)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+//----------------------------------------------------------------------------
+
+static void BM_KeyValueTabSetGet(benchmark::State& state)
+{
+  BenchDataset ds{"kvTab", 0};
+  KeyValueTab kvt = ds.db().createNewKeyValueTab("kv");
+  for (int k = 0; k < 100; ++k) kvt.set("key" + std::to_string(k), k);
+
+  int n{0};
+  for (auto _ : state)
+  {
+    const std::string key = "key" + std::to_string(n % 100);
+    kvt.set(key, n);
+    benchmark::DoNotOptimize(kvt.get<int>(key));
+    ++n;
+  }
+}
+BENCHMARK(BM_KeyValueTabSetGet);
+
+//----------------------------------------------------------------------------
+
+// Arg: 0 = no value cache, 1 = cache with data_version check on every
+// lookup, 2 = cache with data_version check at most every 100 ms
+static void BM_KeyValueTabGet(benchmark::State& state)
+{
+  BenchDataset ds{"kvTabGet", 0};
+  KeyValueTab kvt = ds.db().createNewKeyValueTab("kv");
+  for (int k = 0; k < 100; ++k) kvt.set("key" + std::to_string(k), k);
+  if (state.range(0) == 1) kvt.enableCache();
+  if (state.range(0) == 2) kvt.enableCache(std::chrono::milliseconds{100});
+
+  std::vector<std::string> keys;
+  for (int k = 0; k < 100; ++k) keys.push_back("key" + std::to_string(k));
+
+  int n{0};
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(kvt.get<int>(keys[n % 100]));
+    ++n;
+  }
+}
+BENCHMARK(BM_KeyValueTabGet)->Arg(0)->Arg(1)->Arg(2);
+
+//----------------------------------------------------------------------------
+
+static void BM_ImportCsvTable(benchmark::State& state)
+{
+  const size_t nRows = benchRowCount();
+  BenchDataset ds{"importCsvTab", 0};
+  DbTab t1{ds.db(), "t1", false};
+
+  Sloppy::CSV_Table csv;
+  for (size_t k = 0; k < nRows; ++k)
+  {
+    Sloppy::CSV_Row r;
+    r.append(static_cast<int>(k));
+    r.append(static_cast<double>(k) * 0.25);
+    r.append("Str" + std::to_string(k % 500));
+    r.append();
+    csv.append(r);
+  }
+  csv.setHeader(std::vector<std::string>{"i", "f", "s", "d"});
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(t1.importCSV(csv));
+
+    state.PauseTiming();
+    t1.clear();
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(state.iterations() * nRows);
+}
+BENCHMARK(BM_ImportCsvTable)->Unit(benchmark::kMillisecond);
+
+//----------------------------------------------------------------------------
+
+static void BM_ImportCsvStream(benchmark::State& state)
+{
+  const size_t nRows = benchRowCount();
+  BenchDataset ds{"importCsvStream", 0};
+  DbTab t1{ds.db(), "t1", false};
+  const std::string csv = BenchDataset::makeCsv(nRows);
+
+  for (auto _ : state)
+  {
+    std::istringstream in{csv};
+    benchmark::DoNotOptimize(t1.importCSVStream(in));
+
+    state.PauseTiming();
+    t1.clear();
+    state.ResumeTiming();
+  }
+
+  state.SetBytesProcessed(state.iterations() * csv.size());
+  state.SetItemsProcessed(state.iterations() * nRows);
+}
+BENCHMARK(BM_ImportCsvStream)->Unit(benchmark::kMillisecond);
+
+//----------------------------------------------------------------------------
+
+static void BM_Backup(benchmark::State& state)
+{
+  BenchDataset ds{"backup", benchRowCount()};
+  const std::string dstName = BenchDataset::tempFilePath("SqliteOverlayBench_backupDst.db");
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(ds.db().backupToFile(dstName));
+
+    state.PauseTiming();
+    std::filesystem::remove(dstName);
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_Backup)->Unit(benchmark::kMillisecond);
+
+//----------------------------------------------------------------------------
+
+static void BM_ChangelogInsert(benchmark::State& state)
+{
+  BenchDataset ds{"changelog", 0};
+  ds.db().enableChangeLog(true);
+  auto stmt = ds.db().prepStatement("INSERT INTO t2 (i) VALUES (?)");
+  auto tr = ds.db().startTransaction();
+
+  int n{0};
+  for (auto _ : state)
+  {
+    stmt.bind(1, n++);
+    stmt.step();
+    stmt.reset(false);
+
+    // drain the log from time to time so that
+    // the log's size doesn't grow without limit
+    if ((n % 1000) == 0)
+    {
+      benchmark::DoNotOptimize(ds.db().getAllChangesAndClearQueue());
+    }
+  }
+
+  tr.rollback();
+  ds.db().disableChangeLog(true);
+}
+BENCHMARK(BM_ChangelogInsert);
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <Sloppy/json.hpp>
+
+#include "BenchDataset.h"
+
+using namespace std;
+using json = nlohmann::json;
+
+/*
+ * Usage:
+ *
+ *   SqliteOverlay_Bench [--scale=N] [--baseline=FILE [--tolerance=PCT]] [Google Benchmark flags]
+ *
+ *   --scale=N         multiplies the size of the synthetic datasets by N (default: 1)
+ *   --baseline=FILE   compares the results with a JSON file that has been written
+ *                     by a previous run with `--benchmark_out=FILE`; the exit code
+ *                     is 1 if any benchmark is more than PCT percent slower
+ *   --tolerance=PCT   the accepted slowdown in percent (default: 10)
+ *
+ * Example:
+ *
+ *   SqliteOverlay_Bench --benchmark_out=baseline.json --benchmark_repetitions=5
+ *   ... change the lib ...
+ *   SqliteOverlay_Bench --baseline=baseline.json --benchmark_repetitions=5
+ */
+
+namespace
+{
+  /** \brief A console reporter that additionally keeps the best
+   * real time (in ns) of each benchmark for the baseline comparison
+   */
+  class CollectingReporter : public benchmark::ConsoleReporter
+  {
+  public:
+    void ReportRuns(const vector<Run>& reports) override
+    {
+      for (const Run& r : reports)
+      {
+        if ((r.run_type != Run::RT_Iteration) || r.error_occurred) continue;
+
+        const double ns = r.GetAdjustedRealTime() * 1e9 / benchmark::GetTimeUnitMultiplier(r.time_unit);
+        storeMin(results, r.benchmark_name(), ns);
+      }
+
+      ConsoleReporter::ReportRuns(reports);
+    }
+
+    static void storeMin(map<string, double>& dst, const string& name, double ns)
+    {
+      auto it = dst.find(name);
+      if (it == dst.end()) dst.emplace(name, ns);
+      else it->second = min(it->second, ns);
+    }
+
+    map<string, double> results;
+  };
+
+  //----------------------------------------------------------------------------
+
+  double unitToNs(const string& unit)
+  {
+    if (unit == "us") return 1e3;
+    if (unit == "ms") return 1e6;
+    if (unit == "s") return 1e9;
+    return 1.0;
+  }
+
+  //----------------------------------------------------------------------------
+
+  /** \returns the best real time (in ns) per benchmark from a Google Benchmark JSON file
+   */
+  map<string, double> loadBaseline(const string& fName)
+  {
+    ifstream f{fName};
+    if (!f)
+    {
+      throw invalid_argument("Could not open baseline file " + fName);
+    }
+
+    const json j = json::parse(f);
+    map<string, double> result;
+    for (const json& b : j.at("benchmarks"))
+    {
+      if (b.value("run_type", "iteration") != "iteration") continue;
+      if (b.contains("error_occurred") && b["error_occurred"].get<bool>()) continue;
+
+      const double ns = b.at("real_time").get<double>() * unitToNs(b.value("time_unit", "ns"));
+      CollectingReporter::storeMin(result, b.at("name").get<string>(), ns);
+    }
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+
+  /** \returns the number of benchmarks that are slower than the baseline plus tolerance
+   */
+  int compareWithBaseline(const map<string, double>& baseline, const map<string, double>& current, double tolerance_pct)
+  {
+    int nRegressions{0};
+
+    cout << "\nComparison with baseline (tolerance: " << tolerance_pct << " %)\n\n";
+    for (const auto& [name, ns] : current)
+    {
+      auto it = baseline.find(name);
+      if (it == baseline.end())
+      {
+        cout << "  NEW        " << name << "\n";
+        continue;
+      }
+
+      const double change_pct = (ns / it->second - 1.0) * 100.0;
+      const bool isRegression = (change_pct > tolerance_pct);
+      if (isRegression) ++nRegressions;
+
+      cout << (isRegression ? "  REGRESSION " : "  ok         ") << name << ": "
+           << it->second << " ns --> " << ns << " ns ("
+           << ((change_pct >= 0) ? "+" : "") << change_pct << " %)\n";
+    }
+    cout << "\n" << nRegressions << " regression(s)" << endl;
+
+    return nRegressions;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+  // extract our own arguments before handing
+  // the rest over to Google Benchmark
+  string baselineFile;
+  double tolerance_pct{10.0};
+  vector<char*> remainingArgs{argv[0]};
+  for (int i = 1; i < argc; ++i)
+  {
+    const string_view arg{argv[i]};
+    if (arg.starts_with("--scale="))
+    {
+      setBenchScale(strtoul(argv[i] + 8, nullptr, 10));
+    } else if (arg.starts_with("--baseline=")) {
+      baselineFile = string{arg.substr(11)};
+    } else if (arg.starts_with("--tolerance=")) {
+      tolerance_pct = strtod(argv[i] + 12, nullptr);
+    } else {
+      remainingArgs.push_back(argv[i]);
+    }
+  }
+
+  int nArgs = static_cast<int>(remainingArgs.size());
+  benchmark::Initialize(&nArgs, remainingArgs.data());
+  if (benchmark::ReportUnrecognizedArguments(nArgs, remainingArgs.data())) return 1;
+
+  benchmark::AddCustomContext("scale", to_string(benchScale()));
+  benchmark::AddCustomContext("rows_per_table", to_string(benchRowCount()));
+
+  CollectingReporter reporter;
+  benchmark::RunSpecifiedBenchmarks(&reporter);
+  benchmark::Shutdown();
+
+  if (baselineFile.empty()) return 0;
+
+  const auto baseline = loadBaseline(baselineFile);
+  return (compareWithBaseline(baseline, reporter.results, tolerance_pct) > 0) ? 1 : 0;
+}
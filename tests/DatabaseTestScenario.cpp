@@ -15,6 +15,7 @@
 #include <gtest/gtest.h>
 
 #include "DatabaseTestScenario.h"
+#include "SqlMetrics.h"
 
 namespace fs = std::filesystem;
 
@@ -147,6 +148,34 @@ SampleDB DatabaseTestScenario::getScenario01()
 
 //----------------------------------------------------------------------------
 
+int64_t DatabaseTestScenario::countVmSteps(SqliteOverlay::SqliteDatabase& db, const std::function<void()>& f)
+{
+  auto prevMetrics = db.getSqlMetrics();
+  auto reg = db.enableSqlMetrics();
+
+  auto restore = [&]() {
+    if (prevMetrics == nullptr) db.disableSqlMetrics();
+    else db.enableSqlMetrics(prevMetrics);
+  };
+
+  try
+  {
+    f();
+  }
+  catch (...)
+  {
+    restore();
+    throw;
+  }
+  restore();
+
+  int64_t result{0};
+  for (const auto& m : reg->snapshot().statements) result += m.status.vmSteps;
+  return result;
+}
+
+//----------------------------------------------------------------------------
+
 void DatabaseTestScenario::SetUp()
 {
   BasicTestFixture::SetUp();
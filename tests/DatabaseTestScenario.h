@@ -14,6 +14,7 @@
 #define	DATABASETESTSCENARIO_H
 
 #include <sqlite3.h>
+#include <functional>
 #include <memory>
 #include <iostream>
 
@@ -44,6 +45,12 @@ protected:
 
   void prepScenario01();
   SampleDB getScenario01();
+
+  // runs `f` with a fresh metrics registry on `db` and returns the number
+  // of VM steps of all statements executed on `db` in the meantime; a previously
+  // enabled registry is restored afterwards. Unlike wall-clock times, the
+  // result is deterministic and thus suitable for performance regression tests.
+  int64_t countVmSteps(SqliteOverlay::SqliteDatabase& db, const std::function<void()>& f);
   
   void SetUp () override;
   void TearDown () override;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <charconv>
+
 #include <Sloppy/NamedType.h>
 #include <Sloppy/DateTime/DateAndTime.h>
 #include <Sloppy/Utils.h>
@@ -16,7 +18,7 @@ struct ExampleObj {
   date::year_month_day d;
 };
 
-bool operator==(const ExampleObj& lhs, const ExampleObj& rhs) {
+inline bool operator==(const ExampleObj& lhs, const ExampleObj& rhs) {
   return (
         (lhs.id == rhs.id) &&
         (lhs.i == rhs.i) &&
@@ -54,10 +56,16 @@ public:
   static constexpr std::string_view FullSelectColList{"rowid,i,f,s,d"};
 
   static ExampleObj fromSelectStmt(const SqliteOverlay::SqlStatement& stmt) {
-    const std::string sDate = stmt.get<std::string>(4);
-    const int y = std::stoi(sDate.substr(0, 4));
-    const unsigned m = std::stoi(sDate.substr(5,2));
-    const int d = std::stoi(sDate.substr(8,2));
+    // the date is only parsed, so we don't need a copy of the string
+    const std::string_view sDate = stmt.get<std::string_view>(4);
+    const auto toInt = [&sDate](size_t pos, size_t len) {
+      int result{0};
+      std::from_chars(sDate.data() + pos, sDate.data() + pos + len, result);
+      return result;
+    };
+    const int y = toInt(0, 4);
+    const unsigned m = toInt(5, 2);
+    const int d = toInt(8, 2);
 
     return ExampleObj{
       .id = ExampleId{stmt.get<int>(0)},
@@ -0,0 +1,230 @@
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <future>
+#include <string>
+#include <thread>
+
+#include <poll.h>
+
+#include <gtest/gtest.h>
+
+#include "AsyncExecutor.h"
+#include "ClausesAndQueries.h"
+#include "DatabaseTestScenario.h"
+#include "DbTab.h"
+#include "ExampleTableAdapter.h"
+#include "SampleDB.h"
+
+using namespace SqliteOverlay;
+
+namespace
+{
+  // a minimal, eagerly started coroutine type for the tests
+  struct Detached
+  {
+    struct promise_type
+    {
+      Detached get_return_object() { return {}; }
+      std::suspend_never initial_suspend() noexcept { return {}; }
+      std::suspend_never final_suspend() noexcept { return {}; }
+      void return_void() {}
+      void unhandled_exception() { std::terminate(); }
+    };
+  };
+
+  // waits until the executor's eventfd becomes readable
+  bool waitForEvent(const AsyncExecutorBase& ex, int timeout_ms = 5000)
+  {
+    pollfd pfd{ex.eventFd(), POLLIN, 0};
+    return (poll(&pfd, 1, timeout_ms) == 1);
+  }
+
+  // a query that runs for a very long time unless it is interrupted
+  constexpr const char* EndlessQuery =
+      "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x+1 FROM c) SELECT count(*) FROM c";
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, AsyncExecutor_Futures)
+{
+  auto db = getScenario01();
+  AsyncExecutor<SampleDB> ex{getSqliteFileName(), OpenMode::OpenExisting_RW};
+  ASSERT_TRUE(ex.eventFd() >= 0);
+  ASSERT_EQ(0, ex.processCompletions());
+
+  // plain statements
+  auto f1 = ex.submit([](SampleDB& d) {
+    auto stmt = d.prepStatement("SELECT count(*) FROM t1 WHERE i=84");
+    stmt.step();
+    return stmt.get<int>(0);
+  });
+  ASSERT_EQ(3, f1.get());
+  ASSERT_TRUE(waitForEvent(ex));
+  ASSERT_EQ(0, ex.processCompletions());   // futures don't need to be resumed
+
+  // DbTab helpers and void jobs
+  auto f2 = ex.submit([](SampleDB& d) {
+    DbTab t1{d, "t1", false};
+    ColumnValueClause cvc;
+    cvc.addCol("i", 1000);
+    t1.insertRow(cvc);
+  });
+  f2.get();
+  ASSERT_EQ(1, db.execScalarQuery<int>("SELECT count(*) FROM t1 WHERE i=1000"));
+
+  // GenericTable
+  auto f3 = ex.submit([](SqliteDatabase& d) {
+    return ExampleTable{&d}.objectsByColumnValue(ExampleTable::Col::intCol, 84);
+  });
+  ASSERT_EQ(3, f3.get().size());
+
+  // exceptions are forwarded to the caller
+  auto f4 = ex.submit([](SampleDB& d) { return d.execScalarQuery<int>("SELECT * FROM nonsense"); });
+  ASSERT_THROW(f4.get(), SqlStatementCreationError);
+
+  // jobs are executed in order
+  std::vector<std::future<int>> futures;
+  for (int i = 0; i < 10; ++i)
+  {
+    futures.push_back(ex.submit([i](SampleDB& d) {
+      d.execNonQuery("UPDATE t1 SET i=" + std::to_string(i) + " WHERE rowid=1");
+      return d.execScalarQuery<int>("SELECT i FROM t1 WHERE rowid=1");
+    }));
+  }
+  for (int i = 0; i < 10; ++i) ASSERT_EQ(i, futures[i].get());
+  ASSERT_EQ(0, ex.pendingCount());
+
+  // named callables are copied
+  auto countRows = [](SampleDB& d) { return d.execScalarQuery<int>("SELECT count(*) FROM t1"); };
+  const std::function<int(SampleDB&)> countRowsFunc{countRows};
+  ASSERT_EQ(6, ex.submit(countRows).get());
+  ASSERT_EQ(6, ex.submit(countRowsFunc).get());
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, AsyncExecutor_Coroutines)
+{
+  auto db = getScenario01();
+  AsyncExecutor<> ex{getSqliteFileName()};
+
+  int count{-1};
+  size_t nObj{0};
+  bool hasFailed{false};
+  bool isFinished{false};
+  std::thread::id resumedOn;
+
+  auto coro = [&]() -> Detached {
+    count = co_await ex.schedule([](SqliteDatabase& d) {
+      return d.execScalarQuery<int>("SELECT count(*) FROM t1");
+    });
+    resumedOn = std::this_thread::get_id();
+
+    auto objs = co_await ex.schedule([](SqliteDatabase& d) {
+      return ExampleTable{&d}.allObj();
+    });
+    nObj = objs.size();
+
+    co_await ex.schedule([](SqliteDatabase& d) { d.execNonQuery("DELETE FROM t1 WHERE rowid=1"); });
+
+    try
+    {
+      co_await ex.schedule([](SqliteDatabase& d) { d.execNonQuery("DELETE FROM nonsense"); });
+    }
+    catch (SqlStatementCreationError&)
+    {
+      hasFailed = true;
+    }
+
+    isFinished = true;
+  };
+  coro();
+
+  // a minimal event loop
+  int nResumed{0};
+  while (!isFinished)
+  {
+    ASSERT_TRUE(waitForEvent(ex));
+    nResumed += ex.processCompletions();
+  }
+
+  ASSERT_EQ(4, nResumed);
+  ASSERT_EQ(5, count);
+  ASSERT_EQ(5, nObj);
+  ASSERT_TRUE(hasFailed);
+  ASSERT_EQ(std::this_thread::get_id(), resumedOn);
+  ASSERT_EQ(4, db.execScalarQuery<int>("SELECT count(*) FROM t1"));
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, AsyncExecutor_Cancellation)
+{
+  auto db = getScenario01();
+  AsyncExecutor<> ex{getSqliteFileName()};
+
+  // interrupt a running statement
+  std::atomic<bool> hasStarted{false};
+  auto fLong = ex.submit([&hasStarted](SqliteDatabase& d) {
+    hasStarted = true;
+    return d.execScalarQuery<int64_t>(EndlessQuery);
+  });
+  // a single interrupt is sufficient, even if the
+  // statement hasn't been started yet
+  while (!hasStarted) std::this_thread::yield();
+  ex.interrupt();
+  try
+  {
+    fLong.get();
+    FAIL() << "Interrupted job did not throw";
+  }
+  catch (GenericSqliteException& e)
+  {
+    ASSERT_EQ(PrimaryResultCode::INTERRUPT, e.errCode());
+  }
+
+  // cancel queued jobs
+  std::promise<void> gate;
+  auto gateFuture = gate.get_future();
+  hasStarted = false;
+  auto fBlocker = ex.submit([&gateFuture, &hasStarted](SqliteDatabase& d) {
+    hasStarted = true;
+    gateFuture.wait();
+    return d.execScalarQuery<int>("SELECT count(*) FROM t1");
+  });
+  auto f1 = ex.submit([](SqliteDatabase& d) { d.execNonQuery("DELETE FROM t1"); });
+  auto f2 = ex.submit([](SqliteDatabase& d) { d.execNonQuery("DELETE FROM t1"); });
+  while (!hasStarted) std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  const size_t nCancelled = ex.cancelPending();
+  gate.set_value();
+  ASSERT_EQ(2, nCancelled);
+  ASSERT_EQ(0, ex.pendingCount());
+
+  ASSERT_EQ(5, fBlocker.get());
+  ASSERT_THROW(f1.get(), GenericSqliteException);
+  ASSERT_THROW(f2.get(), GenericSqliteException);
+  ASSERT_EQ(5, db.execScalarQuery<int>("SELECT count(*) FROM t1"));
+
+  // the executor is still usable
+  ASSERT_EQ(5, ex.submit([](SqliteDatabase& d) { return d.execScalarQuery<int>("SELECT count(*) FROM t1"); }).get());
+
+  // the dtor interrupts the running job and cancels the queue
+  std::future<int64_t> fEndless;
+  std::future<int> fQueued;
+  hasStarted = false;
+  {
+    AsyncExecutor<> ex2{getSqliteFileName()};
+    fEndless = ex2.submit([&hasStarted](SqliteDatabase& d) {
+      hasStarted = true;
+      return d.execScalarQuery<int64_t>(EndlessQuery);
+    });
+    fQueued = ex2.submit([](SqliteDatabase& d) { return d.execScalarQuery<int>("SELECT count(*) FROM t1"); });
+    while (!hasStarted) std::this_thread::yield();
+  }
+  ASSERT_THROW(fEndless.get(), GenericSqliteException);
+  ASSERT_THROW(fQueued.get(), GenericSqliteException);
+}
@@ -0,0 +1,149 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ColumnarFetch.h"
+#include "DatabaseTestScenario.h"
+#include "ExampleTableAdapter.h"
+
+using namespace SqliteOverlay;
+
+TEST(Columnar, ColumnBufferAndReductions)
+{
+  ColumnBuffer<int64_t> b;
+  ASSERT_EQ(0, columnSum(b));
+  ASSERT_EQ(0, columnCount(b));
+  ASSERT_FALSE(columnMinMax(b).has_value());
+
+  // 200 rows: every 7th row is NULL, the others contain their row index
+  int64_t expectedSum{0};
+  size_t expectedCount{0};
+  for (int64_t i = 0; i < 200; ++i)
+  {
+    if ((i % 7) == 0)
+    {
+      b.pushNull();
+    } else {
+      b.push(i - 100);
+      expectedSum += i - 100;
+      ++expectedCount;
+    }
+  }
+  ASSERT_EQ(200, b.size());
+  ASSERT_EQ(4, b.nullBits.size());
+  ASSERT_TRUE(b.isNull(0));
+  ASSERT_TRUE(b.isNull(196));
+  ASSERT_FALSE(b.isNull(1));
+  ASSERT_EQ(0, b.values[0]);   // NULLs are stored as zero
+  ASSERT_EQ(expectedCount, b.countNonNull());
+  ASSERT_EQ(expectedCount, columnCount(b));
+  ASSERT_EQ(expectedSum, columnSum(b));
+
+  // row 0 (= -100) is NULL, row 199 (= 99) is not
+  auto mm = columnMinMax(b);
+  ASSERT_TRUE(mm.has_value());
+  ASSERT_EQ(-99, mm->first);
+  ASSERT_EQ(99, mm->second);
+
+  // 10 bins of width 10 between -50 and 50
+  auto h = columnHistogram(b, -50, 50, 10);
+  ASSERT_EQ(10, h.bins.size());
+  size_t nInRange{0};
+  for (size_t n : h.bins) nInRange += n;
+  ASSERT_EQ(expectedCount, nInRange + h.nBelow + h.nAbove);
+  ASSERT_EQ(9, h.bins[0]);   // -50 ... -41 without -44 (i = 56)
+  ASSERT_EQ(42, h.nBelow);   // -100 ... -51 without the 8 NULLs
+  ASSERT_THROW(columnHistogram(b, 0, 0, 10), std::invalid_argument);
+  ASSERT_THROW(columnHistogram(b, 0, 1, 0), std::invalid_argument);
+
+  // only NULLs
+  ColumnBuffer<double> d;
+  for (int i = 0; i < 70; ++i) d.pushNull();
+  ASSERT_EQ(0.0, columnSum(d));
+  ASSERT_EQ(0, columnCount(d));
+  ASSERT_FALSE(columnMinMax(d).has_value());
+
+  d.clear();
+  ASSERT_EQ(0, d.size());
+  ASSERT_EQ(0, d.nNull);
+  ASSERT_TRUE(d.nullBits.empty());
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, Columnar_Reader)
+{
+  auto db = getScenario01();
+
+  // i: 42, NULL, 84, 84, 84
+  // f: 23.23, 666.66, NULL, NULL, 42.42
+  ColumnarReader<int64_t, double, std::string> rd{db.prepStatement("SELECT i, f, s FROM t1 ORDER BY rowid"), 2};
+  ASSERT_EQ(2, rd.chunkSize());
+  ASSERT_FALSE(rd.isDone());
+
+  int64_t iSum{0};
+  double fSum{0};
+  size_t nNullI{0};
+  std::vector<size_t> chunks;
+  while (size_t n = rd.nextChunk())
+  {
+    chunks.push_back(n);
+    ASSERT_EQ(n, rd.rowsInChunk());
+    iSum += columnSum(rd.column<0>());
+    fSum += columnSum(rd.column<1>());
+    nNullI += rd.column<0>().nNull;
+  }
+  ASSERT_EQ((std::vector<size_t>{2, 2, 1}), chunks);
+  ASSERT_TRUE(rd.isDone());
+  ASSERT_EQ(5, rd.totalRows());
+  ASSERT_EQ(0, rd.nextChunk());
+  ASSERT_EQ(42 + 3 * 84, iSum);
+  ASSERT_NEAR(23.23 + 666.66 + 42.42, fSum, 1e-9);
+  ASSERT_EQ(1, nNullI);
+
+  // text and type conversions in a single chunk
+  ColumnarReader<std::string, int64_t> rd2{db.prepStatement("SELECT s, f FROM t1 WHERE rowid IN (1,2)")};
+  ASSERT_EQ(2, rd2.nextChunk());
+  ASSERT_EQ("Hallo", rd2.column<0>().values[0]);
+  ASSERT_EQ("Hi", rd2.column<0>().values[1]);
+  ASSERT_EQ(23, rd2.column<1>().values[0]);
+  ASSERT_EQ(666, rd2.column<1>().values[1]);
+
+  // invalid parameters
+  ASSERT_THROW((ColumnarReader<int64_t>{db.prepStatement("SELECT i FROM t1"), 0}), std::invalid_argument);
+  using TwoCols = ColumnarReader<int64_t, int64_t>;
+  ASSERT_THROW(TwoCols{db.prepStatement("SELECT i FROM t1")}, InvalidColumnException);
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, Columnar_GenericView)
+{
+  auto db = getScenario01();
+  ExampleTable t{&db};
+  using Col = ExampleTable::Col;
+
+  // the buffer types are derived from the column definitions
+  using Rd = decltype(t.columnarReader<Col::intCol, Col::realCol, Col::stringCol>());
+  static_assert (std::is_same_v<Rd, ColumnarReader<int64_t, double, std::string>>);
+
+  auto rd = t.columnarReader<Col::intCol, Col::realCol>();
+  ASSERT_EQ(5, rd.nextChunk());
+  ASSERT_EQ(42 + 3 * 84, columnSum(rd.column<0>()));
+  auto mm = columnMinMax(rd.column<1>());
+  ASSERT_TRUE(mm.has_value());
+  ASSERT_NEAR(23.23, mm->first, 1e-9);
+  ASSERT_NEAR(666.66, mm->second, 1e-9);
+  ASSERT_EQ(3, columnCount(rd.column<1>()));
+  ASSERT_EQ(0, rd.nextChunk());
+
+  // with a compiled WHERE clause
+  using W = Sql::Eq<Col::intCol>;
+  auto rd2 = t.columnarReaderWhere<W, Col::id, Col::realCol>(DefaultColumnarChunkSize, 84);
+  ASSERT_EQ(3, rd2.nextChunk());
+  ASSERT_EQ(3 + 4 + 5, columnSum(rd2.column<0>()));
+  ASSERT_EQ(2, rd2.column<1>().nNull);
+  auto h = columnHistogram(rd2.column<1>(), 0, 100, 2);
+  ASSERT_EQ((std::vector<size_t>{1, 0}), h.bins);
+}
@@ -0,0 +1,193 @@
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "DatabaseTestScenario.h"
+#include "SampleDB.h"
+#include "SqliteConnectionPool.h"
+
+using namespace SqliteOverlay;
+
+TEST_F(DatabaseTestScenario, ConnectionPool_WriterAndReaders)
+{
+  prepScenario01();
+
+  // invalid parameters
+  ASSERT_THROW(SqliteConnectionPool<>(":memory:", 2), std::invalid_argument);
+  ASSERT_THROW(SqliteConnectionPool<>("", 2), std::invalid_argument);
+  ASSERT_THROW(SqliteConnectionPool<>(getSqliteFileName(), 0), std::invalid_argument);
+
+  SqliteConnectionPool<SampleDB> pool{getSqliteFileName(), 2};
+  ASSERT_EQ(2, pool.maxReaders());
+
+  // readers are opened lazily
+  auto st = pool.stats();
+  ASSERT_EQ(0, st.nReadersOpen);
+
+  // the writer is exclusive
+  {
+    auto w = pool.writerLease(std::chrono::milliseconds{0});
+    ASSERT_TRUE(w.isValid());
+    w->execNonQuery("INSERT INTO t1(i) VALUES(999)");
+    ASSERT_THROW(pool.writerLease(std::chrono::milliseconds{20}), BusyException);
+    ASSERT_EQ(1, w.connectionLeaseCount());
+  }
+  auto w = pool.writerLease(std::chrono::milliseconds{0});
+  ASSERT_EQ(2, w.connectionLeaseCount());
+  w.release();
+  ASSERT_FALSE(w.isValid());
+  ASSERT_THROW(w.db(), std::invalid_argument);
+
+  // readers see the writer's data and are read-only
+  auto r1 = pool.readerLease(std::chrono::milliseconds{0});
+  ASSERT_EQ(999, r1->execScalarQuery<int>("SELECT i FROM t1 WHERE rowid=6"));
+  ASSERT_THROW(r1->execNonQuery("INSERT INTO t1(i) VALUES(1)"), GenericSqliteException);
+  auto r2 = pool.readerLease(std::chrono::milliseconds{0});
+  st = pool.stats();
+  ASSERT_EQ(2, st.nReadersOpen);
+  ASSERT_EQ(2, st.nReadersLeased);
+  ASSERT_EQ(2, st.nReadersCreated);
+
+  // the pool is exhausted
+  ASSERT_THROW(pool.readerLease(std::chrono::milliseconds{20}), BusyException);
+  ASSERT_EQ(2, pool.stats().nTimeouts);
+
+  // a waiting caller gets the connection as soon as it is returned
+  std::thread t{[&r1](){
+      std::this_thread::sleep_for(std::chrono::milliseconds{50});
+      r1.release();
+    }};
+  auto r3 = pool.readerLease(std::chrono::milliseconds{5000});
+  t.join();
+  ASSERT_TRUE(r3.waitTime() >= std::chrono::milliseconds{40});
+  ASSERT_EQ(2, r3.connectionLeaseCount());   // re-used, not re-opened
+  st = pool.stats();
+  ASSERT_EQ(2, st.nReadersCreated);
+  ASSERT_EQ(3, st.readers.nLeases);
+  ASSERT_EQ(2, st.writer.nLeases);
+
+  // move semantics
+  r1 = std::move(r3);
+  ASSERT_TRUE(r1.isValid());
+  ASSERT_FALSE(r3.isValid());
+}
+
+//----------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, ConnectionPool_Reaping)
+{
+  prepScenario01();
+
+  int nInit = 0;
+  SqliteConnectionPool<> pool{
+    getSqliteFileName(), 4, std::chrono::milliseconds{50}, OpenMode::OpenExisting_RW,
+        [&nInit](SqliteDatabase& db) { ++nInit; db.enableStatementCache(); }
+  };
+  ASSERT_EQ(1, nInit);
+
+  {
+    auto r1 = pool.readerLease(std::chrono::milliseconds{0});
+    auto r2 = pool.readerLease(std::chrono::milliseconds{0});
+    ASSERT_TRUE(r1->isStatementCacheEnabled());
+  }
+  ASSERT_EQ(3, nInit);
+  ASSERT_EQ(2, pool.stats().nReadersOpen);
+
+  // nothing to reap yet
+  ASSERT_EQ(0, pool.reapIdleReaders());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds{60});
+  ASSERT_EQ(2, pool.reapIdleReaders());
+  auto st = pool.stats();
+  ASSERT_EQ(0, st.nReadersOpen);
+  ASSERT_EQ(2, st.nReadersReaped);
+  ASSERT_EQ(2, st.readers.nLeases);   // counters survive the reaping
+
+  // leased connections are never reaped
+  auto r = pool.readerLease(std::chrono::milliseconds{0});
+  ASSERT_EQ(0, pool.closeIdleReaders());
+  r.release();
+  ASSERT_EQ(1, pool.closeIdleReaders());
+}
+
+//----------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, ConnectionPool_ConnectionStats)
+{
+  prepScenario01();
+
+  SqliteConnectionPool<> pool{getSqliteFileName(), 2};
+  auto dbSt = pool.sampleConnectionStats();
+  ASSERT_EQ(0, dbSt.nReadersSampled);
+
+  {
+    auto w = pool.writerLease(std::chrono::milliseconds{0});
+    w->execNonQuery("UPDATE t1 SET s='abc' WHERE i=84");
+    auto r1 = pool.readerLease(std::chrono::milliseconds{0});
+    auto r2 = pool.readerLease(std::chrono::milliseconds{0});
+    ASSERT_EQ(5, r1->execScalarQuery<int>("SELECT count(*) FROM t1"));
+    ASSERT_EQ(5, r2->execScalarQuery<int>("SELECT count(*) FROM t1"));
+
+    // leased connections are sampled, too, because
+    // pooled connections use the serialized threading mode
+    ASSERT_TRUE(w->isSerialized());
+    ASSERT_TRUE(r1->isSerialized());
+    dbSt = pool.sampleConnectionStats(true);
+    ASSERT_TRUE(dbSt.isWriterSampled);
+    ASSERT_EQ(2, dbSt.nReadersSampled);
+    ASSERT_TRUE(dbSt.writer.memoryUsed > 0);
+    ASSERT_EQ(dbSt.writer.memoryUsed, dbSt.readers.memoryUsed);
+    ASSERT_TRUE(dbSt.writer.cacheWrites > 0);
+    ASSERT_EQ(0, dbSt.readers.cacheWrites);
+    ASSERT_TRUE(dbSt.readers.cacheMisses > 0);
+    ASSERT_TRUE(dbSt.readers.schemaUsed > r1->stats().schemaUsed);
+  }
+
+  // the counters have been reset
+  dbSt = pool.sampleConnectionStats();
+  ASSERT_EQ(0, dbSt.writer.cacheWrites);
+  ASSERT_EQ(0, dbSt.readers.cacheMisses);
+}
+
+//----------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, ConnectionPool_Threads)
+{
+  static constexpr int nThreads = 8;
+  static constexpr int nLoops = 50;
+
+  prepScenario01();
+
+  // concurrent readers and writers in rollback-journal mode
+  // need a busy timeout to avoid spurious BUSY errors; the pool
+  // uses a default timeout but we want to be on the safe side here
+  SqliteConnectionPool<> pool{getSqliteFileName(), 3, std::chrono::seconds{60}, OpenMode::OpenOrCreate_RW,
+                              [](SqliteDatabase& db) { db.setBusyTimeout(10000); }};
+
+  auto worker = [&pool]()
+  {
+    for (int i = 0; i < nLoops; ++i)
+    {
+      if ((i % 10) == 0)
+      {
+        auto w = pool.writerLease(std::chrono::milliseconds{10000});
+        w->execNonQuery("INSERT INTO t2(i) VALUES(1)");
+      }
+
+      auto r = pool.readerLease(std::chrono::milliseconds{10000});
+      r->execScalarQuery<int>("SELECT COUNT(*) FROM t1");
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < nThreads; ++i) threads.emplace_back(worker);
+  for (auto& t : threads) t.join();
+
+  auto st = pool.stats();
+  ASSERT_EQ(0, st.nTimeouts);
+  ASSERT_TRUE(st.nReadersCreated <= 3);
+  ASSERT_EQ(nThreads * nLoops, st.readers.nLeases);
+  ASSERT_EQ(nThreads * nLoops / 10, st.writer.nLeases);
+
+  auto w = pool.writerLease(std::chrono::milliseconds{0});
+  ASSERT_EQ(nThreads * nLoops / 10, w->execScalarQuery<int>("SELECT COUNT(*) FROM t2"));
+}
@@ -0,0 +1,177 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "DatabaseTestScenario.h"
+#include "CsvImport.h"
+#include "DbTab.h"
+#include "SqliteExceptions.h"
+
+using namespace SqliteOverlay;
+
+TEST_F(DatabaseTestScenario, CsvImport_Basics)
+{
+  auto db = getScenario01();
+  db.execNonQuery("CREATE TABLE csv (a, b, c)");
+
+  ASSERT_THROW(CsvStreamImporter(db, ""), std::invalid_argument);
+  CsvImportOptions badOpts;
+  badOpts.separator = '"';
+  ASSERT_THROW(CsvStreamImporter(db, "csv", badOpts), std::invalid_argument);
+
+  // quoted separators, line breaks and quotes, CRLF and empty values
+  std::istringstream in{
+    "a,b,c\r\n"
+    "1,2.5,hello\r\n"
+    "\"x,y\",\"line1\nline2\",\"say \"\"hi\"\"\"\r\n"
+    "\n"
+    ",\"\",\"42\"\n"
+    "-7,1e3,last"   // no trailing line break
+  };
+
+  DbTab tab{db, "csv", false};
+  ASSERT_EQ(4, tab.importCSVStream(in));
+  ASSERT_EQ(4, tab.length());
+
+  auto stmt = db.prepStatement("SELECT a, b, c, typeof(a), typeof(b), typeof(c) FROM csv ORDER BY rowid");
+
+  ASSERT_TRUE(stmt.dataStep());
+  ASSERT_EQ(1, stmt.get<int>(0));
+  ASSERT_EQ(2.5, stmt.get<double>(1));
+  ASSERT_EQ("hello", stmt.get<std::string>(2));
+  ASSERT_EQ("integer", stmt.get<std::string>(3));
+  ASSERT_EQ("real", stmt.get<std::string>(4));
+
+  ASSERT_TRUE(stmt.dataStep());
+  ASSERT_EQ("x,y", stmt.get<std::string>(0));
+  ASSERT_EQ("line1\nline2", stmt.get<std::string>(1));
+  ASSERT_EQ("say \"hi\"", stmt.get<std::string>(2));
+
+  // unquoted empty --> NULL; quoted empty --> empty string; quoted numbers stay text
+  ASSERT_TRUE(stmt.dataStep());
+  ASSERT_TRUE(stmt.isNull(0));
+  ASSERT_EQ("", stmt.get<std::string>(1));
+  ASSERT_EQ("text", stmt.get<std::string>(4));
+  ASSERT_EQ("text", stmt.get<std::string>(5));
+
+  ASSERT_TRUE(stmt.dataStep());
+  ASSERT_EQ(-7, stmt.get<int>(0));
+  ASSERT_EQ(1000.0, stmt.get<double>(1));
+  ASSERT_EQ("last", stmt.get<std::string>(2));
+
+  ASSERT_FALSE(stmt.dataStep());
+
+  // column names with embedded quotes
+  db.execNonQuery("CREATE TABLE csv2 (\"x\"\"y\", b)");
+  std::istringstream quotedHeader{"\"x\"\"y\",b\n1,2\n"};
+  DbTab tab2{db, "csv2", false};
+  ASSERT_EQ(1, tab2.importCSVStream(quotedHeader));
+  ASSERT_EQ(1, db.execScalarQuery<int>("SELECT \"x\"\"y\" FROM csv2"));
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, CsvImport_ManyRows)
+{
+  auto db = getScenario01();
+  db.execNonQuery("CREATE TABLE csv (id INTEGER, code TEXT, s TEXT)");
+
+  constexpr int nRows = 20000;
+  std::string data{"id,code,s\n"};
+  for (int i = 0; i < nRows; ++i)
+  {
+    data += std::to_string(i) + ",007,\"row " + std::to_string(i) + ", quoted\"\n";
+  }
+  std::istringstream in{data};
+
+  CsvImportOptions opts;
+  opts.chunkSize = 256;   // forces many chunks and records that span chunk boundaries
+  opts.commitInterval = 1000;
+  opts.nParserThreads = 4;
+  opts.columnTypes["code"] = ColumnDataType::Text;
+  int nCallbacks{0};
+  size_t lastProgress{0};
+  opts.progressCallback = [&](const CsvImportProgress& p) {
+    ++nCallbacks;
+    ASSERT_TRUE(p.nRows >= lastProgress);
+    lastProgress = p.nRows;
+  };
+
+  CsvStreamImporter imp{db, "csv", opts};
+  ASSERT_EQ(nRows, imp.importStream(in));
+  ASSERT_EQ(nRows, lastProgress);
+  ASSERT_EQ(nRows / 1000 + 1, nCallbacks);
+
+  // order is preserved
+  ASSERT_EQ(0, db.execScalarQuery<int>("SELECT count(*) FROM csv WHERE id + 1 != rowid"));
+
+  // the type hint preserves leading zeros
+  ASSERT_EQ(nRows, db.execScalarQuery<int>("SELECT count(*) FROM csv WHERE code = '007'"));
+  ASSERT_EQ("row 4711, quoted", db.execScalarQuery<std::string>("SELECT s FROM csv WHERE id = 4711"));
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, CsvImport_Errors)
+{
+  auto db = getScenario01();
+  db.execNonQuery("CREATE TABLE csv (a, b)");
+  DbTab tab{db, "csv", false};
+
+  // no headers at all
+  std::istringstream empty{""};
+  ASSERT_THROW(tab.importCSVStream(empty), std::invalid_argument);
+
+  // invalid column name
+  std::istringstream badCol{"a,xyz\n1,2\n"};
+  ASSERT_THROW(tab.importCSVStream(badCol), SqlStatementCreationError);
+
+  // wrong number of fields somewhere in the middle of the data;
+  // the import must stop and the pending transaction must be rolled back
+  std::string data{"a,b\n"};
+  for (int i = 0; i < 5000; ++i) data += "1,2\n";
+  data += "1,2,3\n";
+  for (int i = 0; i < 5000; ++i) data += "1,2\n";
+  std::istringstream badRow{data};
+  CsvImportOptions opts;
+  opts.chunkSize = 128;
+  opts.commitInterval = 0;
+  ASSERT_THROW(tab.importCSVStream(badRow, opts), std::invalid_argument);
+  ASSERT_EQ(0, tab.length());
+
+  // unterminated quote
+  std::istringstream badQuote{"a,b\n1,\"abc\n"};
+  ASSERT_THROW(tab.importCSVStream(badQuote), std::invalid_argument);
+  ASSERT_EQ(0, tab.length());
+
+  // non-existing file
+  ASSERT_THROW(tab.importCSVFile(genTestFilePath("doesNotExist.csv")), std::invalid_argument);
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, CsvImport_File)
+{
+  auto db = getScenario01();
+  db.execNonQuery("CREATE TABLE csv (a, b)");
+
+  const std::string fName = genTestFilePath("import.csv");
+  {
+    std::ofstream f{fName};
+    f << "b;a\n";
+    for (int i = 0; i < 100; ++i) f << i << ";" << (2 * i) << "\n";
+  }
+
+  CsvImportOptions opts;
+  opts.separator = ';';
+  DbTab tab{db, "csv", false};
+  ASSERT_EQ(100, tab.importCSVFile(fName, opts));
+  ASSERT_EQ(100, tab.length());
+  ASSERT_EQ(2 * 99, db.execScalarQuery<int>("SELECT max(a) FROM csv"));
+  ASSERT_EQ(99, db.execScalarQuery<int>("SELECT max(b) FROM csv"));
+
+  ASSERT_TRUE(std::filesystem::remove(fName));
+}
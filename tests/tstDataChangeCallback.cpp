@@ -1,3 +1,8 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <Sloppy/Timer.h>
@@ -7,6 +12,7 @@
 #include "SampleDB.h"
 #include "SqliteDatabase.h"
 #include "TabRow.h"
+#include "Transaction.h"
 #include "DbTab.h"
 
 using namespace SqliteOverlay;
@@ -171,6 +177,260 @@ TEST_F(DatabaseTestScenario, ChangeLog)
 
 //----------------------------------------------------------------------------
 
+TEST_F(DatabaseTestScenario, ChangeLog_Compact)
+{
+  auto db = getScenario01();
+
+  // draining without an enabled changelog is a no-op
+  std::vector<CompactChangeLogEntry> log;
+  ASSERT_EQ(0, db.drainChangeLog(log));
+  ASSERT_THROW(db.changeLogTabName(0), std::invalid_argument);
+
+  db.enableChangeLog(true);
+  db.execNonQuery("UPDATE t1 SET i=1 WHERE rowid=2");
+  db.execNonQuery("INSERT INTO t2(i) VALUES(5)");
+  db.execNonQuery("DELETE FROM t1 WHERE rowid=3");
+  ASSERT_EQ(3, db.getChangeLogLength());
+
+  ASSERT_EQ(3, db.drainChangeLog(log));
+  ASSERT_EQ(0, db.getChangeLogLength());
+  ASSERT_EQ(3, log.size());
+  ASSERT_EQ(RowChangeAction::Update, log[0].action);
+  ASSERT_EQ(2, log[0].rowId);
+  ASSERT_EQ(RowChangeAction::Insert, log[1].action);
+  ASSERT_EQ(1, log[1].rowId);
+  ASSERT_EQ(RowChangeAction::Delete, log[2].action);
+  ASSERT_EQ(3, log[2].rowId);
+
+  // names are interned
+  ASSERT_EQ(log[0].tabId, log[2].tabId);
+  ASSERT_NE(log[0].tabId, log[1].tabId);
+  ASSERT_EQ(log[0].dbId, log[1].dbId);
+  ASSERT_EQ("t1", db.changeLogTabName(log[0].tabId));
+  ASSERT_EQ("t2", db.changeLogTabName(log[1].tabId));
+  ASSERT_EQ("main", db.changeLogDbName(log[0].dbId));
+  ASSERT_THROW(db.changeLogTabName(99), std::invalid_argument);
+  ASSERT_THROW(db.changeLogDbName(99), std::invalid_argument);
+
+  // entries are appended to the caller's vector
+  db.execNonQuery("UPDATE t1 SET i=2 WHERE rowid=2");
+  ASSERT_EQ(1, db.drainChangeLog(log));
+  ASSERT_EQ(4, log.size());
+
+  // many entries that span several chunks, drained by
+  // another thread while the changes are being written
+  constexpr int nBatches{10};
+  constexpr int nRowsPerBatch{1000};
+  std::atomic<bool> isWriting{true};
+  std::vector<CompactChangeLogEntry> concurrentLog;
+  std::thread reader{[&]() {
+    while (isWriting) db.drainChangeLog(concurrentLog);
+    db.drainChangeLog(concurrentLog);
+  }};
+  for (int b = 0; b < nBatches; ++b)
+  {
+    db.execNonQuery("WITH RECURSIVE cnt(x) AS (SELECT 1 UNION ALL SELECT x+1 FROM cnt WHERE x < " +
+                    std::to_string(nRowsPerBatch) + ") INSERT INTO t2(i) SELECT x FROM cnt");
+  }
+  isWriting = false;
+  reader.join();
+
+  ASSERT_EQ(nBatches * nRowsPerBatch, concurrentLog.size());
+  ASSERT_TRUE(nBatches * nRowsPerBatch > static_cast<int>(ChangeLogBuffer::ChunkSize));
+  for (size_t idx = 0; idx < concurrentLog.size(); ++idx)
+  {
+    ASSERT_EQ(RowChangeAction::Insert, concurrentLog[idx].action);
+    ASSERT_EQ(static_cast<int64_t>(idx + 2), concurrentLog[idx].rowId);   // row 1 was inserted above
+    ASSERT_EQ(log[1].tabId, concurrentLog[idx].tabId);
+  }
+
+  // the legacy interface still works across chunk boundaries
+  db.execNonQuery("DELETE FROM t2 WHERE rowid > 0");   // no truncate optimization
+  ChangeLogList l = db.getAllChangesAndClearQueue();
+  ASSERT_EQ(1 + nBatches * nRowsPerBatch, l.size());
+  ASSERT_EQ(RowChangeAction::Delete, l.back().action);
+  ASSERT_EQ("t2", l.back().tabName);
+  ASSERT_EQ("main", l.back().dbName);
+  ASSERT_EQ(0, db.getChangeLogLength());
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, ChangeLog_FilterAndCoalesce)
+{
+  auto db = getScenario01();
+
+  // only log changes to t2
+  db.setChangeLogTableFilter({"t2"});
+  db.enableChangeLog(true);
+  db.execNonQuery("UPDATE t1 SET i=1 WHERE rowid=2");
+  db.execNonQuery("INSERT INTO t2(i) VALUES(5)");
+  ASSERT_EQ(1, db.getChangeLogLength());
+  ChangeLogList l = db.getAllChangesAndClearQueue();
+  ASSERT_EQ("t2", l.at(0).tabName);
+
+  // remove the filter
+  db.setChangeLogTableFilter({});
+  db.execNonQuery("UPDATE t1 SET i=1 WHERE rowid=2");
+  ASSERT_EQ(1, db.getChangeLogLength());
+  l = db.getAllChangesAndClearQueue();
+  ASSERT_EQ("t1", l.at(0).tabName);
+
+  // many updates of the same rows collapse into one entry per row
+  {
+    auto tr = db.startTransaction();
+    for (int k = 0; k < 50; ++k)
+    {
+      db.execNonQuery("UPDATE t1 SET i=" + std::to_string(k) + " WHERE rowid IN (5, 3)");
+    }
+    tr.commit();
+  }
+  std::vector<CompactChangeLogEntry> log;
+  ASSERT_EQ(2, db.drainChangeLog(log, true));
+  ASSERT_EQ(2, log.size());
+  ASSERT_EQ(3, log[0].rowId);   // sorted by rowid
+  ASSERT_EQ(RowChangeAction::Update, log[0].action);
+  ASSERT_EQ(5, log[1].rowId);
+  ASSERT_EQ(RowChangeAction::Update, log[1].action);
+
+  // net effects of mixed sequences
+  db.execNonQuery("INSERT INTO t2(i) VALUES(10)");   // rowid 2: insert + update --> insert
+  db.execNonQuery("UPDATE t2 SET i=11 WHERE rowid=2");
+  db.execNonQuery("INSERT INTO t2(i) VALUES(20)");   // rowid 3: insert + delete --> nothing
+  db.execNonQuery("DELETE FROM t2 WHERE rowid=3");
+  db.execNonQuery("UPDATE t1 SET i=0 WHERE rowid=4");   // t1, rowid 4: update + delete --> delete
+  db.execNonQuery("DELETE FROM t1 WHERE rowid=4");
+  db.execNonQuery("UPDATE t2 SET i=0 WHERE rowid=1");   // t2, rowid 1: update --> update
+  db.execNonQuery("DELETE FROM t1 WHERE rowid=1");   // t1, rowid 1: delete + insert --> update
+  db.execNonQuery("INSERT INTO t1(rowid, i) VALUES(1, 1)");
+
+  l = db.getAllChangesAndClearQueue(true);
+  ASSERT_EQ(4, l.size());
+  ASSERT_EQ("t1", l[0].tabName);   // tables are sorted by the order of their first appearance
+  ASSERT_EQ(1, l[0].rowId);
+  ASSERT_EQ(RowChangeAction::Update, l[0].action);
+  ASSERT_EQ("t1", l[1].tabName);
+  ASSERT_EQ(4, l[1].rowId);
+  ASSERT_EQ(RowChangeAction::Delete, l[1].action);
+  ASSERT_EQ("t2", l[2].tabName);
+  ASSERT_EQ(1, l[2].rowId);
+  ASSERT_EQ(RowChangeAction::Update, l[2].action);
+  ASSERT_EQ("t2", l[3].tabName);
+  ASSERT_EQ(2, l[3].rowId);
+  ASSERT_EQ(RowChangeAction::Insert, l[3].action);
+
+  // coalescing only affects the newly drained entries
+  log.clear();
+  db.execNonQuery("UPDATE t2 SET i=1 WHERE rowid=1");
+  db.drainChangeLog(log);
+  db.execNonQuery("UPDATE t2 SET i=2 WHERE rowid=1");
+  db.execNonQuery("UPDATE t2 SET i=3 WHERE rowid=1");
+  ASSERT_EQ(1, db.drainChangeLog(log, true));
+  ASSERT_EQ(2, log.size());
+  ASSERT_EQ(1, coalesceChangeLog(log));
+  ASSERT_EQ(1, log.size());
+  ASSERT_EQ(0, coalesceChangeLog(log, 5));
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, ChangeLog_WaitForChanges)
+{
+  using namespace std::chrono_literals;
+
+  auto db = getScenario01();
+  SampleDB db2{getSqliteFileName(), OpenMode::OpenExisting_RW};
+
+  // local changes require the changelog
+  ASSERT_THROW(db.waitForChanges(1ms, ChangeSource::Local), std::logic_error);
+  ASSERT_THROW(db.waitForChanges(1ms), std::logic_error);
+  db.enableChangeLog(true);
+
+  // timeouts
+  ASSERT_EQ(ChangeSource::None, db.waitForChanges(10ms, ChangeSource::Local));
+  ASSERT_EQ(ChangeSource::None, db.waitForChanges(10ms, ChangeSource::External));
+  ASSERT_EQ(ChangeSource::None, db.waitForChanges(10ms));
+
+  // a local change from another thread wakes up the waiter
+  auto t0 = std::chrono::steady_clock::now();
+  std::thread writer{[&db]() {
+    std::this_thread::sleep_for(50ms);
+    db.execNonQuery("UPDATE t1 SET i=1 WHERE rowid=1");
+  }};
+  ASSERT_EQ(ChangeSource::Local, db.waitForChanges(10s, ChangeSource::Local));
+  ASSERT_TRUE((std::chrono::steady_clock::now() - t0) < 5s);
+  writer.join();
+
+  // pending changes are reported immediately
+  ASSERT_EQ(ChangeSource::Local, db.waitForChanges(0ms, ChangeSource::Local));
+  ASSERT_EQ(ChangeSource::Local, db.waitForChanges(10s));
+  std::vector<CompactChangeLogEntry> log;
+  db.drainChangeLog(log);
+
+  // same in combined mode
+  t0 = std::chrono::steady_clock::now();
+  writer = std::thread{[&db]() {
+    std::this_thread::sleep_for(50ms);
+    db.execNonQuery("UPDATE t1 SET i=2 WHERE rowid=1");
+  }};
+  ASSERT_EQ(ChangeSource::Local, db.waitForChanges(10s));
+  ASSERT_TRUE((std::chrono::steady_clock::now() - t0) < 5s);
+  writer.join();
+  db.drainChangeLog(log);
+
+  // waiting "forever"
+  for (ChangeSource filter : {ChangeSource::Local, ChangeSource::Any})
+  {
+    writer = std::thread{[&db]() {
+      std::this_thread::sleep_for(50ms);
+      db.execNonQuery("UPDATE t1 SET i=2 WHERE rowid=1");
+    }};
+    ASSERT_EQ(ChangeSource::Local, db.waitForChanges(std::chrono::milliseconds::max(), filter));
+    writer.join();
+    db.drainChangeLog(log);
+  }
+
+  // our own changes are not reported as external changes
+  ASSERT_EQ(ChangeSource::None, db.waitForChanges(10ms, ChangeSource::External));
+
+  // changes by another connection
+  t0 = std::chrono::steady_clock::now();
+  writer = std::thread{[&db2]() {
+    std::this_thread::sleep_for(50ms);
+    db2.execNonQuery("UPDATE t1 SET i=3 WHERE rowid=1");
+  }};
+  ASSERT_EQ(ChangeSource::External, db.waitForChanges(10s));
+  ASSERT_TRUE((std::chrono::steady_clock::now() - t0) < 5s);
+  writer.join();
+  ASSERT_EQ(0, db.getChangeLogLength());
+
+  ASSERT_EQ(ChangeSource::External, db.waitForChanges(10s, ChangeSource::External));
+  db.resetExternalChangeCounter();
+  ASSERT_EQ(ChangeSource::None, db.waitForChanges(10ms, ChangeSource::External));
+
+  // local and external changes at the same time
+  db.execNonQuery("UPDATE t1 SET i=4 WHERE rowid=1");
+  db2.execNonQuery("UPDATE t1 SET i=5 WHERE rowid=1");
+  ASSERT_EQ(ChangeSource::Any, db.waitForChanges(10s));
+  db.drainChangeLog(log);
+  db.resetExternalChangeCounter();
+
+  // the WAL file is created after the watches have been
+  // set up; changes in the WAL file are detected nevertheless
+  db2.execNonQuery("PRAGMA journal_mode=WAL");
+  db.resetExternalChangeCounter();
+  t0 = std::chrono::steady_clock::now();
+  writer = std::thread{[&db2]() {
+    std::this_thread::sleep_for(50ms);
+    db2.execNonQuery("UPDATE t1 SET i=6 WHERE rowid=1");
+  }};
+  ASSERT_EQ(ChangeSource::External, db.waitForChanges(10s, ChangeSource::External));
+  ASSERT_TRUE((std::chrono::steady_clock::now() - t0) < 5s);
+  writer.join();
+}
+
+//----------------------------------------------------------------------------
+
 TEST_F(DatabaseTestScenario, ChangeLogSpeedImpact)
 {
   auto db = getScenario01();
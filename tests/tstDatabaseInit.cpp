@@ -107,6 +107,69 @@ TEST_F(DatabaseTestScenario, MoveOps)
 
 //----------------------------------------------------------------
 
+TEST_F(DatabaseTestScenario, OpenOptions)
+{
+  string dbFileName = getSqliteFileName();
+
+  // default settings
+  {
+    SqliteDatabase db{dbFileName, OpenMode::ForceNew};
+    ASSERT_EQ(0, db.execScalarQuery<int>("PRAGMA synchronous"));
+    ASSERT_EQ(1, db.execScalarQuery<int>("PRAGMA foreign_keys"));
+    ASSERT_EQ("delete", db.execScalarQuery<string>("PRAGMA journal_mode"));
+  }
+  ASSERT_TRUE(fs::remove(dbFileName));
+
+  // page size on a new file and an OLTP preset
+  auto opts = OpenOptions::OLTP();
+  opts.pageSize = 8192;
+  SqliteDatabase db{dbFileName, OpenMode::ForceNew, opts};
+  ASSERT_EQ(8192, db.execScalarQuery<int>("PRAGMA page_size"));
+  ASSERT_EQ("wal", db.execScalarQuery<string>("PRAGMA journal_mode"));
+  ASSERT_EQ(1, db.execScalarQuery<int>("PRAGMA synchronous"));
+  ASSERT_EQ(-16384, db.execScalarQuery<int>("PRAGMA cache_size"));
+  ASSERT_EQ(2, db.execScalarQuery<int>("PRAGMA temp_store"));
+  ASSERT_EQ(5000, db.execScalarQuery<int>("PRAGMA busy_timeout"));
+  ASSERT_EQ(1, db.execScalarQuery<int>("PRAGMA foreign_keys"));
+  ASSERT_EQ(8192, *db.getOpenOptions().pageSize);
+
+  // the page size of an existing, non-empty file is not changed
+  db.execNonQuery("CREATE TABLE t (i INTEGER)");
+  opts.pageSize = 1024;
+  db.applyOpenOptions(opts);
+  ASSERT_EQ(8192, db.execScalarQuery<int>("PRAGMA page_size"));
+
+  // duplicated connections inherit the settings,
+  // also for derived classes
+  auto db2 = db.duplicateConnection(true);
+  ASSERT_EQ(-16384, db2.execScalarQuery<int>("PRAGMA cache_size"));
+  ASSERT_EQ(5000, db2.execScalarQuery<int>("PRAGMA busy_timeout"));
+  ASSERT_EQ("wal", db2.execScalarQuery<string>("PRAGMA journal_mode"));
+  auto db3 = db.duplicateConnection<SampleDB>(false);
+  ASSERT_EQ(1, db3.execScalarQuery<int>("PRAGMA synchronous"));
+  ASSERT_EQ(-16384, db3.execScalarQuery<int>("PRAGMA cache_size"));
+
+  // re-tuning an open connection
+  db3.applyOpenOptions(OpenOptions::ReadMostly());
+  ASSERT_EQ(-65536, db3.execScalarQuery<int>("PRAGMA cache_size"));
+
+  // a journal mode switch that SQLite refuses is reported
+  // (leaving WAL mode requires exclusive access to the file)
+  OpenOptions toDelete;
+  toDelete.journalMode = JournalMode::Delete;
+  toDelete.busyTimeout_ms = 10;
+  ASSERT_THROW(db.applyOpenOptions(toDelete), BasicException);
+  ASSERT_EQ("wal", db.execScalarQuery<string>("PRAGMA journal_mode"));
+
+  // bulk load preset on an in-memory database
+  SqliteDatabase memDb{":memory:", OpenMode::OpenOrCreate_RW, OpenOptions::BulkLoad()};
+  ASSERT_EQ("memory", memDb.execScalarQuery<string>("PRAGMA journal_mode"));
+  ASSERT_EQ("exclusive", memDb.execScalarQuery<string>("PRAGMA locking_mode"));
+  ASSERT_EQ(0, memDb.execScalarQuery<int>("PRAGMA synchronous"));
+}
+
+//----------------------------------------------------------------
+
 /*
 TEST_F(DatabaseTestScenario, PopulateTablesAndViews)
 {
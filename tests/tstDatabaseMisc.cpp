@@ -2,6 +2,7 @@
 
 #include "DatabaseTestScenario.h"
 #include "SampleDB.h"
+#include "Transaction.h"
 //#include "ClausesAndQueries.h"
 
 using namespace SqliteOverlay;
@@ -124,3 +125,68 @@ TEST_F(DatabaseTestScenario, CheckDatabaseComparison)
 
   ASSERT_TRUE(memDb != db1);
 }
+
+//----------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, ConnectionStats)
+{
+  auto db = getScenario01();
+
+  // a fresh connection has to read everything from disk
+  ASSERT_EQ(5, db.execScalarQuery<int>("SELECT count(*) FROM t1"));
+  ConnectionStats st = db.stats();
+  ASSERT_TRUE(st.cacheMisses > 0);
+  ASSERT_TRUE(st.cacheUsed > 0);
+  ASSERT_TRUE(st.schemaUsed > 0);
+  ASSERT_TRUE(st.memoryUsed > 0);
+  ASSERT_TRUE(st.memoryHighwater >= st.memoryUsed);
+
+  // now the pages are cached
+  db.stats(true);
+  ASSERT_EQ(5, db.execScalarQuery<int>("SELECT count(*) FROM t1"));
+  st = db.stats();
+  ASSERT_TRUE(st.cacheHits > 0);
+  ASSERT_EQ(0, st.cacheMisses);
+  ASSERT_EQ(0, st.cacheWrites);
+  ASSERT_TRUE(st.cacheHitRatio() > 0.99);
+
+  // an open statement consumes statement memory
+  {
+    auto stmt = db.prepStatement("SELECT * FROM t1 WHERE i > 10 ORDER BY s");
+    ASSERT_TRUE(db.stats().stmtUsed > st.stmtUsed);
+  }
+
+  // writes
+  db.execNonQuery("UPDATE t1 SET s='xyz' WHERE i=84");
+  ASSERT_TRUE(db.stats().cacheWrites > 0);
+
+  // a tiny page cache spills dirty pages in the middle of a transaction
+  db.execNonQuery("PRAGMA cache_size=2");
+  db.stats(true);
+  db.execNonQuery("CREATE TABLE big(x TEXT)");
+  {
+    auto tr = db.startTransaction();
+    auto stmt = db.prepStatement("INSERT INTO big VALUES(?)");
+    const std::string payload(500, 'x');
+    for (int i = 0; i < 200; ++i)
+    {
+      stmt.bind(1, payload);
+      stmt.step();
+      stmt.reset(true);
+    }
+    tr.commit();
+  }
+  st = db.stats();
+  ASSERT_TRUE(st.cacheSpills > 0);
+
+  // aggregation
+  ConnectionStats sum;
+  sum += st;
+  sum += st;
+  ASSERT_EQ(2 * st.cacheWrites, sum.cacheWrites);
+  ASSERT_EQ(st.memoryHighwater, sum.memoryHighwater);
+
+  // closed connection
+  db.close();
+  ASSERT_THROW(db.stats(), std::invalid_argument);
+}
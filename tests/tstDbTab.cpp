@@ -68,6 +68,72 @@ TEST_F(DatabaseTestScenario, DbTab_Insert)
 }
 //----------------------------------------------------------------------------
 
+TEST_F(DatabaseTestScenario, DbTab_InsertRows)
+{
+  auto db = getScenario01();
+  DbTab t2{db,"t2", false};
+  ASSERT_EQ(0, t2.length());
+
+  // empty input
+  ASSERT_EQ(std::make_pair(-1, -1), t2.insertRows(std::vector<ColumnValueClause>{}));
+
+  // column value clauses with changing column sets
+  std::vector<ColumnValueClause> clauses(3);
+  clauses[0].addCol("i", 1);
+  clauses[1].addCol("i", 2);
+  clauses[2].addCol("s", "three");
+  clauses[2].addNullCol("i");
+  auto [first, last] = t2.insertRows(clauses);
+  ASSERT_EQ(1, first);
+  ASSERT_EQ(3, last);
+  ASSERT_EQ(3, t2.length());
+  ASSERT_EQ(2, db.execScalarQuery<int>("SELECT i FROM t2 WHERE rowid=2"));
+  ASSERT_EQ("three", db.execScalarQuery<std::string>("SELECT s FROM t2 WHERE rowid=3"));
+
+  // tuples; enough rows to require several
+  // multi-row statements plus a remainder
+  const int nRows = 2 * DbTab::MaxRowsPerInsertStmt + 10;
+  std::vector<std::tuple<int, std::optional<double>, std::string>> tuples;
+  for (int i = 0; i < nRows; ++i)
+  {
+    std::optional<double> f;
+    if ((i % 2) == 0) f = i * 0.5;
+    tuples.push_back(std::make_tuple(i, f, "row" + std::to_string(i)));
+  }
+  std::tie(first, last) = t2.insertRows({"i", "f", "s"}, tuples);
+  ASSERT_EQ(4, first);
+  ASSERT_EQ(3 + nRows, last);
+  ASSERT_EQ(3 + nRows, t2.length());
+  ASSERT_EQ(nRows - 1, db.execScalarQuery<int>("SELECT i FROM t2 WHERE rowid=" + std::to_string(last)));
+  ASSERT_EQ("row" + std::to_string(nRows - 1), db.execScalarQuery<std::string>("SELECT s FROM t2 WHERE rowid=" + std::to_string(last)));
+  ASSERT_EQ(nRows / 2, db.execScalarQuery<int>("SELECT COUNT(*) FROM t2 WHERE rowid >= 4 AND f IS NULL"));
+  ASSERT_EQ(5.0, db.execScalarQuery<double>("SELECT f FROM t2 WHERE i=10 AND rowid >= 4"));
+
+  // column vectors
+  std::vector<int> iCol{100, 101};
+  std::vector<std::string> sCol{"a", "b"};
+  std::tie(first, last) = t2.insertRows({"i", "s"}, std::tie(iCol, sCol), false);
+  ASSERT_EQ(4 + nRows, first);
+  ASSERT_EQ(5 + nRows, last);
+  ASSERT_EQ("b", db.execScalarQuery<std::string>("SELECT s FROM t2 WHERE rowid=" + std::to_string(last)));
+
+  // invalid parameters
+  ASSERT_THROW(t2.insertRows({"i"}, tuples), std::invalid_argument);
+  sCol.push_back("c");
+  ASSERT_THROW(t2.insertRows({"i", "s"}, std::tie(iCol, sCol), false), std::invalid_argument);
+
+  // a failing row rolls back the complete batch
+  db.execNonQuery("CREATE TABLE t3 (i INTEGER UNIQUE)");
+  DbTab t3{db, "t3", false};
+  std::vector<std::tuple<int>> badRows(10, std::make_tuple(1));
+  ASSERT_THROW(t3.insertRows({"sdkjfsfd"}, badRows), SqlStatementCreationError);
+  ASSERT_THROW(t3.insertRows({"i"}, badRows), ConstraintFailedException);
+  ASSERT_EQ(0, t3.length());
+  ASSERT_TRUE(db.isAutoCommit());
+}
+
+//----------------------------------------------------------------------------
+
 TEST_F(DatabaseTestScenario, DbTab_SubscriptOperator)
 {
   auto db = getScenario01();
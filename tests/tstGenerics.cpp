@@ -340,3 +340,209 @@ TEST_F(DatabaseTestScenario, Generics_UpdateColumn)
     ASSERT_EQ(o.i, 1234);
   }
 }
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, Generics_CompiledQueries)
+{
+  using namespace SqliteOverlay::Sql;
+  using Col = ExampleTable::Col;
+
+  // the SQL text is generated at compile time
+  using Q1 = CompiledSql<ExampleAdapterClass, CountHead, WherePart<Or<Eq<Col::intCol>, And<Between<Col::realCol>, In<Col::stringCol, 3>>>>>;
+  static_assert (Q1::text.view() == "SELECT COUNT(*) FROM t1 WHERE (i=? OR (f BETWEEN ? AND ? AND s IN (?,?,?)))");
+  using Q2 = CompiledSql<ExampleAdapterClass, SelectHead, WherePart<IsNull<Col::realCol>>, OrderBy<Desc<Col::stringCol>, Asc<Col::id>>, LimitPart<12>>;
+  static_assert (Q2::text.view() == "SELECT rowid,i,f,s,d FROM t1 WHERE f IS NULL ORDER BY s DESC,rowid ASC LIMIT 12");
+  static_assert (Or<Eq<Col::intCol>, And<Between<Col::realCol>, In<Col::stringCol, 3>>>::nParams == 6);
+
+  SampleDB db = getScenario01();
+  db.enableStatementCache();
+  ExampleTable t{&db};
+
+  // simple comparisons
+  auto lst = t.objectsWhere<Eq<Col::intCol>>(84);
+  ASSERT_EQ(3, lst.size());
+  lst = t.objectsWhere<Gt<Col::realCol>, OrderBy<Desc<Col::realCol>>>(30.0);
+  ASSERT_EQ(2, lst.size());
+  ASSERT_EQ(2, lst[0].id.get());
+  ASSERT_EQ(5, lst[1].id.get());
+  ASSERT_EQ(2, t.objCountWhere<IsNull<Col::realCol>>());
+  ASSERT_EQ(4, t.objCountWhere<NotNull<Col::intCol>>());
+
+  // IN, BETWEEN, OR, AND
+  using InStr2 = In<Col::stringCol, 2>;
+  ASSERT_EQ(3, t.objCountWhere<InStr2>("Ho", "Hallo"));
+  ASSERT_EQ(2, t.objCountWhere<Between<Col::realCol>>(20.0, 50.0));
+  using W1 = Or<Eq<Col::stringCol>, IsNull<Col::intCol>>;
+  ASSERT_EQ(2, t.objCountWhere<W1>("Hallo"));
+  using W2 = And<Eq<Col::intCol>, NotNull<Col::realCol>>;
+  ASSERT_EQ(1, t.objCountWhere<W2>(84));
+  using W3 = Or<Eq<Col::intCol>, And<Between<Col::realCol>, In<Col::stringCol, 3>>>;
+  ASSERT_EQ(4, t.objCountWhere<W3>(84, 0.0, 30.0, "Hallo", "x", "y"));
+
+  // single objects and ordering
+  auto o = t.singleObjectWhere<Eq<Col::intCol>, OrderBy<Desc<Col::id>>>(84);
+  ASSERT_TRUE(equalsExampleObj(o, 5));
+  o = t.singleObjectWhere<Eq<Col::intCol>>(4711);
+  ASSERT_FALSE(o.has_value());
+  lst = t.allObjOrdered<OrderBy<Asc<Col::stringCol>, Desc<Col::id>>>();
+  ASSERT_EQ(5, lst.size());
+  ASSERT_EQ(1, lst[0].id.get());   // Hallo
+  ASSERT_EQ(2, lst[1].id.get());   // Hi
+  ASSERT_EQ(5, lst[2].id.get());   // Ho, id 5
+  ASSERT_EQ(4, lst[3].id.get());   // Ho, id 4
+
+  // NULL values
+  ASSERT_TRUE(t.hasWhere<Eq<Col::intCol>>(std::optional<int>{42}));
+  ASSERT_FALSE(t.hasWhere<Eq<Col::intCol>>(std::optional<int>{}));
+  ASSERT_FALSE(t.hasWhere<Eq<Col::intCol>>(std::nullopt));
+
+  // repeated calls are served from the statement cache
+  db.resetStatementCacheStats();
+  for (int i = 0; i < 10; ++i)
+  {
+    ASSERT_EQ(3, t.objCountWhere<Eq<Col::intCol>>(84));
+  }
+  auto cs = db.getStatementCacheStats();
+  ASSERT_EQ(10, cs.hits);
+  ASSERT_EQ(0, cs.misses);
+
+  // deletion
+  using W4 = And<Eq<Col::intCol>, In<Col::stringCol, 1>>;
+  ASSERT_EQ(2, t.delWhere<W4>(84, "Ho"));
+  ASSERT_EQ(3, t.objCount());
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, Generics_BatchOperations)
+{
+  SampleDB db = getScenario01();
+  ExampleTable t{&db};
+
+  std::vector<ExampleObj> objs;
+  for (int i = 0; i < 3; ++i)
+  {
+    objs.push_back(ExampleObj{
+                     .id = ExampleId{999},
+                     .i = 1000 + i,
+                     .f = std::nullopt,
+                     .s = "batch" + std::to_string(i),
+                     .d = Sloppy::DateTime::WallClockTimepoint_secs().ymd()
+                   });
+  }
+
+  // insert
+  auto ids = t.insertMany(objs);
+  ASSERT_EQ(3, ids.size());
+  ASSERT_EQ(ExampleId{6}, ids[0]);
+  ASSERT_EQ(ExampleId{7}, ids[1]);
+  ASSERT_EQ(ExampleId{8}, ids[2]);
+  ASSERT_TRUE(db.isAutoCommit());   // the internal transaction has been committed
+  for (int i = 0; i < 3; ++i)
+  {
+    objs[i].id = ids[i];
+    ASSERT_EQ(objs[i], *t.singleObjectById(ids[i]));
+  }
+  ASSERT_TRUE(t.insertMany(std::vector<ExampleObj>{}).empty());
+
+  // the caller's transaction is used
+  {
+    auto tr = db.startTransaction();
+    ids = t.insertMany(objs);
+    ASSERT_EQ(ExampleId{9}, ids[0]);
+    ASSERT_FALSE(db.isAutoCommit());
+    tr.rollback();
+  }
+  ASSERT_EQ(8, t.objCount());
+
+  // overwrite, including one non-existing object
+  for (auto& o : objs) o.s = "updated";
+  objs.push_back(objs[0]);
+  objs.back().id = ExampleId{4711};
+  ASSERT_EQ(3, t.overwriteMany(objs));
+  ASSERT_EQ(3, t.objCount(ExampleTable::Col::stringCol, "updated"));
+
+  // works with views, too
+  auto firstTwo = objs | std::views::take(2);
+  ASSERT_EQ(2, t.overwriteMany(firstTwo));
+
+  // delete, including a non-existing ID
+  const std::vector<ExampleId> delIds{ExampleId{6}, ExampleId{8}, ExampleId{4711}};
+  ASSERT_EQ(2, t.deleteMany(delIds));
+  ASSERT_EQ(6, t.objCount());
+  ASSERT_FALSE(t.has(ExampleId{6}));
+  ASSERT_TRUE(t.has(ExampleId{7}));
+  ASSERT_EQ(0, t.deleteMany(std::vector<ExampleId>{}));
+
+  // more IDs than SQL variables in a single statement
+  const int maxVars = db.getLimit(SQLITE_LIMIT_VARIABLE_NUMBER);
+  std::vector<ExampleObj> many(maxVars + 10, objs[0]);
+  ids = t.insertMany(many);
+  ASSERT_EQ(maxVars + 10, ids.size());
+  ASSERT_EQ(maxVars + 16, t.objCount());
+  ASSERT_EQ(maxVars + 10, t.deleteMany(ids));
+  ASSERT_EQ(6, t.objCount());
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, Generics_LazyStreams)
+{
+  static_assert (std::ranges::input_range<ObjStream<ExampleAdapterClass>>);
+  static_assert (std::ranges::view<ObjStream<ExampleAdapterClass>>);
+
+  SampleDB db = getScenario01();
+  ExampleTable t{&db};
+
+  // full iteration
+  int n{0};
+  for (const ExampleObj& o : t.streamAllObj())
+  {
+    ++n;
+    ASSERT_TRUE(equalsExampleObj(o, n));
+  }
+  ASSERT_EQ(5, n);
+
+  // composition with standard views
+  {
+    auto s = t.streamAllObj()
+        | std::views::filter([](const ExampleObj& o) { return o.f.has_value(); })
+        | std::views::transform([](const ExampleObj& o) { return o.id.get(); })
+        | std::views::take(2);
+    std::vector<int> ids;
+    for (int id : s) ids.push_back(id);
+    ASSERT_EQ((std::vector<int>{1, 2}), ids);
+  }
+
+  // with a WHERE clause
+  n = 0;
+  for (const ExampleObj& o : t.streamObjectsByColumnValue(ExampleTable::Col::intCol, 84))
+  {
+    ASSERT_EQ(84, o.i);
+    ++n;
+  }
+  ASSERT_EQ(3, n);
+  using W = SqliteOverlay::Sql::Gt<ExampleTable::Col::id>;
+  using O = SqliteOverlay::Sql::OrderBy<SqliteOverlay::Sql::Desc<ExampleTable::Col::id>>;
+  auto s2 = t.streamObjectsWhere<W, O>(3);
+  auto it = s2.begin();
+  ASSERT_EQ(5, it->id.get());
+  ++it;
+  ASSERT_EQ(4, it->id.get());
+  ++it;
+  ASSERT_TRUE(it == s2.end());
+
+  // no matches
+  auto s3 = t.streamObjectsByColumnValue(ExampleTable::Col::intCol, 4711);
+  ASSERT_TRUE(s3.begin() == s3.end());
+
+  // early termination: an active statement would block the DROP TABLE
+  {
+    auto s4 = t.streamAllObj();
+    ASSERT_EQ(1, s4.begin()->id.get());
+    ASSERT_THROW(db.execNonQuery("DROP TABLE t1"), GenericSqliteException);
+  }
+  db.execNonQuery("DROP VIEW v1");
+  db.execNonQuery("DROP TABLE t1");
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ClausesAndQueries.h"
+#include "DatabaseTestScenario.h"
+#include "DbTab.h"
+#include "GroupCommitQueue.h"
+#include "SampleDB.h"
+#include "Transaction.h"
+
+using namespace SqliteOverlay;
+
+TEST_F(DatabaseTestScenario, GroupCommit_ConcurrentWriters)
+{
+  auto db = getScenario01();
+  GroupCommitQueue<SampleDB> q{getSqliteFileName(), 1000, std::chrono::milliseconds{20}};
+  ASSERT_THROW((GroupCommitQueue<>{getSqliteFileName(), 0}), std::invalid_argument);
+
+  // several threads submit inserts concurrently
+  constexpr int nThreads{4};
+  constexpr int nJobsPerThread{25};
+  std::vector<std::thread> threads;
+  std::vector<std::vector<std::future<int>>> futures(nThreads);
+  for (int t = 0; t < nThreads; ++t)
+  {
+    threads.emplace_back([&q, &futures, t]() {
+      for (int k = 0; k < nJobsPerThread; ++k)
+      {
+        futures[t].push_back(q.submit([t](SampleDB& d) {
+          DbTab t1{d, "t1", false};
+          ColumnValueClause cvc;
+          cvc.addCol("i", 1000 + t);
+          return t1.insertRow(cvc);
+        }));
+      }
+    });
+  }
+  for (auto& th : threads) th.join();
+
+  // all futures resolve with distinct row IDs, and the rows are
+  // visible for other connections as soon as the future is ready
+  std::vector<int> ids;
+  for (auto& fv : futures)
+  {
+    for (auto& f : fv)
+    {
+      const int id = f.get();
+      ASSERT_EQ(1, db.execScalarQuery<int>("SELECT count(*) FROM t1 WHERE rowid=" + std::to_string(id)));
+      ids.push_back(id);
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  ASSERT_TRUE(std::adjacent_find(ids.begin(), ids.end()) == ids.end());
+  ASSERT_EQ(5 + nThreads * nJobsPerThread, db.execScalarQuery<int>("SELECT count(*) FROM t1"));
+
+  // far fewer transactions than jobs
+  auto st = q.stats();
+  ASSERT_EQ(nThreads * nJobsPerThread, st.nJobs);
+  ASSERT_EQ(0, st.nFailedJobs);
+  ASSERT_EQ(0, st.nFailedCommits);
+  ASSERT_TRUE(st.nCommits < static_cast<size_t>(nThreads * nJobsPerThread));
+  ASSERT_TRUE(st.maxBatchSize > 1);
+  ASSERT_EQ(0, q.pendingCount());
+
+  // without explicit options, commits are synced and the writer waits for locks
+  ASSERT_EQ(2, q.submit([](SampleDB& d) { return d.execScalarQuery<int>("PRAGMA synchronous"); }).get());
+  ASSERT_EQ(GroupCommitQueueBase::DefaultBusyTimeout_ms, q.submit([](SampleDB& d) { return d.execScalarQuery<int>("PRAGMA busy_timeout"); }).get());
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, GroupCommit_FailingJobs)
+{
+  auto db = getScenario01();
+  GroupCommitQueue<> q{getSqliteFileName(), 100, std::chrono::seconds{10}};
+
+  // a failing job only rolls back its own changes
+  auto f1 = q.submitBatch({"UPDATE t1 SET i=1 WHERE rowid=1", "UPDATE t1 SET i=2 WHERE rowid=2"});
+  auto f2 = q.submit([](SqliteDatabase& d) {
+    d.execNonQuery("UPDATE t1 SET i=99 WHERE rowid=3");
+    d.execNonQuery("INSERT INTO nonsense VALUES(1)");
+  });
+  auto f3 = q.submitBatch({"UPDATE t1 SET i=3 WHERE rowid=3"});
+
+  // the window would stay open for 10 seconds, but flush() closes it
+  q.flush();
+  f1.get();
+  ASSERT_THROW(f2.get(), SqlStatementCreationError);
+  f3.get();
+  ASSERT_EQ(1 + 2 + 3, db.execScalarQuery<int>("SELECT sum(i) FROM t1 WHERE rowid <= 3"));
+
+  auto st = q.stats();
+  ASSERT_EQ(1, st.nCommits);
+  ASSERT_EQ(2, st.nJobs);
+  ASSERT_EQ(1, st.nFailedJobs);
+  ASSERT_EQ(3, st.maxBatchSize);
+
+  // a job that destroys the shared transaction fails the whole batch
+  auto f4 = q.submitBatch({"UPDATE t1 SET i=4 WHERE rowid=4"});
+  auto f5 = q.submitBatch({"ROLLBACK"});
+  q.flush();
+  ASSERT_THROW(f4.get(), GenericSqliteException);
+  ASSERT_THROW(f5.get(), GenericSqliteException);
+  ASSERT_EQ(84, db.execScalarQuery<int>("SELECT i FROM t1 WHERE rowid=4"));
+  ASSERT_EQ(1, q.stats().nFailedCommits);
+
+  // the queue is still usable
+  q.submitBatch({"UPDATE t1 SET i=4 WHERE rowid=4"});
+  q.flush();
+  ASSERT_EQ(4, db.execScalarQuery<int>("SELECT i FROM t1 WHERE rowid=4"));
+
+  // named callables are copied
+  auto setFive = [](SqliteDatabase& d) { d.execNonQuery("UPDATE t1 SET i=5 WHERE rowid=5"); };
+  const std::function<int(SqliteDatabase&)> readFive = [](SqliteDatabase& d) { return d.execScalarQuery<int>("SELECT i FROM t1 WHERE rowid=5"); };
+  auto f6 = q.submit(setFive);
+  auto f7 = q.submit(readFive);
+  q.flush();
+  f6.get();
+  ASSERT_EQ(5, f7.get());
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, GroupCommit_BatchLimitAndShutdown)
+{
+  auto db = getScenario01();
+
+  std::vector<std::future<void>> futures;
+  {
+    GroupCommitQueue<> q{getSqliteFileName(), 3, std::chrono::seconds{10}};
+    for (int k = 0; k < 7; ++k)
+    {
+      futures.push_back(q.submitBatch({"INSERT INTO t1(i) VALUES(" + std::to_string(k) + ")"}));
+    }
+
+    // the first full batch is committed without waiting for the time window
+    futures[0].get();
+    ASSERT_EQ(3, q.stats().maxBatchSize);
+
+    // the dtor commits the remaining jobs
+  }
+  for (size_t k = 1; k < futures.size(); ++k) futures[k].get();
+  ASSERT_EQ(5 + 7, db.execScalarQuery<int>("SELECT count(*) FROM t1"));
+
+  // a locked database lets the transaction fail
+  OpenOptions oo;
+  oo.busyTimeout_ms = 10;
+  GroupCommitQueue<> q{getSqliteFileName(), 10, std::chrono::milliseconds{1}, OpenMode::OpenExisting_RW, nullptr, oo};
+  auto tr = db.startTransaction(TransactionType::Immediate);
+  auto fBusy = q.submitBatch({"DELETE FROM t1"});
+  ASSERT_THROW(fBusy.get(), BusyException);
+  ASSERT_EQ(1, q.stats().nFailedCommits);
+  tr.commit();
+  q.submitBatch({"DELETE FROM t1"}).get();
+  ASSERT_EQ(0, db.execScalarQuery<int>("SELECT count(*) FROM t1"));
+}
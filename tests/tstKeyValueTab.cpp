@@ -227,3 +227,129 @@ TEST_F(DatabaseTestScenario, KeyValueTab_AllKeys)
   ASSERT_TRUE((ak[0] == "k1") || (ak[1] == "k1"));
   ASSERT_TRUE((ak[0] == "k2") || (ak[1] == "k2"));
 }
+
+//----------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, KeyValueTab_Cache)
+{
+  auto db = getScenario01();
+  auto kvt = db.createNewKeyValueTab("kvt");
+  kvt.set("a", 1);
+  kvt.set("b", "x");
+
+  ASSERT_FALSE(kvt.isCacheEnabled());
+  kvt.enableCache();
+  ASSERT_TRUE(kvt.isCacheEnabled());
+
+  // the first lookup reads from the database, the second one from the cache
+  ASSERT_EQ(1, kvt.get<int>("a"));
+  ASSERT_EQ(1, kvt.get<int>("a"));
+  ASSERT_EQ(1, kvt.get2<int>("a").value());
+  auto st = kvt.cacheStats();
+  ASSERT_EQ(2, st.nHits);
+  ASSERT_EQ(1, st.nMisses);
+
+  // a different type requires a new lookup
+  ASSERT_EQ("1", kvt.get<std::string>("a"));
+  ASSERT_EQ("1", kvt.get<std::string>("a"));
+  ASSERT_EQ(2, kvt.cacheStats().nMisses);
+
+  // negative caching
+  ASSERT_FALSE(kvt.get2<int>("missing").has_value());
+  ASSERT_THROW(kvt.get<int>("missing"), NoDataException);
+  ASSERT_FALSE(kvt.hasKey("missing"));
+  ASSERT_TRUE(kvt.hasKey("b"));
+  st = kvt.cacheStats();
+  ASSERT_EQ(2, st.nNegativeHits);
+  ASSERT_EQ(4, st.nMisses);
+
+  // modifications of other tables don't affect the cache
+  db.execNonQuery("UPDATE t1 SET i=0 WHERE rowid=1");
+  ASSERT_EQ(1, kvt.get<int>("a"));
+  ASSERT_EQ(0, kvt.cacheStats().nInvalidations);
+
+  // local modifications through another instance or plain SQL
+  auto kvt2 = KeyValueTab{&db, "kvt"};
+  kvt2.set("a", 2);
+  ASSERT_EQ(2, kvt.get<int>("a"));
+  ASSERT_EQ(1, kvt.cacheStats().nInvalidations);
+  db.execNonQuery("INSERT INTO kvt (K, V) VALUES('missing', 5)");
+  ASSERT_EQ(5, kvt.get<int>("missing"));
+  ASSERT_TRUE(kvt.hasKey("missing"));
+  kvt.remove("missing");
+  ASSERT_FALSE(kvt.hasKey("missing"));
+
+  // the cache doesn't interfere with user-provided update hooks
+  int nCalls{0};
+  db.setDataChangeNotificationCallback([](void* p, int, const char*, const char*, sqlite3_int64) { ++(*static_cast<int*>(p)); }, &nCalls);
+  kvt2.set("a", 3);
+  ASSERT_EQ(1, nCalls);
+  ASSERT_EQ(3, kvt.get<int>("a"));
+  db.setDataChangeNotificationCallback(nullptr, nullptr);
+
+  // modifications by other connections
+  SampleDB db2{getSqliteFileName(), OpenMode::OpenExisting_RW};
+  db2.execNonQuery("UPDATE kvt SET V=4 WHERE K='a'");
+  ASSERT_EQ(4, kvt.get<int>("a"));
+
+  // with a check interval, we may see outdated values
+  kvt.enableCache(std::chrono::hours{1});
+  ASSERT_EQ(4, kvt.get<int>("a"));
+  db2.execNonQuery("UPDATE kvt SET V=5 WHERE K='a'");
+  ASSERT_EQ(4, kvt.get<int>("a"));
+  kvt.enableCache();
+  ASSERT_EQ(5, kvt.get<int>("a"));
+
+  // local modifications are always detected
+  kvt.enableCache(std::chrono::hours{1});
+  ASSERT_EQ(5, kvt.get<int>("a"));
+  kvt.set("a", 6);
+  ASSERT_EQ(6, kvt.get<int>("a"));
+
+  // failing lookups don't leave outdated entries behind, neither
+  // if the lookup itself fails nor if the check for external changes fails
+  for (const std::string key : {"c", "d"})
+  {
+    kvt.set(key, 7);
+    {
+      SampleDB dbLock{getSqliteFileName(), OpenMode::OpenExisting_RW};
+      dbLock.execNonQuery("BEGIN EXCLUSIVE");
+      ASSERT_THROW(kvt.hasKey(key), BusyException);
+      ASSERT_THROW(kvt.get<int>(key), BusyException);
+      dbLock.execNonQuery("ROLLBACK");
+    }
+    ASSERT_TRUE(kvt.hasKey(key));
+    ASSERT_EQ(7, kvt.get<int>(key));
+    kvt.enableCache();
+  }
+
+  kvt.disableCache();
+  ASSERT_FALSE(kvt.isCacheEnabled());
+  ASSERT_EQ(0, kvt.cacheStats().nMisses);
+  ASSERT_EQ(6, kvt.get<int>("a"));
+}
+
+//----------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, KeyValueTab_TableWriteCounter)
+{
+  auto db = getScenario01();
+
+  auto cnt = db.getTableWriteCounter("T1");
+  ASSERT_EQ(cnt, db.getTableWriteCounter("t1"));
+  ASSERT_EQ(0, cnt->load());
+
+  db.execNonQuery("UPDATE t1 SET i=0 WHERE rowid <= 2");
+  ASSERT_EQ(2, cnt->load());
+  db.execNonQuery("INSERT INTO t2(i) VALUES(1)");
+  ASSERT_EQ(2, cnt->load());
+
+  // the counter coexists with the changelog
+  db.enableChangeLog(true);
+  db.execNonQuery("DELETE FROM t1 WHERE rowid=1");
+  ASSERT_EQ(3, cnt->load());
+  ASSERT_EQ(1, db.getChangeLogLength());
+  db.disableChangeLog(true);
+  db.execNonQuery("DELETE FROM t1 WHERE rowid=2");
+  ASSERT_EQ(4, cnt->load());
+}
@@ -0,0 +1,151 @@
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include "DatabaseTestScenario.h"
+#include "MemoryBudget.h"
+#include "SampleDB.h"
+
+using namespace SqliteOverlay;
+
+TEST_F(DatabaseTestScenario, MemoryBudget_HeapLimits)
+{
+  auto& mgr = MemoryBudgetManager::instance();
+  ASSERT_EQ(&mgr, &MemoryBudgetManager::instance());
+
+  const int64_t prevSoft = mgr.softHeapLimit();
+  const int64_t prevHard = mgr.hardHeapLimit();
+
+  ASSERT_THROW(mgr.setSoftHeapLimit(-1), std::invalid_argument);
+  ASSERT_THROW(mgr.setHardHeapLimit(-1), std::invalid_argument);
+
+  ASSERT_EQ(prevSoft, mgr.setSoftHeapLimit(32 * 1024 * 1024));
+  ASSERT_EQ(32 * 1024 * 1024, mgr.softHeapLimit());
+  ASSERT_EQ(prevHard, mgr.setHardHeapLimit(256 * 1024 * 1024));
+  ASSERT_EQ(256 * 1024 * 1024, mgr.hardHeapLimit());
+
+  // the soft limit can't exceed the hard limit
+  mgr.setSoftHeapLimit(512 * 1024 * 1024);
+  ASSERT_EQ(256 * 1024 * 1024, mgr.softHeapLimit());
+
+  // the database still works
+  auto db = getScenario01();
+  ASSERT_EQ(5, db.execScalarQuery<int>("SELECT count(*) FROM t1"));
+  ASSERT_TRUE(MemoryBudgetManager::memoryUsed() > 0);
+
+  mgr.setHardHeapLimit(prevHard);
+  mgr.setSoftHeapLimit(prevSoft);
+  ASSERT_EQ(prevSoft, mgr.softHeapLimit());
+  ASSERT_EQ(prevHard, mgr.hardHeapLimit());
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, MemoryBudget_Registration)
+{
+  auto& mgr = MemoryBudgetManager::instance();
+  const size_t n0 = mgr.connectionCount();
+
+  auto db1 = getScenario01();
+  {
+    SampleDB db2{getSqliteFileName(), OpenMode::OpenExisting_RW};
+    mgr.registerConnection(db1, "first");
+    mgr.registerConnection(db2, "second");
+    mgr.registerConnection(db1, "primary");   // only updates the label
+    ASSERT_EQ(n0 + 2, mgr.connectionCount());
+    ASSERT_TRUE(mgr.isRegistered(db1));
+    ASSERT_TRUE(mgr.isRegistered(db2));
+
+    auto u = mgr.usage();
+    ASSERT_EQ(n0 + 2, u.size());
+    ASSERT_EQ("primary", u[n0].label);
+    ASSERT_EQ("second", u[n0 + 1].label);
+    ASSERT_EQ(db1.filename(), u[n0].fileName);
+    ASSERT_TRUE(u[n0].stats.schemaUsed > 0);
+  }
+
+  // destroyed connections are unregistered
+  ASSERT_EQ(n0 + 1, mgr.connectionCount());
+
+  // the registration moves along with the connection
+  SampleDB db3{std::move(db1)};
+  ASSERT_FALSE(mgr.isRegistered(db1));
+  ASSERT_TRUE(mgr.isRegistered(db3));
+  ASSERT_EQ(n0 + 1, mgr.connectionCount());
+
+  SampleDB db4{getSqliteFileName(), OpenMode::OpenExisting_RW};
+  mgr.registerConnection(db4, "fourth");
+  ASSERT_EQ(n0 + 2, mgr.connectionCount());
+  db4 = std::move(db3);   // db4's own connection is closed and unregistered
+  ASSERT_TRUE(mgr.isRegistered(db4));
+  ASSERT_FALSE(mgr.isRegistered(db3));
+  ASSERT_EQ(n0 + 1, mgr.connectionCount());
+  ASSERT_EQ("primary", mgr.usage()[n0].label);
+
+  // explicit unregistering and closing
+  mgr.unregisterConnection(db4);
+  mgr.unregisterConnection(db4);   // no effect
+  ASSERT_EQ(n0, mgr.connectionCount());
+  mgr.registerConnection(db4);
+  db4.close();
+  ASSERT_EQ(n0, mgr.connectionCount());
+  ASSERT_THROW(mgr.registerConnection(db4), std::invalid_argument);
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, MemoryBudget_ReleaseMemory)
+{
+  auto& mgr = MemoryBudgetManager::instance();
+
+  auto db = getScenario01();
+  db.enableStatementCache();
+  db.execNonQuery("CREATE TABLE big(x TEXT)");
+  {
+    auto stmt = db.prepStatement("INSERT INTO big VALUES(?)");
+    const std::string payload(1000, 'x');
+    db.execNonQuery("BEGIN");
+    for (int i = 0; i < 500; ++i)
+    {
+      stmt.bind(1, payload);
+      stmt.step();
+      stmt.reset(true);
+    }
+    db.execNonQuery("COMMIT");
+  }
+  ASSERT_EQ(500, db.execScalarQuery<int>("SELECT count(*) FROM big"));
+  const size_t nIdle = db.getStatementCacheStats().nIdle;
+  ASSERT_TRUE(nIdle > 0);
+
+  mgr.registerConnection(db, "big");
+  const int64_t cacheBefore = db.stats().cacheUsed;
+  ASSERT_TRUE(cacheBefore > 0);
+
+  auto res = mgr.releaseMemory();
+  ASSERT_EQ(mgr.connectionCount(), res.nConnections);
+  ASSERT_EQ(nIdle, res.nStatementsFinalized);
+  ASSERT_TRUE(res.bytesReleased() > 0);
+  ASSERT_TRUE(db.stats().cacheUsed < cacheBefore);
+  ASSERT_EQ(0, db.getStatementCacheStats().nIdle);
+
+  // the connection is still usable and the cache refills
+  ASSERT_EQ(500, db.execScalarQuery<int>("SELECT count(*) FROM big"));
+  ASSERT_EQ(1, db.getStatementCacheStats().nIdle);
+
+  // without clearing the statement caches
+  res = mgr.releaseMemory(true, false);
+  ASSERT_EQ(0, res.nStatementsFinalized);
+  ASSERT_EQ(1, db.getStatementCacheStats().nIdle);
+
+  // dirty pages are flushed before being released
+  db.execNonQuery("BEGIN");
+  db.execNonQuery("UPDATE big SET x='y'");
+  db.releaseMemory();
+  db.execNonQuery("COMMIT");
+  ASSERT_EQ(500, db.execScalarQuery<int>("SELECT count(*) FROM big WHERE x='y'"));
+
+  mgr.unregisterConnection(db);
+  db.close();
+  ASSERT_THROW(db.releaseMemory(), std::invalid_argument);
+}
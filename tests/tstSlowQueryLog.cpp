@@ -0,0 +1,161 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "DatabaseTestScenario.h"
+#include "DbTab.h"
+#include "SlowQueryLog.h"
+
+using namespace SqliteOverlay;
+namespace fs = std::filesystem;
+
+namespace
+{
+  std::string readFile(const std::string& fName)
+  {
+    std::ifstream f{fName};
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+  }
+
+  size_t countOccurrences(const std::string& s, const std::string& pattern)
+  {
+    size_t n{0};
+    for (size_t pos = s.find(pattern); pos != std::string::npos; pos = s.find(pattern, pos + 1)) ++n;
+    return n;
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, SlowQueryLog_Basics)
+{
+  auto db = getScenario01();
+
+  SlowQueryLogOptions opts;
+  ASSERT_THROW(SlowQueryLog{opts}, std::invalid_argument);
+
+  opts.fileName = genTestFilePath("slowQueries.log");
+  fs::remove(opts.fileName);
+  auto log = std::make_shared<SlowQueryLog>(opts);
+  ASSERT_THROW(db.enableSlowQueryLog(nullptr, std::chrono::microseconds{0}), std::invalid_argument);
+
+  // a huge threshold: nothing is logged
+  db.enableSlowQueryLog(log, std::chrono::seconds{100});
+  ASSERT_EQ(log, db.getSlowQueryLog());
+  DbTab t1{db, "t1", false};
+  ASSERT_EQ(3, t1.getRowsByColumnValue("i", 84).size());
+  ASSERT_EQ(0, log->entryCount());
+
+  // threshold 0: everything is logged, including
+  // the SQL that DbTab builds internally
+  db.enableSlowQueryLog(log, std::chrono::microseconds{0});
+  ASSERT_EQ(3, t1.getRowsByColumnValue("i", 84).size());
+  ASSERT_EQ(1, t1.getRowsByColumnValue("i", 42).size());
+  ASSERT_EQ(2, log->entryCount());
+
+  std::string content = readFile(opts.fileName);
+  ASSERT_NE(std::string::npos, content.find("sql: SELECT rowid FROM t1 WHERE i=84\n"));
+  ASSERT_NE(std::string::npos, content.find("sql: SELECT rowid FROM t1 WHERE i=42\n"));
+  ASSERT_NE(std::string::npos, content.find("fingerprint: SELECT rowid FROM t1 WHERE i=?\n"));
+  ASSERT_NE(std::string::npos, content.find(" rows=3\n"));
+  ASSERT_NE(std::string::npos, content.find("  SCAN t1\n"));
+
+  // the plan is only captured once per fingerprint
+  ASSERT_EQ(1, countOccurrences(content, "plan:\n"));
+
+  // the plan statement itself is not logged
+  ASSERT_EQ(std::string::npos, content.find("EXPLAIN"));
+
+  // disable
+  db.disableSlowQueryLog();
+  ASSERT_EQ(nullptr, db.getSlowQueryLog());
+  t1.getRowsByColumnValue("i", 84);
+  ASSERT_EQ(2, log->entryCount());
+
+  log.reset();
+  ASSERT_TRUE(fs::remove(opts.fileName));
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, SlowQueryLog_QueryPlan)
+{
+  auto db = getScenario01();
+  db.execNonQuery("CREATE INDEX idx_i ON t1(i)");
+  auto raw = getRawDbHandle();
+
+  const std::string plan = SlowQueryLog::getQueryPlan(raw.get(), "SELECT * FROM t1 WHERE i=?");
+  ASSERT_NE(std::string::npos, plan.find("SEARCH t1 USING INDEX idx_i"));
+
+  const std::string nestedPlan = SlowQueryLog::getQueryPlan(raw.get(), "SELECT * FROM t1 WHERE i IN (SELECT i FROM t2)");
+  ASSERT_NE(std::string::npos, nestedPlan.find("\n    "));   // a second level in the tree
+
+  ASSERT_TRUE(SlowQueryLog::getQueryPlan(raw.get(), "SELECT * FROM nonExisting").empty());
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, SlowQueryLog_Rotation)
+{
+  auto db = getScenario01();
+
+  SlowQueryLogOptions opts;
+  opts.fileName = genTestFilePath("slowQueriesRotated.log");
+  opts.maxFileSize = 500;
+  opts.maxRotatedFiles = 2;
+  opts.captureQueryPlan = false;
+  for (const auto& fn : {opts.fileName, opts.fileName + ".1", opts.fileName + ".2", opts.fileName + ".3"}) fs::remove(fn);
+
+  auto log = std::make_shared<SlowQueryLog>(opts);
+  db.enableSlowQueryLog(log, std::chrono::microseconds{0});
+  for (int i = 0; i < 50; ++i)
+  {
+    db.execScalarQuery<int>("SELECT count(*) FROM t1 WHERE i > " + std::to_string(i));
+  }
+  db.disableSlowQueryLog();
+  ASSERT_EQ(50, log->entryCount());
+  log.reset();
+
+  ASSERT_TRUE(fs::exists(opts.fileName));
+  ASSERT_TRUE(fs::exists(opts.fileName + ".1"));
+  ASSERT_TRUE(fs::exists(opts.fileName + ".2"));
+  ASSERT_FALSE(fs::exists(opts.fileName + ".3"));
+  ASSERT_TRUE(fs::file_size(opts.fileName) <= opts.maxFileSize);
+  ASSERT_EQ(std::string::npos, readFile(opts.fileName).find("plan:"));
+
+  for (const auto& fn : {opts.fileName, opts.fileName + ".1", opts.fileName + ".2"}) ASSERT_TRUE(fs::remove(fn));
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, SlowQueryLog_PlanLimit)
+{
+  auto db = getScenario01();
+
+  SlowQueryLogOptions opts;
+  opts.fileName = genTestFilePath("slowQueriesPlanLimit.log");
+  opts.maxPlanFingerprints = 2;
+  fs::remove(opts.fileName);
+
+  auto log = std::make_shared<SlowQueryLog>(opts);
+  db.enableSlowQueryLog(log, std::chrono::microseconds{0});
+  db.execScalarQuery<int>("SELECT count(*) FROM t1");
+  db.execScalarQuery<int>("SELECT count(*) FROM t2");
+  db.execScalarQuery<int>("SELECT count(*) FROM t1");
+  db.execScalarQuery<int>("SELECT max(i) FROM t1");
+  db.disableSlowQueryLog();
+  ASSERT_EQ(4, log->entryCount());
+  log.reset();
+
+  // only the first two fingerprints get a plan
+  const std::string content = readFile(opts.fileName);
+  ASSERT_EQ(2, countOccurrences(content, "plan:\n"));
+  ASSERT_EQ(std::string::npos, content.find("plan:", content.find("sql: SELECT max(i) FROM t1")));
+
+  ASSERT_TRUE(fs::remove(opts.fileName));
+}
@@ -0,0 +1,337 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "DatabaseTestScenario.h"
+#include "SqlMetrics.h"
+#include "DbTab.h"
+#include "ExampleTableAdapter.h"
+
+using namespace SqliteOverlay;
+
+TEST(SqlMetrics, Normalize)
+{
+  ASSERT_EQ("SELECT * FROM t1 WHERE i=?", SqlMetricsRegistry::normalize("SELECT *  FROM t1\n WHERE i=42"));
+  ASSERT_EQ("SELECT * FROM t1 WHERE i=?", SqlMetricsRegistry::normalize("SELECT * FROM t1 WHERE i=?1"));
+  ASSERT_EQ("SELECT * FROM t1 WHERE i=?", SqlMetricsRegistry::normalize("SELECT * FROM t1 WHERE i=:val;"));
+  ASSERT_EQ("SELECT * FROM t1 WHERE s=? AND f>?", SqlMetricsRegistry::normalize("SELECT * FROM t1 WHERE s='it''s' AND f>1.5e-3"));
+  ASSERT_EQ("SELECT * FROM t1 WHERE i IN (?)", SqlMetricsRegistry::normalize("SELECT * FROM t1 WHERE i IN (1, 2, 3)"));
+  ASSERT_EQ("INSERT INTO t2 (i,s) VALUES (?)", SqlMetricsRegistry::normalize("INSERT INTO t2 (i, s) VALUES (?, ?)"));
+  ASSERT_EQ("INSERT INTO t2 (i) VALUES (?)", SqlMetricsRegistry::normalize("INSERT INTO t2 (i) VALUES (1),(2), (3)"));
+  ASSERT_EQ("SELECT ? FROM \"t 1\" WHERE b=?", SqlMetricsRegistry::normalize("SELECT 0x1F FROM \"t 1\" WHERE b=x'00ff'"));
+
+  // digits in identifiers are kept
+  ASSERT_EQ("SELECT col2 FROM t1", SqlMetricsRegistry::normalize("SELECT col2 FROM t1"));
+}
+
+//----------------------------------------------------------------------------
+
+TEST(SqlMetrics, RegistryBasics)
+{
+  SqlMetricsRegistry reg{2};   // room for only two fingerprints
+  reg.record("SELECT 1", 500, 1);
+  reg.record("SELECT 2", 3000, 1);
+  reg.record("UPDATE t SET a=?", 10000, 5);
+  reg.record("DELETE FROM t", 10, 0);   // dropped, registry is full
+
+  auto snap = reg.snapshot();
+  ASSERT_EQ(2, snap.statements.size());
+  ASSERT_EQ(1, snap.nDropped);
+
+  // sorted by total time
+  const auto& upd = snap.statements[0];
+  ASSERT_EQ("UPDATE t SET a=?", upd.fingerprint);
+  ASSERT_EQ(1, upd.count);
+  ASSERT_EQ(5, upd.nRows);
+
+  const auto& sel = snap.statements[1];
+  ASSERT_EQ("SELECT ?", sel.fingerprint);
+  ASSERT_EQ(2, sel.count);
+  ASSERT_EQ(2, sel.nRows);
+  ASSERT_EQ(3500, sel.totalTime_ns);
+  ASSERT_EQ(500, sel.minTime_ns);
+  ASSERT_EQ(3000, sel.maxTime_ns);
+  ASSERT_EQ(1750.0, sel.avgTime_ns());
+  ASSERT_EQ(1, sel.histogram[0]);   // < 1 µs
+  ASSERT_EQ(1, sel.histogram[2]);   // 2..4 µs
+
+  auto j = snap.toJson();
+  ASSERT_EQ(1, j["dropped"].get<int>());
+  ASSERT_EQ(2, j["statements"].size());
+  ASSERT_EQ("SELECT ?", j["statements"][1]["fingerprint"].get<std::string>());
+  ASSERT_EQ(1, j["statements"][1]["histogram_us"]["4"].get<int>());
+
+  // reset
+  reg.reset();
+  snap = reg.snapshot();
+  ASSERT_TRUE(snap.statements.empty());
+  ASSERT_EQ(0, snap.nDropped);
+
+  // known fingerprints are re-used after a reset
+  reg.record("SELECT 42", 100, 1);
+  snap = reg.snapshot();
+  ASSERT_EQ(1, snap.statements.size());
+  ASSERT_EQ(1, snap.statements[0].count);
+  ASSERT_EQ(100, snap.statements[0].minTime_ns);
+
+  // recording via fingerprint index
+  const size_t fpIdx = reg.fingerprintIndex("SELECT 43");
+  ASSERT_NE(SqlMetricsRegistry::InvalidIndex, fpIdx);
+  ASSERT_EQ(fpIdx, reg.fingerprintIndex("SELECT  1"));
+  reg.record(fpIdx, 200, 1);
+  snap = reg.snapshot();
+  ASSERT_EQ(1, snap.statements.size());
+  ASSERT_EQ(2, snap.statements[0].count);
+  ASSERT_EQ(SqlMetricsRegistry::InvalidIndex, reg.fingerprintIndex("DELETE FROM t"));
+  reg.record(SqlMetricsRegistry::InvalidIndex, 10, 0);
+  ASSERT_EQ(1, reg.snapshot().nDropped);
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, SqlMetrics_Connection)
+{
+  auto db = getScenario01();
+  ASSERT_EQ(nullptr, db.getSqlMetrics());
+
+  auto reg = db.enableSqlMetrics();
+  ASSERT_NE(nullptr, reg);
+  ASSERT_EQ(reg, db.getSqlMetrics());
+
+  for (int id = 1; id <= 5; ++id)
+  {
+    auto stmt = db.prepStatement("SELECT * FROM t1 WHERE rowid=" + std::to_string(id));
+    ASSERT_TRUE(stmt.dataStep());
+  }
+  db.execNonQuery("UPDATE t1 SET i=4711 WHERE i=84");
+  ASSERT_EQ(5, db.execScalarQuery<int>("SELECT count(*) FROM t1"));
+
+  auto snap = reg->snapshot();
+  ASSERT_EQ(3, snap.statements.size());
+  for (const auto& m : snap.statements)
+  {
+    if (m.fingerprint == "SELECT * FROM t1 WHERE rowid=?")
+    {
+      ASSERT_EQ(5, m.count);
+      ASSERT_EQ(5, m.nRows);
+    } else if (m.fingerprint == "UPDATE t1 SET i=? WHERE i=?") {
+      ASSERT_EQ(1, m.count);
+      ASSERT_EQ(3, m.nRows);
+    } else {
+      ASSERT_EQ("SELECT count(*) FROM t1", m.fingerprint);
+      ASSERT_EQ(1, m.count);
+      ASSERT_EQ(1, m.nRows);
+    }
+  }
+
+  // disable
+  db.disableSqlMetrics();
+  ASSERT_EQ(nullptr, db.getSqlMetrics());
+  db.execNonQuery("DELETE FROM t2");
+  ASSERT_EQ(3, reg->snapshot().statements.size());
+
+  // the hooks survive a move
+  db.enableSqlMetrics(reg);
+  SampleDB db2{std::move(db)};
+  db2.execNonQuery("DELETE FROM t2");
+  ASSERT_EQ(4, reg->snapshot().statements.size());
+
+  // rows are counted correctly for many interleaved statements
+  auto reg2 = db2.enableSqlMetrics();
+  std::vector<SqlStatement> stmts;
+  for (int i = 0; i < 20; ++i) stmts.push_back(db2.prepStatement("SELECT i FROM t1 WHERE rowid <= 2"));
+  for (int n = 0; n < 3; ++n)
+  {
+    for (auto& stmt : stmts) stmt.step();
+  }
+  snap = reg2->snapshot();
+  ASSERT_EQ(1, snap.statements.size());
+  ASSERT_EQ(20, snap.statements[0].count);
+  ASSERT_EQ(40, snap.statements[0].nRows);
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, SqlMetrics_SharedRegistry)
+{
+  prepScenario01();
+  auto reg = std::make_shared<SqlMetricsRegistry>();
+
+  constexpr int nThreads = 4;
+  constexpr int nQueries = 200;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < nThreads; ++i)
+  {
+    threads.emplace_back([&]() {
+      SqliteDatabase db{getSqliteFileName(), OpenMode::OpenExisting_RO};
+      db.enableSqlMetrics(reg);
+      for (int n = 0; n < nQueries; ++n)
+      {
+        db.execScalarQuery<int>("SELECT count(*) FROM t1 WHERE i>" + std::to_string(n));
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  auto snap = reg->snapshot();
+  ASSERT_EQ(1, snap.statements.size());
+  ASSERT_EQ(nThreads * nQueries, snap.statements[0].count);
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, SqlMetrics_TraceCallback)
+{
+  auto db = getScenario01();
+
+  std::vector<std::string> log;
+  db.setSqlTraceCallback([&log](std::string_view sql) { log.emplace_back(sql); });
+
+  auto stmt = db.prepStatement("SELECT s FROM t1 WHERE rowid=?");
+  stmt.bind(1, 2);
+  ASSERT_TRUE(stmt.dataStep());
+  ASSERT_EQ(1, log.size());
+  ASSERT_EQ("SELECT s FROM t1 WHERE rowid=2", log[0]);
+
+  db.setSqlTraceCallback(nullptr);
+  db.execNonQuery("DELETE FROM t2");
+  ASSERT_EQ(1, log.size());
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, SqlMetrics_StatementStatus)
+{
+  auto db = getScenario01();
+  auto reg = db.enableSqlMetrics();
+
+  // objectsByColumnValue() without an index on the column
+  ExampleTable t{&db};
+  for (int i = 0; i < 3; ++i)
+  {
+    ASSERT_EQ(3, t.objectsByColumnValue(ExampleTable::Col::intCol, 84).size());
+  }
+
+  // a join that makes SQLite build an automatic index
+  db.execNonQuery("CREATE TABLE t3(a INTEGER, b INTEGER)");
+  db.execNonQuery("CREATE TABLE t4(a INTEGER, c INTEGER)");
+  for (int i = 0; i < 100; ++i)
+  {
+    db.execNonQuery("INSERT INTO t3 VALUES(" + std::to_string(i) + ", 0)");
+    db.execNonQuery("INSERT INTO t4 VALUES(" + std::to_string(i) + ", 0)");
+  }
+  reg->reset();
+  ASSERT_EQ(100, db.execScalarQuery<int>("SELECT count(*) FROM t3, t4 WHERE t3.a=t4.a"));
+
+  // a lookup by rowid is neither a scan nor an auto index
+  ASSERT_TRUE(t.singleObjectById(ExampleId{1}).has_value());
+
+  auto snap = reg->snapshot();
+  ASSERT_EQ(2, snap.statements.size());   // the column query ran before the reset
+  const SqlFingerprintMetrics* join{nullptr};
+  const SqlFingerprintMetrics* byId{nullptr};
+  for (const auto& m : snap.statements)
+  {
+    if (m.fingerprint.find("t3.a=t4.a") != std::string::npos) join = &m;
+    if (m.fingerprint.find("FROM t1 WHERE rowid = ?") != std::string::npos) byId = &m;
+  }
+  ASSERT_NE(nullptr, join);
+  ASSERT_NE(nullptr, byId);
+
+  ASSERT_TRUE(join->status.autoIndexes > 0);
+  ASSERT_EQ(1, join->status.runs);
+  ASSERT_EQ(0, byId->status.fullscanSteps);
+  ASSERT_EQ(0, byId->status.autoIndexes);
+  ASSERT_TRUE(byId->status.vmSteps > 0);
+
+  // run the column query again, this time with counters
+  for (int i = 0; i < 3; ++i)
+  {
+    ASSERT_EQ(3, t.objectsByColumnValue(ExampleTable::Col::intCol, 84).size());
+  }
+  snap = reg->snapshot();
+  auto candidates = snap.missingIndexCandidates();
+  ASSERT_EQ(2, candidates.size());
+  for (const auto* m : candidates)
+  {
+    ASSERT_TRUE((m->fingerprint.find("FROM t1 WHERE i=?") != std::string::npos) || (m->fingerprint.find("t3.a=t4.a") != std::string::npos));
+    if (m->fingerprint.find("FROM t1") != std::string::npos)
+    {
+      ASSERT_EQ(3 * 4, m->status.fullscanSteps);
+      ASSERT_EQ(3, m->status.runs);
+    }
+  }
+
+  // after creating an index, the query doesn't scan anymore
+  db.execNonQuery("CREATE INDEX idx_i ON t1(i)");
+  reg->reset();
+  ASSERT_EQ(3, t.objectsByColumnValue(ExampleTable::Col::intCol, 84).size());
+  snap = reg->snapshot();
+  ASSERT_TRUE(snap.missingIndexCandidates().empty());
+
+  // the registry doesn't consume the counters of the statement
+  // and only records the increments of each run
+  reg->reset();
+  auto stmt = db.prepStatement("SELECT count(*) FROM t3 WHERE b=0");
+  for (int i = 0; i < 2; ++i)
+  {
+    stmt.reset(true);
+    ASSERT_TRUE(stmt.dataStep());
+    ASSERT_EQ(100, stmt.get<int>(0));
+    stmt.step();
+    ASSERT_TRUE(stmt.isDone());
+  }
+  const StatementStatus st = stmt.getStatus();
+  ASSERT_EQ(2, st.runs);
+  ASSERT_EQ(2 * 99, st.fullscanSteps);
+  snap = reg->snapshot();
+  ASSERT_EQ(1, snap.statements.size());
+  ASSERT_EQ(2, snap.statements[0].status.runs);
+  ASSERT_EQ(st.fullscanSteps, snap.statements[0].status.fullscanSteps);
+  ASSERT_EQ(st.vmSteps, snap.statements[0].status.vmSteps);
+
+  // JSON export
+  auto js = reg->snapshot().toJson();
+  ASSERT_TRUE(js["statements"][0].contains("vm_steps"));
+  ASSERT_TRUE(js["statements"][0].contains("fullscan_steps"));
+}
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, SqlMetrics_VmStepBudgets)
+{
+  auto db = getScenario01();
+  ExampleTable t{&db};
+
+  const auto byId = countVmSteps(db, [&]() { t.singleObjectById(ExampleId{3}); });
+  const auto byCol = countVmSteps(db, [&]() { t.objectsByColumnValue(ExampleTable::Col::intCol, 84); });
+  const auto all = countVmSteps(db, [&]() { t.allObj(); });
+  const auto count = countVmSteps(db, [&]() { t.objCount(); });
+
+  // the budgets are the values measured with SQLite 3.40 plus some
+  // headroom for other SQLite versions; exceeding them indicates a
+  // regression, e.g., a lost index or an additional query per call
+  ASSERT_LE(byId, 20);
+  ASSERT_LE(byCol, 60);
+  ASSERT_LE(all, 60);
+  ASSERT_LE(count, 15);
+
+  // a lookup by ID must be cheaper than a scan
+  ASSERT_LT(byId, byCol);
+
+  // VM steps are deterministic
+  ASSERT_EQ(byId, countVmSteps(db, [&]() { t.singleObjectById(ExampleId{3}); }));
+  ASSERT_EQ(byCol, countVmSteps(db, [&]() { t.objectsByColumnValue(ExampleTable::Col::intCol, 84); }));
+
+  // an index turns the scan into a search
+  db.execNonQuery("CREATE INDEX idx_i ON t1(i)");
+  ASSERT_LE(countVmSteps(db, [&]() { t.objectsByColumnValue(ExampleTable::Col::intCol, 42); }), 20);
+
+  // a previously enabled registry is restored
+  auto reg = db.enableSqlMetrics();
+  countVmSteps(db, [&]() { t.objCount(); });
+  ASSERT_EQ(reg, db.getSqlMetrics());
+  ASSERT_TRUE(reg->snapshot().statements.empty());
+}
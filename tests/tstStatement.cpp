@@ -94,6 +94,70 @@ TEST_F(DatabaseTestScenario, StmtBind)
 
 //----------------------------------------------------------------
 
+TEST_F(DatabaseTestScenario, StmtBindWithoutCopy)
+{
+  auto db = SqliteDatabase();
+  db.execNonQuery("CREATE TABLE t1(s TEXT, b BLOB)");
+
+  // static binds
+  const string s{"static text"};
+  const char* cs = "c-string";
+  const string_view sv{"a view"};
+  Sloppy::MemArray blob{3};
+  blob.to_charPtr()[0] = 'x';
+  blob.to_charPtr()[1] = 'y';
+  blob.to_charPtr()[2] = 'z';
+
+  auto stmt = db.prepStatement("INSERT INTO t1(s, b) VALUES(?, ?)");
+  stmt.bindStatic(1, s);
+  stmt.bindStatic(2, blob.view());
+  ASSERT_EQ("INSERT INTO t1(s, b) VALUES('static text', x'78797a')", stmt.getExpandedSQL());
+  stmt.step();
+  stmt.reset(true);
+  stmt.bindStatic(1, cs);
+  stmt.bindStatic(2, blob.to_voidPtr(), 2);
+  stmt.step();
+  stmt.reset(true);
+  stmt.bindStatic(1, sv);
+  stmt.bindNull(2);
+  stmt.step();
+
+  // ownership transfer of a long string (no SSO) and a blob
+  string longText(1000, 'L');
+  stmt.reset(true);
+  stmt.bind(1, std::move(longText));
+  stmt.bind(2, std::move(blob));
+
+  // the statement holds the original buffer, even after moving the statement
+  SqlStatement stmt2 = std::move(stmt);
+  stmt2.step();
+
+  // re-binding an owned placeholder releases the old value
+  stmt2.reset(false);
+  stmt2.bind(1, string{"short"});
+  stmt2.step();
+
+  stmt = db.prepStatement("SELECT s, length(b) FROM t1 ORDER BY rowid");
+  ASSERT_TRUE(stmt.dataStep());
+  ASSERT_EQ("static text", stmt.get<string>(0));
+  ASSERT_EQ(3, stmt.get<int>(1));
+  ASSERT_TRUE(stmt.dataStep());
+  ASSERT_EQ("c-string", stmt.get<string>(0));
+  ASSERT_EQ(2, stmt.get<int>(1));
+  ASSERT_TRUE(stmt.dataStep());
+  ASSERT_EQ("a view", stmt.get<string>(0));
+  ASSERT_TRUE(stmt.isNull(1));
+  ASSERT_TRUE(stmt.dataStep());
+  ASSERT_EQ(string(1000, 'L'), stmt.get<string>(0));
+  ASSERT_EQ(3, stmt.get<int>(1));
+  ASSERT_TRUE(stmt.dataStep());
+  ASSERT_EQ("short", stmt.get<string>(0));
+  ASSERT_EQ(3, stmt.get<int>(1));
+  ASSERT_FALSE(stmt.dataStep());
+}
+
+//----------------------------------------------------------------
+
 TEST_F(DatabaseTestScenario, StmtStep)
 {
   prepScenario01();
@@ -427,6 +491,62 @@ TEST_F(DatabaseTestScenario, TemplateGetter)
 
 //----------------------------------------------------------------
 
+TEST_F(DatabaseTestScenario, ZeroCopyGetters)
+{
+  SqliteDatabase db{}; // empty in-memory database
+  db.execNonQuery("CREATE TABLE t1(s TEXT, b BLOB)");
+  db.execNonQuery("INSERT INTO t1(s, b) VALUES('Hallo', x'00010203')");
+  db.execNonQuery("INSERT INTO t1(s, b) VALUES('', x'')");
+  db.execNonQuery("INSERT INTO t1(s, b) VALUES(NULL, NULL)");
+  db.execNonQuery("INSERT INTO t1(s, b) VALUES('a' || char(0) || 'b', 42)");
+
+  auto stmt = db.prepStatement("SELECT s, b FROM t1 ORDER BY rowid");
+
+  // regular values
+  ASSERT_TRUE(stmt.dataStep());
+  auto gen = stmt.rowGeneration();
+  std::string_view sv = stmt.get<std::string_view>(0);
+  ASSERT_EQ("Hallo", sv);
+  Sloppy::MemView mv = stmt.get<Sloppy::MemView>(1);
+  ASSERT_EQ(4, mv.byteSize());
+  ASSERT_EQ(3, mv.to_charPtr()[3]);
+  ASSERT_NO_THROW(stmt.assertRowGeneration(gen));
+
+  // views in tuples
+  auto [sv2, mv2] = stmt.tupleGet<std::string_view, Sloppy::MemView>(0, 1);
+  ASSERT_EQ(sv, sv2);
+  ASSERT_EQ(mv.to_charPtr(), mv2.to_charPtr());
+
+  // empty values
+  ASSERT_TRUE(stmt.dataStep());
+  ASSERT_NE(gen, stmt.rowGeneration());
+#ifndef NDEBUG
+  ASSERT_THROW(stmt.assertRowGeneration(gen), std::logic_error);
+#endif
+  ASSERT_TRUE(stmt.get<std::string_view>(0).empty());
+  ASSERT_EQ(0, stmt.get<Sloppy::MemView>(1).byteSize());
+
+  // NULL values
+  ASSERT_TRUE(stmt.dataStep());
+  ASSERT_THROW(stmt.get<std::string_view>(0), NullValueException);
+  ASSERT_FALSE(stmt.get2<Sloppy::MemView>(1).has_value());
+
+  // the length is taken from SQLite, not from strlen(); numbers are converted
+  ASSERT_TRUE(stmt.dataStep());
+  ASSERT_EQ(3, stmt.get<std::string_view>(0).size());
+  ASSERT_EQ(3, stmt.get<std::string>(0).size());
+  ASSERT_EQ("42", stmt.get<std::string_view>(1));
+
+  // finalizing invalidates the views, too
+  gen = stmt.rowGeneration();
+  stmt.forceFinalize();
+#ifndef NDEBUG
+  ASSERT_THROW(stmt.assertRowGeneration(gen), std::logic_error);
+#endif
+}
+
+//----------------------------------------------------------------
+
 TEST_F(DatabaseTestScenario, TemplateGetterOptional)
 {
   SqliteDatabase db{}; // empty in-memory database
@@ -526,3 +646,54 @@ TEST_F(DatabaseTestScenario, ExportCSV2)
   ASSERT_FALSE(csv.hasHeaders());   // no data rows ==> no headers, even if requested!
   ASSERT_TRUE(stmt.isDone());
 }
+
+//----------------------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, StmtStatus)
+{
+  prepScenario01();
+  auto db = getRawDbHandle();
+
+  // no index on "i" --> full table scan
+  SqlStatement stmt{db.get(), "SELECT rowid FROM t1 WHERE i=84"};
+  StatementStatus st = stmt.getStatus();
+  ASSERT_EQ(0, st.vmSteps);
+  ASSERT_EQ(0, st.runs);
+
+  int nRows{0};
+  while (stmt.dataStep()) ++nRows;
+  ASSERT_EQ(3, nRows);
+  st = stmt.getStatus();
+  ASSERT_EQ(4, st.fullscanSteps);   // five rows, the first one doesn't count as "step"
+  ASSERT_EQ(0, st.sorts);
+  ASSERT_EQ(0, st.autoIndexes);
+  ASSERT_TRUE(st.vmSteps > 0);
+  ASSERT_EQ(1, st.runs);
+  ASSERT_TRUE(st.memUsed > 0);
+
+  // a second run accumulates
+  stmt.reset(false);
+  while (stmt.dataStep()) {}
+  StatementStatus st2 = stmt.getStatus(true);
+  ASSERT_EQ(2 * st.fullscanSteps, st2.fullscanSteps);
+  ASSERT_EQ(2 * st.vmSteps, st2.vmSteps);
+  ASSERT_EQ(2, st2.runs);
+
+  // reset
+  st = stmt.getStatus();
+  ASSERT_EQ(0, st.fullscanSteps);
+  ASSERT_EQ(0, st.vmSteps);
+  ASSERT_EQ(0, st.runs);
+
+  // sorting
+  stmt = SqlStatement{db.get(), "SELECT s FROM t1 ORDER BY s"};
+  while (stmt.dataStep()) {}
+  ASSERT_EQ(1, stmt.getStatus().sorts);
+
+  // aggregation
+  st += stmt.getStatus();
+  st += stmt.getStatus();
+  ASSERT_EQ(2, st.sorts);
+  ASSERT_EQ(2, st.runs);
+  ASSERT_EQ(stmt.getStatus().memUsed, st.memUsed);
+}
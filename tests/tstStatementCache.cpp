@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include "DatabaseTestScenario.h"
+#include "SampleDB.h"
+#include "SqlStatement.h"
+#include "StatementCache.h"
+
+using namespace SqliteOverlay;
+
+
+TEST_F(DatabaseTestScenario, StmtCache_HitsAndMisses)
+{
+  auto db = getScenario01();
+
+  // disabled by default
+  ASSERT_FALSE(db.isStatementCacheEnabled());
+  auto stmt = db.prepStatement("SELECT i FROM t1 WHERE rowid=?");
+  ASSERT_FALSE(stmt.isCached());
+  stmt.forceFinalize();
+  ASSERT_EQ(0, db.getStatementCacheStats().misses);
+
+  db.enableStatementCache(10);
+  ASSERT_TRUE(db.isStatementCacheEnabled());
+
+  // first request is a miss
+  stmt = db.prepStatement("SELECT i FROM t1 WHERE rowid=?");
+  ASSERT_TRUE(stmt.isCached());
+  stmt.bind(1, 1);
+  ASSERT_EQ(42, db.execScalarQuery<int>(stmt));
+  auto st = db.getStatementCacheStats();
+  ASSERT_EQ(0, st.hits);
+  ASSERT_EQ(1, st.misses);
+  ASSERT_EQ(0, st.nIdle);
+
+  // return the statement to the cache
+  stmt.forceFinalize();
+  ASSERT_EQ(1, db.getStatementCacheStats().nIdle);
+
+  // second request is a hit and the
+  // statement is reset and unbound
+  stmt = db.prepStatement("SELECT i FROM t1 WHERE rowid=?");
+  ASSERT_EQ("SELECT i FROM t1 WHERE rowid=NULL", stmt.getExpandedSQL());
+  stmt.bind(1, 1);
+  ASSERT_EQ(42, db.execScalarQuery<int>(stmt));
+  st = db.getStatementCacheStats();
+  ASSERT_EQ(1, st.hits);
+  ASSERT_EQ(1, st.misses);
+  ASSERT_EQ(0, st.nIdle);
+
+  // a second lease on the same SQL text while the first one
+  // is still active yields a fresh statement
+  auto stmt2 = db.prepStatement("SELECT i FROM t1 WHERE rowid=?");
+  ASSERT_EQ(2, db.getStatementCacheStats().misses);
+
+  // both statements go back into the cache
+  stmt.forceFinalize();
+  stmt2.forceFinalize();
+  ASSERT_EQ(2, db.getStatementCacheStats().nIdle);
+
+  // existing callers pick up the cache transparently
+  db.resetStatementCacheStats();
+  ASSERT_TRUE(db.hasTable("t1"));
+  ASSERT_TRUE(db.hasTable("t2"));
+  st = db.getStatementCacheStats();
+  ASSERT_EQ(1, st.hits);
+  ASSERT_EQ(1, st.misses);
+
+  // statements that outlive the cache are simply finalized
+  stmt = db.prepStatement("SELECT i FROM t1 WHERE rowid=?");
+  db.disableStatementCache();
+  ASSERT_FALSE(db.isStatementCacheEnabled());
+  stmt.forceFinalize();
+  ASSERT_EQ(0, db.getStatementCacheStats().nIdle);
+
+  // idle statements do not prevent closing the database
+  db.enableStatementCache();
+  db.execScalarQuery<int>("SELECT COUNT(*) FROM t1");
+  ASSERT_EQ(1, db.getStatementCacheStats().nIdle);
+  ASSERT_NO_THROW(db.close());
+  ASSERT_FALSE(db.isStatementCacheEnabled());
+}
+
+//----------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, StmtCache_Eviction)
+{
+  auto db = getScenario01();
+  db.enableStatementCache(2);
+
+  db.execScalarQuery<int>("SELECT COUNT(*) FROM t1");
+  db.execScalarQuery<int>("SELECT COUNT(*) FROM t2");
+  db.execScalarQuery<int>("SELECT MAX(rowid) FROM t1");
+  auto st = db.getStatementCacheStats();
+  ASSERT_EQ(2, st.nIdle);
+  ASSERT_EQ(1, st.evictions);
+
+  // the least recently used statement has been evicted
+  db.resetStatementCacheStats();
+  db.execScalarQuery<int>("SELECT MAX(rowid) FROM t1");
+  db.execScalarQuery<int>("SELECT COUNT(*) FROM t1");
+  st = db.getStatementCacheStats();
+  ASSERT_EQ(1, st.hits);
+  ASSERT_EQ(1, st.misses);
+
+  // shrinking the cache evicts idle statements
+  db.enableStatementCache(0);
+  st = db.getStatementCacheStats();
+  ASSERT_EQ(0, st.nIdle);
+  ASSERT_EQ(3, st.evictions);
+
+  // statements that failed because of a schema change are not cached
+  db.enableStatementCache(10);
+  db.execNonQuery("CREATE TABLE tmp (x INTEGER)");
+  db.execScalarQuery<int>("SELECT COUNT(*) FROM tmp");
+  db.execNonQuery("DROP TABLE tmp");
+  db.resetStatementCacheStats();
+  auto nIdleBefore = db.getStatementCacheStats().nIdle;
+  ASSERT_THROW(db.execScalarQuery<int>("SELECT COUNT(*) FROM tmp"), GenericSqliteException);
+  st = db.getStatementCacheStats();
+  ASSERT_EQ(1, st.hits);
+  ASSERT_EQ(1, st.evictions);
+  ASSERT_EQ(nIdleBefore - 1, st.nIdle);
+
+  // invalid SQL is reported as before
+  ASSERT_THROW(db.prepStatement("SELECT sdkfjsdlkf FROM xyz"), SqlStatementCreationError);
+  ASSERT_THROW(db.prepStatement(""), std::invalid_argument);
+}
@@ -384,3 +384,115 @@ TEST_F(DatabaseTestScenario, TabRow_CSV)
   csv = r.toCSV(vector<string>{});
   ASSERT_EQ(0, csv.size());
 }
+
+//----------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, TabRow_Snapshot)
+{
+  auto db = getScenario01();
+
+  TabRow r(db, "t1", 1);
+  auto snap = r.snapshot();
+  ASSERT_EQ(1, snap.id());
+  ASSERT_EQ(4, snap.nColumns());
+  ASSERT_EQ("i", snap.columnNames()[0]);
+  ASSERT_EQ("d", snap.columnNames()[3]);
+
+  // typed getters
+  ASSERT_EQ(42, snap.get<int>("i"));
+  ASSERT_EQ(42, snap.get<int64_t>("I"));  // column names are case-insensitive
+  ASSERT_EQ(23.23, snap.get<double>("f"));
+  ASSERT_EQ("Hallo", snap["s"]);
+  ASSERT_EQ("Hallo", snap.get2<std::string>("s").value());
+  ASSERT_EQ(ColumnDataType::Integer, snap.getColDataType("i"));
+  ASSERT_EQ(ColumnDataType::Float, snap.getColDataType("f"));
+  ASSERT_EQ(ColumnDataType::Text, snap.getColDataType("s"));
+
+  // conversions between types
+  ASSERT_EQ("42", snap.get<std::string>("i"));
+  ASSERT_EQ("23.23", snap.get<std::string>("f"));
+  ASSERT_EQ(23, snap.get<int>("f"));
+  ASSERT_EQ(42.0, snap.get<double>("i"));
+  ASSERT_TRUE(snap.get<bool>("i"));
+
+  // invalid column names
+  ASSERT_THROW(snap.get<int>("skjfh"), std::invalid_argument);
+  ASSERT_THROW(snap["skjfh"], std::invalid_argument);
+  ASSERT_THROW(snap.get2<int>("skjfh"), std::invalid_argument);
+  ASSERT_THROW(snap.get<int>(""), std::invalid_argument);
+
+  // the snapshot is not affected by later modifications...
+  r.update("i", 20160807);
+  r.updateToNull("s");
+  ASSERT_EQ(42, snap.get<int>("i"));
+  ASSERT_EQ("Hallo", snap["s"]);
+
+  // ... until it is refreshed
+  snap.refresh();
+  ASSERT_EQ(date::year_month_day{date::year{2016} / 8 / 7}, snap.get<date::year_month_day>("i"));
+  ASSERT_TRUE(snap.isNull("s"));
+  ASSERT_FALSE(snap.get2<std::string>("s").has_value());
+  ASSERT_THROW(snap["s"], NullValueException);
+
+  // JSON and blob data
+  nlohmann::json jsonIn = nlohmann::json::parse(R"({"a": "abc", "b": 42})");
+  r.update("s", jsonIn);
+  Sloppy::MemArray blob{100};
+  for (size_t idx = 0; idx < 100; ++idx) blob.to_charPtr()[idx] = static_cast<char>(idx);
+  r.update("d", blob.view());
+  snap = r.snapshot();
+  ASSERT_EQ(42, snap.get<nlohmann::json>("s")["b"]);
+  ASSERT_EQ(ColumnDataType::Blob, snap.getColDataType("d"));
+  auto blobBack = snap.get<Sloppy::MemArray>("d");
+  ASSERT_EQ(100, blobBack.byteSize());
+  ASSERT_EQ(99, blobBack.to_charPtr()[99]);
+
+  // renamed columns are picked up even if the number of columns is unchanged
+  db.execNonQuery("ALTER TABLE t1 RENAME COLUMN s TO s2");
+  snap.refresh();
+  ASSERT_EQ(42, snap.get<nlohmann::json>("s2")["b"]);
+  ASSERT_THROW(snap["s"], std::invalid_argument);
+  db.execNonQuery("ALTER TABLE t1 RENAME COLUMN s2 TO s");
+
+  // NULL columns
+  snap = TabRow(db, "t1", 2).snapshot();
+  ASSERT_FALSE(snap.get2<int>("i").has_value());
+  ASSERT_THROW(snap.get<int>("i"), NullValueException);
+
+  // deleted rows
+  r.erase();
+  ASSERT_THROW(r.snapshot(), NoDataException);
+  ASSERT_THROW(RowSnapshot(db, "t1", 1), NoDataException);
+  ASSERT_THROW(RowSnapshot(db, "sdfsdf", 2), std::invalid_argument);
+}
+
+//----------------------------------------------------------------
+
+TEST_F(DatabaseTestScenario, TabRow_SharedStatements)
+{
+  auto db = getScenario01();
+  db.enableStatementCache();
+
+  // all rows of the same table share the
+  // same statement for the same column
+  for (int id = 1; id <= 5; ++id)
+  {
+    TabRow r(db, "t1", id, true);
+    r.get2<int>("i");
+  }
+  auto st = db.getStatementCacheStats();
+  ASSERT_EQ(1, st.misses);
+  ASSERT_EQ(4, st.hits);
+
+  // updates are shared, too, and still hit the right row
+  db.resetStatementCacheStats();
+  TabRow r1(db, "t1", 1, true);
+  TabRow r3(db, "t1", 3, true);
+  r1.update("i", 1001);
+  r3.update("i", 1003);
+  ASSERT_EQ(1001, r1.get<int>("i"));
+  ASSERT_EQ(1003, r3.get<int>("i"));
+  ASSERT_EQ(84, TabRow(db, "t1", 4).get<int>("i"));
+  st = db.getStatementCacheStats();
+  ASSERT_EQ(2, st.misses);   // the first update and the row ID check in the ctor
+}